@@ -0,0 +1,113 @@
+/*
+ * Audio pipeline shared by the I2S player and host tools
+ * A WAV reader that decodes to mono 16-bit PCM, a two-buffer ping-pong
+ * handed between a feeder (storage side) and a player (DMA side), and a
+ * WAV writer for host sinks. No Arduino dependencies: storage and output
+ * are reached through callbacks so the same code runs against SD and I2S
+ * on the device and against files on a host.
+ */
+
+#ifndef AUDIO_PIPELINE_H
+#define AUDIO_PIPELINE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+#define WAV_FORMAT_PCM 0x0001
+#define WAV_FORMAT_IMA_ADPCM 0x0011   // Mono only, blocks up to AUDIO_READ_CHUNK bytes
+
+static_assert(AUDIO_BUFFER_SAMPLES >= (AUDIO_READ_CHUNK - 4) * 2 + 1, "A ping-pong buffer must hold a whole ADPCM block");
+
+typedef size_t (*AudioReadFn)(uint8_t* buffer, size_t length, void* context);
+typedef size_t (*AudioWriteFn)(const uint8_t* data, size_t length, void* context);
+
+struct AudioFormat {
+  uint16_t encoding;        // WAV_FORMAT_*
+  uint16_t channels;
+  uint32_t sampleRate;
+  uint16_t bitsPerSample;
+  uint16_t blockAlign;
+  uint16_t samplesPerBlock; // IMA-ADPCM only
+  uint32_t dataBytes;       // Size of the data chunk
+};
+
+// Reads a WAV file sequentially; the source is left at the first data byte
+struct AudioStream {
+  AudioFormat format;
+  AudioReadFn read;
+  void* context;
+  uint32_t remaining;       // Data bytes not yet read
+  uint8_t raw[AUDIO_READ_CHUNK];
+};
+
+bool audioStreamOpen(AudioStream& stream, AudioReadFn read, void* context);
+// Decodes up to maxSamples mono samples; 0 when the data chunk is done or
+// (ADPCM) when fewer than samplesPerBlock samples fit
+size_t audioStreamRead(AudioStream& stream, int16_t* out, size_t maxSamples);
+bool audioStreamEnded(const AudioStream& stream);
+// One mono IMA-ADPCM block (4-byte header + nibbles); returns samples written
+size_t adpcmDecodeBlock(const uint8_t* block, size_t blockBytes, int16_t* out);
+const char* audioFormatName(uint16_t encoding);
+
+// Header for a 16-bit mono WAV; dataBytes may be patched in later
+void wavWriteHeader(AudioWriteFn write, void* context, uint32_t sampleRate, uint32_t dataBytes);
+
+// Two sample buffers passed between one filling and one playing task.
+// Each side owns a buffer until it flips its flag; the flags are the only
+// shared state, published with release/acquire like SpscQueue.
+class AudioPingPong {
+public:
+  void reset() {
+    for (int i = 0; i < 2; i++) {
+      lengths_[i] = 0;
+      last_[i] = false;
+      full_[i].store(false, std::memory_order_relaxed);
+    }
+    fillIndex_ = 0;
+    playIndex_ = 0;
+  }
+
+  // Feeder: the next empty buffer, or nullptr while both are queued
+  int16_t* acquireFill() {
+    return full_[fillIndex_].load(std::memory_order_acquire) ? nullptr : buffers_[fillIndex_];
+  }
+
+  // Feeder: hands the buffer to the player; `last` marks the end of the stream
+  void commitFill(size_t samples, bool last) {
+    lengths_[fillIndex_] = samples;
+    last_[fillIndex_] = last;
+    full_[fillIndex_].store(true, std::memory_order_release);
+    fillIndex_ ^= 1;
+  }
+
+  // Player: the next full buffer, or nullptr if the feeder is behind.
+  // The player may convert samples in place until it releases the buffer.
+  int16_t* acquirePlay(size_t& samples, bool& last) {
+    if (!full_[playIndex_].load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    samples = lengths_[playIndex_];
+    last = last_[playIndex_];
+    return buffers_[playIndex_];
+  }
+
+  // Player: returns the buffer to the feeder
+  void releasePlay() {
+    full_[playIndex_].store(false, std::memory_order_release);
+    playIndex_ ^= 1;
+  }
+
+  static constexpr size_t capacity() { return AUDIO_BUFFER_SAMPLES; }
+
+private:
+  int16_t buffers_[2][AUDIO_BUFFER_SAMPLES];
+  size_t lengths_[2] = {0, 0};
+  bool last_[2] = {false, false};
+  std::atomic<bool> full_[2] = {{false}, {false}};
+  uint8_t fillIndex_ = 0;   // Feeder only
+  uint8_t playIndex_ = 0;   // Player only
+};
+
+#endif // AUDIO_PIPELINE_H
@@ -0,0 +1,190 @@
+/*
+ * Bulk schedule upload protocol (Bluetooth SPP)
+ * After the "upload" command the link carries binary frames until the
+ * session ends. Every frame is an 8-byte header, the payload and a CRC32
+ * over both, so text that loop() prints meanwhile, or bytes lost when the
+ * Bluetooth receive queue overflows, are skipped instead of stored.
+ *
+ *   host                                   device
+ *   BEGIN   session id, chunk count  ->
+ *                                    <-    READY  resume chunk, window
+ *   DATA    seq n (city, zone, records) ->
+ *                                    <-    ACK    next expected seq, window end
+ *                                    <-    NAK    next expected seq (go back)
+ *   END     seq = chunk count        ->
+ *                                    <-    DONE   BulkUploadStats
+ *
+ * DATA is go-back-N: the device takes chunks in order only and the host
+ * may send up to the window end the last ACK allowed, which grows as the
+ * storage task empties the chunk queue. Records are idempotent, so a
+ * resumed session simply restarts at the READY resume chunk.
+ * Kept free of Arduino dependencies so host tools share the layouts.
+ */
+
+#ifndef BULK_PROTOCOL_H
+#define BULK_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "cache_format.h"
+
+#define BULK_FRAME_MAGIC 0x5542            // "BU" on the wire
+#define BULK_PROTOCOL_VERSION 1
+#define BULK_CHUNK_RECORDS 32              // Records per DATA frame, ~0.8 KB: one SPP packet
+#define BULK_NAME_LENGTH 32                // City and zone names in a chunk
+#define BULK_MAX_PAYLOAD (4 + 2 * BULK_NAME_LENGTH + BULK_CHUNK_RECORDS * sizeof(DaySchedule))
+
+enum BulkFrameType : uint8_t {
+  BULK_BEGIN = 1,
+  BULK_READY,
+  BULK_DATA,
+  BULK_ACK,
+  BULK_NAK,
+  BULK_END,
+  BULK_DONE,
+  BULK_ABORT
+};
+
+struct BulkFrameHeader {
+  uint16_t magic;
+  uint8_t type;          // BulkFrameType
+  uint8_t flags;         // Reserved, 0
+  uint16_t sequence;     // DATA: chunk index; ACK/NAK: next chunk expected
+  uint16_t length;       // Payload bytes, followed by a CRC32 of header and payload
+};
+
+struct BulkBegin {
+  uint32_t sessionId;    // Chosen by the host; the same upload keeps the same id
+  uint16_t version;
+  uint16_t chunkCount;
+};
+
+struct BulkReady {
+  uint32_t sessionId;
+  uint16_t resumeChunk;  // First chunk not yet stored for this session
+  uint16_t windowEnd;    // Chunks below this may be sent
+  uint16_t chunkRecords; // Most records the device takes per chunk
+  uint16_t reserved;
+};
+
+// ACK and NAK payload; the header sequence is the next chunk expected
+struct BulkAck {
+  uint16_t windowEnd;
+  uint16_t storedChunks;
+};
+
+// DATA payload: this header, then the city and zone names (no terminator),
+// then recordCount DaySchedule records with their own CRCs
+struct BulkChunkHeader {
+  uint8_t cityLength;
+  uint8_t zoneLength;
+  uint8_t recordCount;
+  uint8_t reserved;
+};
+
+struct BulkUploadStats {
+  uint32_t records;      // Received in valid chunks
+  uint32_t stored;       // Written to SD or the flash tier
+  uint32_t unchanged;    // Already cached with the same content
+  uint32_t skipped;      // Nowhere to keep them (no SD card, other city)
+  uint32_t rejected;     // Record CRC or date invalid
+  uint32_t crcErrors;    // Frames dropped for a bad CRC or length
+  uint32_t outOfOrder;   // DATA past a gap, dropped for go-back-N
+  uint32_t duplicates;   // DATA already received (host retransmits)
+  uint32_t bytes;        // Frame bytes received
+  uint32_t elapsedMs;
+};
+
+static_assert(sizeof(BulkFrameHeader) == 8 && sizeof(BulkReady) == 12 && sizeof(BulkUploadStats) == 40,
+              "Bulk frame layouts are part of the protocol");
+
+inline uint32_t bulkFrameCrc(const BulkFrameHeader& header, const uint8_t* payload) {
+  uint32_t crc = cacheCrc32(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+  return cacheCrc32(payload, header.length, crc);
+}
+
+// Builds a complete frame in `out` (sizeof(BulkFrameHeader) + length + 4 bytes); returns its size
+inline size_t encodeBulkFrame(uint8_t* out, uint8_t type, uint16_t sequence, const void* payload,
+                              uint16_t length) {
+  BulkFrameHeader header = {BULK_FRAME_MAGIC, type, 0, sequence, length};
+  memcpy(out, &header, sizeof(header));
+  if (length > 0) {
+    memcpy(out + sizeof(header), payload, length);
+  }
+  uint32_t crc = bulkFrameCrc(header, out + sizeof(header));
+  memcpy(out + sizeof(header) + length, &crc, sizeof(crc));
+  return sizeof(header) + length + sizeof(crc);
+}
+
+// Reassembles frames from a byte stream. Bytes before a magic, frames with
+// an impossible length and frames failing the CRC are dropped and counted.
+class BulkFrameParser {
+public:
+  enum Result { NEED_MORE, FRAME, BAD_FRAME };
+
+  // Consumes bytes up to the end of at most one frame; `used` says how many
+  Result feed(const uint8_t* data, size_t length, size_t& used) {
+    used = 0;
+    while (used < length) {
+      uint8_t byte = data[used++];
+      if (fill_ < 2) {
+        // Magic is little endian: 'B' then 'U'
+        if (byte == magicByte(fill_)) {
+          buffer_[fill_++] = byte;
+        } else {
+          skippedBytes_++;
+          fill_ = byte == magicByte(0) ? 1 : 0;
+          buffer_[0] = byte;
+        }
+        continue;
+      }
+      buffer_[fill_++] = byte;
+      if (fill_ == sizeof(BulkFrameHeader) && header().length > BULK_MAX_PAYLOAD) {
+        fill_ = 0;
+        return BAD_FRAME;
+      }
+      if (fill_ >= sizeof(BulkFrameHeader) && fill_ == frameSize()) {
+        fill_ = 0;
+        uint32_t crc;
+        memcpy(&crc, buffer_ + sizeof(BulkFrameHeader) + header().length, sizeof(crc));
+        return crc == bulkFrameCrc(header(), payload()) ? FRAME : BAD_FRAME;
+      }
+    }
+    return NEED_MORE;
+  }
+
+  // Drops a partial frame (the rest of it was lost)
+  void reset() { fill_ = 0; }
+  bool partial() const { return fill_ > 0; }
+
+  // Valid after feed() returned FRAME, until the next feed()
+  const BulkFrameHeader& header() const { return *reinterpret_cast<const BulkFrameHeader*>(buffer_); }
+  const uint8_t* payload() const { return buffer_ + sizeof(BulkFrameHeader); }
+  uint32_t skippedBytes() const { return skippedBytes_; }
+
+private:
+  static uint8_t magicByte(size_t index) { return index == 0 ? BULK_FRAME_MAGIC & 0xFF : BULK_FRAME_MAGIC >> 8; }
+  size_t frameSize() const { return sizeof(BulkFrameHeader) + header().length + sizeof(uint32_t); }
+
+  alignas(4) uint8_t buffer_[sizeof(BulkFrameHeader) + BULK_MAX_PAYLOAD + sizeof(uint32_t)];
+  size_t fill_ = 0;
+  uint32_t skippedBytes_ = 0;
+};
+
+// Record file written by tools/schedule_gen.cpp --records and sent by
+// tools/bt_upload.py: this header, then `count` DaySchedule records
+#define BULK_RECORD_FILE_MAGIC 0x52444A53UL  // "SJDR"
+#define BULK_RECORD_FILE_VERSION 1
+
+struct BulkRecordFileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t count;
+  char city[BULK_NAME_LENGTH];
+  char zone[BULK_NAME_LENGTH];
+};
+
+static_assert(sizeof(BulkRecordFileHeader) == 72, "Record file layout is shared with the host tools");
+
+#endif // BULK_PROTOCOL_H
@@ -0,0 +1,130 @@
+/*
+ * Buzzer patterns as constexpr step tables
+ * Each pattern is a short list of steps (duration, tone, optional loop)
+ * written with beep()/rest() and .repeat(). The compiler checks every table
+ * and works out its length, so nothing is computed while a pattern plays:
+ * the player in buzzer_manager.cpp arms a one-shot timer for the end of
+ * each step, so steps shorter than a loop() pass (chirp's 80 ms) play as
+ * written. A step is 6 bytes of flash; the prayer time pattern is two steps.
+ */
+
+#ifndef BUZZER_PATTERNS_H
+#define BUZZER_PATTERNS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+struct BuzzerStep {
+  uint16_t durationMs;
+  uint16_t toneHz;      // 0 = silent; active buzzers sound any non-zero tone
+  uint8_t loopSteps;    // Set on the last step of a loop: steps in the body
+  uint8_t loopRepeats;  // Extra passes through the body after the first
+
+  // Ends a loop: the last `bodySteps` steps (this one included) play `passes` times
+  constexpr BuzzerStep repeat(uint8_t bodySteps, uint8_t passes) const {
+    return {durationMs, toneHz, bodySteps, (uint8_t)(passes - 1)};
+  }
+};
+
+constexpr BuzzerStep beep(uint16_t durationMs, uint16_t toneHz = BUZZER_TONE_HZ) {
+  return {durationMs, toneHz, 0, 0};
+}
+
+constexpr BuzzerStep rest(uint16_t durationMs) {
+  return {durationMs, 0, 0, 0};
+}
+
+// Loops must fit inside the table and may not nest (the player keeps one counter)
+constexpr bool buzzerStepsValid(const BuzzerStep* steps, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (steps[i].loopSteps == 0) {
+      continue;
+    }
+    if (steps[i].loopSteps > i + 1) {
+      return false;
+    }
+    for (size_t j = i + 1 - steps[i].loopSteps; j < i; j++) {
+      if (steps[j].loopSteps != 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+constexpr uint32_t buzzerStepsDuration(const BuzzerStep* steps, size_t count) {
+  uint32_t total = 0;
+  for (size_t i = 0; i < count; i++) {
+    total += steps[i].durationMs;
+    if (steps[i].loopSteps != 0) {
+      uint32_t body = 0;
+      for (size_t j = i + 1 - steps[i].loopSteps; j <= i; j++) {
+        body += steps[j].durationMs;
+      }
+      total += body * steps[i].loopRepeats;
+    }
+  }
+  return total;
+}
+
+struct BuzzerPattern {
+  const char* name;
+  const BuzzerStep* steps;
+  uint8_t stepCount;
+  bool valid;
+  uint32_t durationMs;
+};
+
+template <size_t N>
+constexpr BuzzerPattern buzzerPattern(const char* name, const BuzzerStep (&steps)[N]) {
+  return {name, steps, (uint8_t)N, buzzerStepsValid(steps, N), buzzerStepsDuration(steps, N)};
+}
+
+// Stored in DeviceSettings by number: append new patterns, never reorder
+enum BuzzerPatternId : uint8_t {
+  BUZZER_PATTERN_PULSE,     // Prayer time default
+  BUZZER_PATTERN_LONG,      // Warning default
+  BUZZER_PATTERN_ALARM,
+  BUZZER_PATTERN_CHIRP,
+  BUZZER_PATTERN_RISING,
+  BUZZER_PATTERN_SILENT,
+  BUZZER_PATTERN_COUNT
+};
+
+inline constexpr BuzzerStep pulseSteps[] = {beep(500), rest(500).repeat(2, 10)};
+inline constexpr BuzzerStep longSteps[] = {beep(1000)};
+inline constexpr BuzzerStep alarmSteps[] = {beep(100), rest(100).repeat(2, 25)};
+inline constexpr BuzzerStep chirpSteps[] = {
+  beep(80), rest(80), beep(80), rest(80), beep(80), rest(600).repeat(6, 8)
+};
+inline constexpr BuzzerStep risingSteps[] = {
+  beep(300, 880), beep(300, 1175), beep(300, 1568), rest(400).repeat(4, 6)
+};
+inline constexpr BuzzerStep silentSteps[] = {rest(0)};
+
+inline constexpr BuzzerPattern buzzerPatterns[BUZZER_PATTERN_COUNT] = {
+  buzzerPattern("pulse", pulseSteps),
+  buzzerPattern("long", longSteps),
+  buzzerPattern("alarm", alarmSteps),
+  buzzerPattern("chirp", chirpSteps),
+  buzzerPattern("rising", risingSteps),
+  buzzerPattern("silent", silentSteps),
+};
+
+constexpr bool buzzerPatternsValid() {
+  for (const BuzzerPattern& pattern : buzzerPatterns) {
+    if (!pattern.valid || pattern.stepCount == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(buzzerPatternsValid(), "Buzzer pattern loop out of range or nested");
+static_assert(buzzerPatterns[BUZZER_PATTERN_PULSE].durationMs == PRAYER_ALERT_DURATION, "Prayer time pattern length");
+static_assert(buzzerPatterns[BUZZER_PATTERN_LONG].durationMs == WARNING_BUZZ_DURATION, "Warning pattern length");
+static_assert(buzzerPatterns[BUZZER_PATTERN_ALARM].durationMs == 5000, "Alarm pattern length");
+static_assert(sizeof(BuzzerStep) == 6, "Steps are packed into 6 bytes");
+
+#endif // BUZZER_PATTERNS_H
@@ -0,0 +1,153 @@
+/*
+ * Cache Format Header for ESP32 Prayer Times Controller
+ * On-storage layouts shared by the firmware cache code. Kept free of
+ * Arduino dependencies so the formats stay plain data.
+ */
+
+#ifndef CACHE_FORMAT_H
+#define CACHE_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "civil_date.h"
+
+// Cache manifest: one file per city and year, /<city>/<yyyy>/manifest.bin
+#define CACHE_MANIFEST_MAGIC 0x4D434A53UL  // "SJCM"
+#define CACHE_MANIFEST_VERSION 1
+#define CACHE_MANIFEST_FILE "manifest.bin"
+#define CACHE_DAYS_PER_YEAR 366
+
+struct CacheManifest {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t year;
+  uint16_t monthDirs;                      // bit (month - 1) set once /city/yyyy/mm exists
+  uint16_t cachedDays;                     // number of bits set in dayBits
+  uint8_t dayBits[(CACHE_DAYS_PER_YEAR + 7) / 8];
+  uint8_t reserved[2];
+  uint32_t checksums[CACHE_DAYS_PER_YEAR]; // CRC32 of each day file, 0 = unknown
+  uint32_t crc;                            // CRC32 over all fields above
+};
+
+// CRC32 (IEEE 802.3, reflected), nibble table to keep flash usage small
+inline uint32_t cacheCrc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+  static const uint32_t nibbleTable[16] = {
+    0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL,
+    0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+    0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL,
+    0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+  };
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ nibbleTable[crc & 0x0F];
+    crc = (crc >> 4) ^ nibbleTable[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+// Cache file trailer: "\n#SJ1:<length hex>:<crc32 hex>\n" appended after the body.
+// A file whose trailer is missing or does not match was cut short mid-write.
+#define CACHE_TRAILER_LENGTH 24
+#define CACHE_TEMP_SUFFIX ".tmp"
+
+inline void formatCacheTrailer(char* out, uint32_t length, uint32_t crc) {
+  snprintf(out, CACHE_TRAILER_LENGTH + 1, "\n#SJ1:%08lX:%08lX\n",
+           (unsigned long)length, (unsigned long)crc);
+}
+
+inline bool parseHex32(const char* text, uint32_t& value) {
+  value = 0;
+  for (int i = 0; i < 8; i++) {
+    char c = text[i];
+    uint32_t digit;
+    if (c >= '0' && c <= '9') digit = c - '0';
+    else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+    else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+    else return false;
+    value = (value << 4) | digit;
+  }
+  return true;
+}
+
+// Parses a trailer located at the last CACHE_TRAILER_LENGTH bytes of a file
+inline bool parseCacheTrailer(const char* trailer, uint32_t& length, uint32_t& crc) {
+  if (trailer[0] != '\n' || trailer[1] != '#' || trailer[2] != 'S' || trailer[3] != 'J' ||
+      trailer[4] != '1' || trailer[5] != ':' || trailer[14] != ':' || trailer[23] != '\n') {
+    return false;
+  }
+  return parseHex32(trailer + 6, length) && parseHex32(trailer + 15, crc);
+}
+
+// Compact day schedule used by the flash tier: prayer times as minutes
+// after local midnight, keyed by day number
+enum PrayerIndex {
+  PRAYER_FAJR,
+  PRAYER_SUNRISE,
+  PRAYER_DHUHR,
+  PRAYER_ASR,
+  PRAYER_MAGHRIB,
+  PRAYER_ISHA,
+  PRAYER_COUNT
+};
+
+struct DaySchedule {
+  int32_t dayNumber;                // daysFromCivil(), 0 = empty slot
+  uint16_t minutes[PRAYER_COUNT];
+  int16_t utcOffsetMinutes;
+  uint16_t reserved;
+  uint32_t crc;                     // CRC32 over all fields above
+};
+
+inline const char* schedulePrayerName(int index) {
+  static const char* const names[PRAYER_COUNT] = {"Fajr", "Sunrise", "Dhuhr", "Asr", "Maghrib", "Isha"};
+  return (index >= 0 && index < PRAYER_COUNT) ? names[index] : "";
+}
+
+inline uint32_t dayScheduleCrc(const DaySchedule& schedule) {
+  return cacheCrc32(reinterpret_cast<const uint8_t*>(&schedule), offsetof(DaySchedule, crc));
+}
+
+// SD day file body for a record that did not come from the API: the same
+// fields, order and compact form savePrayerTimesToSD() keeps from a response
+#define DAY_JSON_IMSAK_MINUTES 10  // Before Fajr, as the API reports it
+#define DAY_JSON_LENGTH 320
+
+inline size_t formatDayScheduleJson(char* out, size_t size, const DaySchedule& schedule, const char* zone) {
+  static const char* const months[12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                         "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+  char clock[PRAYER_COUNT + 1][6];
+  for (int i = 0; i <= PRAYER_COUNT; i++) {
+    int minutes = i < PRAYER_COUNT ? schedule.minutes[i] : schedule.minutes[PRAYER_FAJR] - DAY_JSON_IMSAK_MINUTES;
+    minutes = ((minutes % 1440) + 1440) % 1440;
+    snprintf(clock[i], sizeof(clock[i]), "%02d:%02d", minutes / 60, minutes % 60);
+  }
+  CivilDate date = civilFromDays(schedule.dayNumber);
+  int length = snprintf(out, size,
+      "{\"code\":200,\"status\":\"OK\",\"data\":{\"timings\":{\"Fajr\":\"%s\",\"Sunrise\":\"%s\","
+      "\"Dhuhr\":\"%s\",\"Asr\":\"%s\",\"Sunset\":\"%s\",\"Maghrib\":\"%s\",\"Isha\":\"%s\",\"Imsak\":\"%s\"},"
+      "\"date\":{\"readable\":\"%02d %s %04d\",\"timestamp\":\"%lld\"},\"meta\":{\"timezone\":\"%s\"}}}",
+      clock[PRAYER_FAJR], clock[PRAYER_SUNRISE], clock[PRAYER_DHUHR], clock[PRAYER_ASR], clock[PRAYER_MAGHRIB],
+      clock[PRAYER_MAGHRIB], clock[PRAYER_ISHA], clock[PRAYER_COUNT], date.day, months[date.month - 1], date.year,
+      (long long)schedule.dayNumber * 86400, zone);
+  return length > 0 && (size_t)length < size ? (size_t)length : 0;
+}
+
+// Flash tier file: header followed by FLASH_TIER_SLOTS records, slot = dayNumber % slots
+#define FLASH_TIER_MAGIC 0x54464A53UL  // "SJFT"
+#define FLASH_TIER_VERSION 1
+#define FLASH_TIER_SLOTS 64
+
+struct FlashTierHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t slotCount;
+  char city[32];
+};
+
+inline uint32_t cacheManifestCrc(const CacheManifest& manifest) {
+  return cacheCrc32(reinterpret_cast<const uint8_t*>(&manifest), offsetof(CacheManifest, crc));
+}
+
+#endif // CACHE_FORMAT_H
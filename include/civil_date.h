@@ -0,0 +1,138 @@
+/*
+ * Civil Calendar Header for ESP32 Prayer Times Controller
+ * Integer date type with constexpr day arithmetic and the single formatter
+ * for cache paths and API date keys. No allocation, no Arduino dependencies.
+ */
+
+#ifndef CIVIL_DATE_H
+#define CIVIL_DATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct CivilDate {
+  int16_t year;
+  uint8_t month;
+  uint8_t day;
+
+  constexpr bool operator==(const CivilDate& other) const {
+    return year == other.year && month == other.month && day == other.day;
+  }
+  constexpr bool operator!=(const CivilDate& other) const {
+    return !(*this == other);
+  }
+};
+
+constexpr bool isLeapYear(int year) {
+  return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+}
+
+constexpr int daysInMonth(int year, int month) {
+  return month == 2 ? (isLeapYear(year) ? 29 : 28)
+                    : ((month == 4 || month == 6 || month == 9 || month == 11) ? 30 : 31);
+}
+
+constexpr bool isValidDate(const CivilDate& date) {
+  return date.year >= 2000 && date.year <= 2099 && date.month >= 1 && date.month <= 12 &&
+         date.day >= 1 && date.day <= daysInMonth(date.year, date.month);
+}
+
+// Days since 1970-01-01 (proleptic Gregorian)
+constexpr int32_t daysFromCivil(int year, int month, int day) {
+  year -= month <= 2;
+  const int32_t era = (year >= 0 ? year : year - 399) / 400;
+  const uint32_t yearOfEra = static_cast<uint32_t>(year - era * 400);
+  const uint32_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  const uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + static_cast<int32_t>(dayOfEra) - 719468;
+}
+
+constexpr int32_t daysFromCivil(const CivilDate& date) {
+  return daysFromCivil(date.year, date.month, date.day);
+}
+
+constexpr CivilDate civilFromDays(int32_t days) {
+  days += 719468;
+  const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const uint32_t dayOfEra = static_cast<uint32_t>(days - era * 146097);
+  const uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  const uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const uint32_t monthPrime = (5 * dayOfYear + 2) / 153;
+  const uint32_t day = dayOfYear - (153 * monthPrime + 2) / 5 + 1;
+  const uint32_t month = monthPrime < 10 ? monthPrime + 3 : monthPrime - 9;
+  const int32_t year = static_cast<int32_t>(yearOfEra) + era * 400 + (month <= 2);
+  return CivilDate{static_cast<int16_t>(year), static_cast<uint8_t>(month), static_cast<uint8_t>(day)};
+}
+
+constexpr CivilDate addDays(const CivilDate& date, int32_t days) {
+  return civilFromDays(daysFromCivil(date) + days);
+}
+
+// Zero-based day of year, used as the manifest bit index
+constexpr int dayOfYearIndex(const CivilDate& date) {
+  return daysFromCivil(date) - daysFromCivil(date.year, 1, 1);
+}
+
+static_assert(daysFromCivil(1970, 1, 1) == 0, "epoch");
+static_assert(civilFromDays(daysFromCivil(2024, 2, 29)) == CivilDate{2024, 2, 29}, "leap day round trip");
+static_assert(addDays(CivilDate{2025, 12, 31}, 1) == CivilDate{2026, 1, 1}, "year rollover");
+static_assert(dayOfYearIndex(CivilDate{2024, 12, 31}) == 365, "leap year length");
+
+// Date key shared by API URLs and cache file names: "dd-mm-yyyy"
+#define DATE_KEY_LENGTH 10
+
+inline void formatDateKey(const CivilDate& date, char* out) {
+  out[0] = '0' + date.day / 10;
+  out[1] = '0' + date.day % 10;
+  out[2] = '-';
+  out[3] = '0' + date.month / 10;
+  out[4] = '0' + date.month % 10;
+  out[5] = '-';
+  out[6] = '0' + date.year / 1000;
+  out[7] = '0' + (date.year / 100) % 10;
+  out[8] = '0' + (date.year / 10) % 10;
+  out[9] = '0' + date.year % 10;
+  out[DATE_KEY_LENGTH] = '\0';
+}
+
+inline bool parseDateKey(const char* text, CivilDate& date) {
+  for (int i = 0; i < DATE_KEY_LENGTH; i++) {
+    bool separator = (i == 2 || i == 5);
+    if (separator ? text[i] != '-' : (text[i] < '0' || text[i] > '9')) {
+      return false;
+    }
+  }
+  date.day = (text[0] - '0') * 10 + (text[1] - '0');
+  date.month = (text[3] - '0') * 10 + (text[4] - '0');
+  date.year = (text[6] - '0') * 1000 + (text[7] - '0') * 100 + (text[8] - '0') * 10 + (text[9] - '0');
+  return isValidDate(date);
+}
+
+// Cache file path: "/<city>/yyyy/mm/dd-mm-yyyy.json"; returns length, 0 if it does not fit
+inline size_t formatCachePath(char* out, size_t size, const char* city, const CivilDate& date) {
+  size_t cityLength = 0;
+  while (city[cityLength]) cityLength++;
+  const size_t length = 1 + cityLength + 9 + DATE_KEY_LENGTH + 5;
+  if (length + 1 > size) {
+    return 0;
+  }
+
+  char* p = out;
+  *p++ = '/';
+  for (size_t i = 0; i < cityLength; i++) *p++ = city[i];
+  char key[DATE_KEY_LENGTH + 1];
+  formatDateKey(date, key);
+  *p++ = '/';
+  for (int i = 6; i < 10; i++) *p++ = key[i];   // yyyy
+  *p++ = '/';
+  *p++ = key[3];                                // mm
+  *p++ = key[4];
+  *p++ = '/';
+  for (int i = 0; i < DATE_KEY_LENGTH; i++) *p++ = key[i];
+  const char* extension = ".json";
+  while (*extension) *p++ = *extension++;
+  *p = '\0';
+  return length;
+}
+
+#endif // CIVIL_DATE_H
@@ -34,8 +34,21 @@
 #define NTP_TIMEOUT 15000
 #define NTP_SYNC_ATTEMPTS 15
 
-// API Configuration
-#define ALADHAN_API_BASE "http://api.aladhan.com/v1/timingsByCity"
+// API Configuration (host and port can be overridden with build flags, e.g. for a mock server)
+#ifndef ALADHAN_API_HOST
+#define ALADHAN_API_HOST "api.aladhan.com"
+#endif
+#ifndef ALADHAN_API_PORT
+#define ALADHAN_API_PORT 80
+#endif
+#define ALADHAN_API_PATH "/v1/timingsByCity"
+#define API_DNS_TTL 3600000          // Reuse the resolved address for 1 hour
+#define API_PIPELINE_DEPTH 4         // Requests in flight on the keep-alive connection
+#define API_RETRY_LIMIT 2            // Reconnects per batch after a dropped connection
+#define API_BATCH_SIZE 8             // Request paths built per pipelined batch
+#define API_REQUEST_INTERVAL 1000    // Minimum ms between request starts (API rate limit)
+#define API_LATENCY_SAMPLES 64       // Recent latencies kept for percentiles
+#define API_GZIP_ENABLED true        // Ask for gzip bodies, inflated while they arrive
 #define PRAYER_METHOD 20  // Kemenag Indonesia
 #define DEFAULT_CITY "Nganjuk"
 #define DEFAULT_COUNTRY "Indonesia"
@@ -46,7 +59,57 @@
 #define SD_MOUNT_POINT "/sd"
 #define PRAYER_DATA_DIR "/prayer_times"
 #define MAX_FILE_SIZE 8192
+#define CACHE_PATH_LENGTH 64        // "/<city>/yyyy/mm/dd-mm-yyyy.json"
 #define PRAYER_CACHE_DAYS 7
+#define CACHE_MANIFEST_SLOTS 2      // City/year manifests kept in RAM
+
+// Flash Cache Configuration (LittleFS on the spare data partition)
+#define FLASH_CACHE_HORIZON_DAYS 60 // Days ahead kept in flash (slots: FLASH_TIER_SLOTS)
+
+// Cache Prefetcher Configuration
+#define PREFETCH_HORIZON_DAYS 30       // Days ahead of today kept cached
+#define PREFETCH_BATCH_DAYS 4          // Days per pipelined batch
+#define PREFETCH_SPACING 5000          // Gap between batches (API rate limit)
+#define PREFETCH_MIN_RSSI -75          // Weaker signal waits for a better moment
+#define PREFETCH_CHECK_INTERVAL 10000  // Recheck while WiFi or signal is missing
+#define PREFETCH_IDLE_INTERVAL 60000   // Recheck once the horizon is full
+#define PREFETCH_BACKOFF_BASE 5000     // First retry delay, doubled per failure
+#define PREFETCH_BACKOFF_MAX 600000
+#define PREFETCH_BREAKER_FAILURES 5    // Consecutive failed batches that open the breaker
+#define PREFETCH_BREAKER_COOLDOWN 1800000
+#define PREFETCH_STACK 8192            // HTTP batch, JSON parse and cache writes
+#define PREFETCH_PRIORITY 1            // Below everything on core 0 but idle
+
+// Settings Configuration (NVS)
+#define SETTINGS_KEY "settings"
+#define SETTINGS_VERSION 2           // 2: per-prayer buzzer patterns
+#define SETTINGS_SAVE_DELAY 5000     // Debounce before committing changes
+#define SETTINGS_DIRTY_WIFI 0x01
+#define SETTINGS_DIRTY_LOCATION 0x02
+#define SETTINGS_DIRTY_SYSTEM 0x04
+#define SETTINGS_DIRTY_ALERTS 0x08
+#define SETTINGS_DIRTY_ALL 0xFF
+
+// Warm Boot Configuration (RTC slow memory)
+#define WARM_BOOT_MAGIC 0x57425331   // "WBS1"
+#define WARM_BOOT_VERSION 1
+#define WARM_BOOT_DAYS 2             // Today and tomorrow
+
+// Active Schedule Configuration (alert path)
+#define ACTIVE_SCHEDULE_PREPARE_INTERVAL 30000  // Check that tomorrow is loaded
+#define ACTIVE_SCHEDULE_READ_ATTEMPTS 4         // Lock-free read retries before giving up
+#define COUNTDOWN_MAX_STEP 120                  // Seconds between ticks before the countdown resyncs
+
+// Boot Sequence Configuration
+#define BOOT_STORAGE_STACK 6144      // SD + flash mount task
+#define BOOT_NETWORK_STACK 8192      // WiFi, NTP and first fetch task (HTTP + JSON)
+
+// Load Test Configuration (esp32dev-mock environment only)
+#define LOAD_TEST_CITY "LoadTest"    // Scratch city so real cache entries are untouched
+#define LOAD_TEST_ROUNDS 5
+
+// Event Queue Configuration
+#define SYSTEM_EVENT_QUEUE_SIZE 16   // Slots per queue (power of two, one kept free)
 
 // Debug Configuration
 #define DEBUG_ENABLED true
@@ -75,6 +138,21 @@
 #define BLUETOOTH_NAME "Jadwal sholat"
 #define BT_PIN "1234"
 #define COMMAND_TIMEOUT 30000
+#define BT_WINDOW_MINUTES 10         // Idle time before Bluetooth is torn down
+#define BT_TRIGGER_PIN 0             // BOOT button, active low
+#define BT_TRIGGER_HOLD_MS 1000      // Long press that reopens the window
+
+// Bulk Upload Configuration (binary schedule transfer over SerialBT, see bulk_protocol.h)
+#define BULK_QUEUE_CHUNKS 8          // Chunk queue slots (power of two, one kept free): the send window
+#define BULK_READER_STACK 4096
+#define BULK_STORE_STACK 6144        // JSON body, SD and LittleFS writes
+#define BULK_READER_PRIORITY 3       // Drains the SPP receive queue before it overflows
+#define BULK_STORE_PRIORITY 1
+#define BULK_TASK_CORE 0             // Off the loop() core
+#define BULK_FRAME_TIMEOUT 200       // Partial frame given up (bytes lost), ms
+#define BULK_IDLE_TIMEOUT 15000      // Silent link ends the session; it can be resumed
+#define BULK_RESUME_EVERY 16         // Stored chunks between NVS resume points
+#define BULK_RESUME_KEY "bulk_resume"
 
 // WiFi Auto-reconnect Settings
 #define AUTO_RECONNECT_ENABLED true
@@ -93,14 +171,46 @@
 // Display Configuration
 #define DISPLAY_UPDATE_INTERVAL 1000  // Update every second
 #define DISPLAY_ENABLED true
+#define DISPLAY_I2C_ADDRESS 0x3C      // SSD1306, shares the bus with the RTC
+#define DISPLAY_I2C_CLOCK 400000      // Fast mode; the DS3231 supports it too
+#define DISPLAY_I2C_CHUNK 32          // GDDRAM bytes per I2C transaction (Wire buffer is 128)
+#define DISPLAY_ALERT_DURATION 10000  // Prayer time banner, flashing
+#define DISPLAY_WARNING_DURATION 5000 // Warning banner, steady
+#define DISPLAY_ALERT_FRAME_INTERVAL 100  // Alert animation tick
+#define DISPLAY_ALERT_FLASH_PERIOD 500    // Half period of the inverted flash
+#define RENDER_BENCH_ITERATIONS 1000     // Default for the 'renderbench' command
+#define DISPLAY_TEST_STEP 1500        // Time on each menu 11 test screen
 
 // Buzzer Configuration
 #define BUZZER_PIN 23  // GPIO pin for buzzer
+#define BUZZER_PASSIVE false        // true: drive pattern tones with LEDC, false: pin high/low
+#define BUZZER_TONE_HZ 2700         // beep() default, near a typical piezo's resonance
+#define BUZZER_LEDC_CHANNEL 4       // Passive buzzer only
+#define BUZZER_TEST_GAP 1000        // Pause between patterns in the self-test
+#define BUZZER_EDGE_TOLERANCE_US 2000  // Self-test limit: step timer dispatch latency, with margin
 #define BUZZER_CHECK_INTERVAL 1000  // Check every second
 #define PRAYER_WARNING_MINUTES 10   // Warning before prayer time
 #define PRAYER_ALERT_DURATION 10000 // 10 seconds on-off pattern
 #define WARNING_BUZZ_DURATION 1000  // 1 second continuous buzz
 
+// Audio Configuration (adhan playback from SD)
+#define AUDIO_ENABLED true
+#define ADHAN_AUDIO_PATH "/audio/adhan.wav"  // PCM or IMA-ADPCM WAV; buzzer pattern when missing
+#define AUDIO_USE_INTERNAL_DAC false  // true: GPIO25 DAC, false: external I2S amp
+#define AUDIO_I2S_BCLK_PIN 26
+#define AUDIO_I2S_LRCK_PIN 25
+#define AUDIO_I2S_DOUT_PIN 33
+#define AUDIO_BUFFER_SAMPLES 2048     // Per ping-pong buffer, 128 ms at 16 kHz
+#define AUDIO_READ_CHUNK 1024         // Bytes per storage read
+#define AUDIO_DMA_BUFFERS 8           // I2S driver DMA descriptors
+#define AUDIO_DMA_BUFFER_LEN 256      // Samples per DMA descriptor
+#define AUDIO_FEEDER_STACK 4096
+#define AUDIO_OUTPUT_STACK 3072
+#define AUDIO_FEEDER_PRIORITY 2       // Above the boot network task
+#define AUDIO_OUTPUT_PRIORITY 5       // Keeps the DMA ring topped up
+#define AUDIO_TASK_CORE 0             // Off the loop() core
+#define AUDIO_BENCH_BLOCKS 200        // Default for the 'audiobench' command
+
 // Error Codes
 #define ERROR_WIFI_CONNECTION -1
 #define ERROR_API_REQUEST -2
@@ -108,6 +218,9 @@
 #define ERROR_SD_CARD -4
 #define ERROR_RTC_INIT -5
 #define ERROR_NTP_SYNC -6
+#define API_ERROR_CONNECTION -7      // Not connected, or response cut short
+#define API_ERROR_TOO_LARGE -8       // Body larger than MAX_FILE_SIZE
+#define API_ERROR_DECODE -9          // Corrupt or truncated gzip body
 
 // Success Codes
 #define SUCCESS 0
@@ -0,0 +1,43 @@
+/*
+ * Display layouts for the 128x64 panel
+ * The screens the display manager shows, drawn from plain values into the
+ * framebuffer. All drawing is opaque (see framebuffer.h), so redrawing a
+ * screen only dirties what changed. No Arduino dependencies, so
+ * tools/display_golden.cpp renders the same screens on a host and compares
+ * them with checked-in images.
+ */
+
+#ifndef DISPLAY_LAYOUTS_H
+#define DISPLAY_LAYOUTS_H
+
+// Clock face, redrawn every second by displayCurrentInfo()
+struct ClockScreen {
+  const char* topLine;      // "18/10/2026 GMT+7"
+  const char* clock;        // "HH:MM" in large digits
+  const char* seconds;      // "SS" beside the minutes
+  const char* city;
+  const char* nextLine;     // "Asr in 00:42:13"
+  const char* statusLine;   // "WiFi:on BT:-- SD:ok"
+};
+
+struct StatusScreen {
+  bool wifiConnected;
+  bool rtcOk;
+  bool sdOk;
+  bool panelPresent;
+};
+
+// One opaque text line: the rest of the page row is filled so stale text goes away
+void drawTextLine(int page, int x, const char* text, int scale = 1, bool invert = false);
+void drawCenteredText(int page, const char* text, int scale = 1, bool invert = false);
+
+void drawClockScreen(const ClockScreen& screen);
+
+// Alert banner: static parts once, then the countdown and bar every frame.
+// Panel inversion for the flash is a controller command, not frame content.
+void drawAlertScreen(const char* banner, const char* detail);
+void drawAlertProgress(unsigned long elapsed, unsigned long duration);
+
+void drawStatusScreen(const StatusScreen& status);
+
+#endif // DISPLAY_LAYOUTS_H
@@ -0,0 +1,45 @@
+/*
+ * 1-bpp framebuffer for the 128x64 SSD1306-class panel
+ * Page-major layout matching the controller's GDDRAM: byte (page, x) holds
+ * pixels x, page*8 .. page*8+7 with bit 0 on top. Every byte write is
+ * compared with the current value and only real changes widen that page's
+ * dirty column range, so redrawing an unchanged frame flushes nothing.
+ * Draw opaquely (text cells include their background) instead of clearing
+ * first, or the cleared bytes count as changes. No Arduino dependencies,
+ * so frames can be rendered and dumped to PBM on a host.
+ */
+
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+#define FRAMEBUFFER_PAGES (DISPLAY_HEIGHT / 8)
+#define FRAMEBUFFER_SIZE (DISPLAY_WIDTH * FRAMEBUFFER_PAGES)
+
+typedef void (*FrameWriter)(const uint8_t* data, size_t length, void* context);
+
+void fbClear();
+void fbWriteByte(int page, int x, uint8_t value);
+void fbSetPixel(int x, int y, bool on);
+void fbFillRect(int x, int y, int width, int height, bool on);
+void fbClearSpan(int page, int x0, int x1, int pages = 1);
+int fbDrawText(int x, int page, const char* text, int scale = 1, bool invert = false);
+int fbTextWidth(const char* text, int scale = 1);
+
+// Large 7-segment clock digits (BIG_DIGIT_HEIGHT, four pages) for "HH:MM"
+int fbDrawBigText(int x, int page, const char* text);
+int fbBigTextWidth(const char* text);
+
+const uint8_t* fbData();
+bool fbPageDirty(int page, int& first, int& last);
+void fbMarkClean();
+void fbMarkAllDirty();
+bool fbGetPixel(int x, int y);
+
+// Binary P4 by default, plain P1 (one text row per pixel row) for terminals
+void fbWritePbm(FrameWriter writer, void* context, bool plain = false);
+
+#endif // FRAMEBUFFER_H
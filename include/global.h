@@ -17,21 +17,58 @@
 #include <SD.h>
 #include <SPI.h>
 #include <FS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include "config.h"
+#include "cache_format.h"
+
+inline CivilDate civilDateFrom(const DateTime& dateTime) {
+  return CivilDate{(int16_t)dateTime.year(), (uint8_t)dateTime.month(), (uint8_t)dateTime.day()};
+}
+
+// Recursive lock over cache, settings and snapshot state, shared by loop()
+// and the boot tasks. Held for storage operations only, never across HTTP.
+extern SemaphoreHandle_t storageMutex;
+
+class StorageLock {
+public:
+  StorageLock() { xSemaphoreTakeRecursive(storageMutex, portMAX_DELAY); }
+  ~StorageLock() { xSemaphoreGiveRecursive(storageMutex); }
+  StorageLock(const StorageLock&) = delete;
+  StorageLock& operator=(const StorageLock&) = delete;
+};
+
+// Recursive lock over the API client, held for a whole fetch (requests and
+// the cache writes of their answers) by loop(), the boot network task and
+// the prefetcher. currentCity only changes while it is free, so a batch is
+// stored under the city it was requested for.
+extern SemaphoreHandle_t apiMutex;
+
+class ApiLock {
+public:
+  explicit ApiLock(TickType_t wait = portMAX_DELAY) : held_(xSemaphoreTakeRecursive(apiMutex, wait) == pdTRUE) {}
+  ~ApiLock() {
+    if (held_) xSemaphoreGiveRecursive(apiMutex);
+  }
+  bool held() const { return held_; }
+  ApiLock(const ApiLock&) = delete;
+  ApiLock& operator=(const ApiLock&) = delete;
+
+private:
+  bool held_;
+};
 
 // Global objects
 extern BluetoothSerial SerialBT;
 extern RTC_DS3231 rtc;
 extern Preferences preferences;
-extern HTTPClient http;
 
 // Global variables - WiFi Management
 extern String savedSSID;
 extern String savedPassword;
 extern String currentCity;
 extern String currentTimezone;
-extern int timezoneOffset;
-extern bool wifiConnected;
+extern int timezoneOffset;          // Whole hours (rounded), kept for legacy users
 extern unsigned long lastReconnectAttempt;
 extern unsigned long lastRetryReset;
 extern unsigned long lastWiFiCheck;
@@ -42,7 +79,7 @@ extern int wifiRSSI[MAX_NETWORKS];
 extern bool wifiSecurity[MAX_NETWORKS];
 
 // Global variables - System Status
-extern bool bluetoothConnected;
+extern bool bluetoothConnected;      // Bluetooth window open
 extern bool rtcInitialized;
 extern bool sdCardInitialized;
 extern String lastCommand;
@@ -51,43 +88,244 @@ extern bool waitingForInput;
 extern bool isFirstBoot;
 extern String inputPrompt;
 
-// Midnight caching variables
-extern unsigned long lastMidnightCheck;
-extern int lastCacheDay;
-extern bool midnightCacheComplete;
-
-// Buzzer enums and variables
-enum BuzzerMode {
-    BUZZER_OFF,
-    BUZZER_PRAYER_TIME,    // On-off pattern for 10 seconds at prayer time
-    BUZZER_WARNING,        // Continuous buzz for 1 second (10 minutes before)
-    BUZZER_ALARM           // Custom alarm pattern
+// Active timezone, resolved once from the compiled IANA table
+// Standard and daylight time of the active zone; fixed-offset zones
+// carry the same values in both. Pick one with isDaylightTime().
+struct TimezoneInfo {
+  const char* name;
+  const char* posix;
+  int16_t offsetMinutes;
+  char abbreviation[8];
+  char offsetLabel[12];   // e.g. "GMT+7", "GMT+5:30"
+  int16_t dstOffsetMinutes;
+  char dstAbbreviation[8];
+  char dstOffsetLabel[12];
+};
+
+extern TimezoneInfo activeTimezone;
+
+// Persistent settings, stored as one versioned blob in NVS.
+// New fields go at the end (before crc) so older blobs still load.
+struct DeviceSettings {
+  uint16_t version;
+  uint16_t size;
+  uint32_t writeCount;                    // Lifetime NVS writes, for wear monitoring
+  char ssid[MAX_SSID_LENGTH + 1];
+  char password[MAX_PASSWORD_LENGTH + 1];
+  char city[MAX_CITY_NAME_LENGTH + 1];
+  char timezone[MAX_TIMEZONE_LENGTH + 1];
+  int8_t timezoneOffset;
+  uint8_t firstBootDone;
+  uint8_t reserved[2];
+  uint8_t alertPatterns[PRAYER_COUNT];    // BuzzerPatternId per prayer (v2)
+  uint8_t warningPatterns[PRAYER_COUNT];
+  uint32_t crc;
 };
 
+extern DeviceSettings deviceSettings;
+extern uint32_t settingsSessionWrites;
+
+// Last alert and warning fired, so a reset inside the alert minute does not repeat them
+struct AlertDedupe {
+  int32_t alertDay;       // Day number (days since 1970), -1 if none
+  int32_t warningDay;
+  int8_t alertPrayer;     // PrayerIndex, -1 if none
+  int8_t warningPrayer;
+  uint8_t reserved[2];
+};
+
+extern AlertDedupe alertDedupe;
+extern bool warmBoot;
+
+// Buzzer state (patterns live in buzzer_patterns.h)
 extern bool buzzerInitialized;
-extern BuzzerMode currentBuzzerMode;
+
+// Cross-manager events, applied by loop() (system_events.cpp)
+enum SystemEventType : uint8_t {
+  EVENT_WIFI_CHANGED,
+  EVENT_SCHEDULE_UPDATED,    // Fresh day stored in the caches
+  EVENT_ALERT_FIRED,
+  EVENT_COMMAND_RECEIVED,    // One Bluetooth input line
+  EVENT_SETTINGS_CHANGED,
+  EVENT_TIMEZONE_REPORTED    // Zone name from an API response
+};
+
+struct SystemEvent {
+  SystemEventType type;
+  union {
+    struct {
+      bool connected;
+      int8_t rssi;
+    } wifi;
+    DaySchedule schedule;
+    struct {
+      int8_t prayer;         // PrayerIndex
+      bool warning;          // Warning before the prayer, not the prayer itself
+    } alert;
+    char command[MAX_COMMAND_LENGTH + 1];
+    struct {
+      uint8_t dirtyMask;     // SETTINGS_DIRTY_*
+    } settings;
+    char timezone[MAX_TIMEZONE_LENGTH + 1];
+  };
+};
+
+// Boot stages, in timeline order
+enum BootStage {
+  BOOT_STAGE_SETTINGS,
+  BOOT_STAGE_RTC,
+  BOOT_STAGE_BUZZER,
+  BOOT_STAGE_DISPLAY,
+  BOOT_STAGE_STORAGE,
+  BOOT_STAGE_BLUETOOTH,
+  BOOT_STAGE_WIFI,
+  BOOT_STAGE_NTP,
+  BOOT_STAGE_FETCH,
+  BOOT_STAGE_COUNT
+};
+
+// Boot Sequence Functions
+void runBootSequence();
+void startBootNetwork();
+bool bootNetworkActive();
+void showBootTimeline();
+
+// System Event Functions
+void initializeSystemEvents();
+bool postSystemEvent(const SystemEvent& event);
+void dispatchSystemEvents();
+void showEventQueueStatus();
+void handleBluetoothInput(const String& input);
+
+// Bluetooth Manager Functions
+void releaseBleControllerMemory();
+bool openBluetoothWindow(unsigned long durationMs);
+void closeBluetoothWindow();
+void noteBluetoothActivity();
+void serviceBluetoothWindow();
+void showBluetoothStatus();
+
+// Bulk Upload Functions (binary schedule transfer, bulk_protocol.h)
+bool startBulkUpload();
+bool bulkUploadActive();
+void showBulkUploadStatus();
+
+// Keep-alive API client counters, shown on the status screen
+struct ApiClientStats {
+  uint32_t responses;
+  uint32_t failures;        // Non-200 or never answered
+  uint32_t connections;     // TCP handshakes
+  uint32_t reusedRequests;  // Requests sent on an already used connection
+  uint32_t dnsLookups;
+  uint32_t reconnects;      // Connections lost mid-batch
+  uint32_t resentRequests;  // Requests repeated after a drop or close
+  uint32_t lastMs;
+  uint32_t minMs;
+  uint32_t maxMs;
+  uint64_t totalMs;
+  uint32_t gzipResponses;
+  uint64_t wireBytes;       // Body bytes received, as sent by the server
+  uint64_t bodyBytes;       // Body bytes after decoding
+};
+
+typedef void (*ApiResponseHandler)(int index, int status, const String& body, void* context);
+
+// API Client Functions
+String prayerTimesPath(const CivilDate& date);
+int apiGet(const String& path, String& body);
+int apiGetPipelined(const String* paths, int count, ApiResponseHandler handler, void* context);
+void apiClientClose();
+const ApiClientStats& apiClientStats();
+void resetApiClientStats();
+uint32_t apiLatencyPercentile(int percent);
+void showApiClientStats();
+
+// Streaming gzip decoder for API responses, one stream at a time. The
+// decoded body is buffered whole (up to MAX_FILE_SIZE) and copied out by
+// gzipInflateFinish(); see gzip_inflate.cpp.
+enum GzipStatus {
+  GZIP_NEEDS_INPUT,
+  GZIP_DONE,
+  GZIP_FAILED,
+  GZIP_TOO_LARGE     // Decoded body over MAX_FILE_SIZE
+};
+
+bool gzipInflateReserve();
+void gzipInflateRelease();
+bool gzipInflateStart();
+GzipStatus gzipInflateWrite(const uint8_t* data, size_t length);
+bool gzipInflateFinish(String& body);
+
+// Load Test Functions (LOAD_TEST_ENABLED builds)
+void runLoadTest(int rounds);
 
 // WiFi Manager Functions
 void loadWiFiCredentials();
 void saveWiFiCredentials(const String& ssid, const String& password);
 void clearWiFiCredentials();
 bool connectToWiFi(const String& ssid, const String& password);
+bool isWiFiConnected();
+void noteWiFiLinkState(bool connected);
 void checkWiFiConnection();
 void autoReconnectWiFi();
 void scanWiFiNetworks();
 void displayWiFiNetworks();
 String getSignalStrength(int rssi);
 
+// Settings Manager Functions
+void loadSettings();
+bool saveSettingsNow();
+void serviceSettings();
+void settingsSetWiFi(const String& ssid, const String& password);
+void settingsClearWiFi();
+bool settingsSetCity(const String& city);
+void settingsSetTimezone(const String& timezone, int offset);
+void settingsSetFirstBootDone();
+bool settingsPending();
+void restoreSettings(const DeviceSettings& snapshot, bool dirty);
+void settingsSetBuzzerPattern(int prayer, bool warning, uint8_t pattern);
+
+// Warm Boot Functions
+bool restoreWarmBoot();
+void saveWarmBootSnapshot();
+void refreshWarmBootSchedules(const CivilDate& today);
+void updateWarmBootSchedule(const DaySchedule& schedule);
+void invalidateWarmBootSchedules();
+void noteAlertPathReady();
+int32_t alertReadyMillis();
+uint32_t warmBootCount();
+const char* resetReasonName();
+
+// Active Schedule Functions
+void publishActiveSchedule(const DaySchedule* days);
+bool readActiveSchedule(int32_t dayNumber, DaySchedule& schedule);
+void serviceActiveSchedule();
+uint32_t activeScheduleGeneration();
+void showActiveScheduleStatus();
+
+// Prayer Countdown Functions
+struct NextPrayer {
+  int prayer;              // PRAYER_* index
+  int32_t dayNumber;       // Day the prayer falls on (tomorrow after Isha)
+  uint16_t minutes;        // Local minutes since midnight
+  int32_t secondsLeft;
+};
+void updatePrayerCountdown(const DateTime& now);
+bool getNextPrayer(NextPrayer& next);
+void showNextPrayer();
+
 // Prayer Times Functions
 void fetchPrayerTimes();
 void fetchPrayerTimesForDays(int days);
 void displayPrayerTimes();
 void displayPrayerTimes(const String& jsonData, bool fromAPI = false);
-bool loadPrayerTimesFromSD(const String& date);
+void displayPrayerTimes(const DaySchedule& schedule);
+bool parseDaySchedule(const String& jsonData, const CivilDate& date, DaySchedule& schedule);
+bool loadPrayerTimesFromSD(const CivilDate& date);
 bool loadPrayerTimesFromSD();
-void savePrayerTimesToSD(const String& jsonData, const String& date);
 void updateTimezoneFromAPI(const String& apiTimezone);
-String getTimezoneAbbreviation(int offset);
+String getTimezoneAbbreviation();
+String getTimezoneOffsetLabel();
 void displayDate();
 void displayClock();
 void displayFajr();
@@ -96,7 +334,8 @@ void displayAsr();
 void displayMaghrib();
 void displayIsha();
 String formatTime(const String& time24);
-String getCurrentDateString();
+bool fetchAndCachePrayerTimes(const CivilDate& date);
+int fetchAndCacheDays(const CivilDate* dates, int count);
 
 // Time Manager Functions
 void initializeRTC();
@@ -105,26 +344,61 @@ void syncTimeWithNTP(bool forceSync);
 void syncTimeWithNTP(int timezoneOffset, const String& timezone);
 void updateRTCFromNTP();
 String getCurrentTime();
-String getCurrentDate();
+CivilDate getToday();
+String dateKeyString(const CivilDate& date);
 void setSystemTime(int year, int month, int day, int hour, int minute, int second);
 void showTime();
 void showMenu();
+bool resolveTimezone(const String& name, TimezoneInfo& zone);
+int wholeHourOffset(int offsetMinutes);
+bool applyTimezone(const String& name);
+bool isDaylightTime(const DateTime& local);
+bool isDaylightTimeNow();
+int utcOffsetMinutesOn(const CivilDate& date);
 String getSecurityType(bool isOpen);
 
 // SD Manager Functions
 void initializeSDCard();
 bool writeFile(const String& path, const String& message);
+bool commitFile(const String& tempPath, const String& path);
 String readFile(const String& path);
+bool readVerifiedFile(const String& path, String& body);
+bool readCachedDay(const CivilDate& date, String& body);
+void discardCachedDay(const CivilDate& date);
 bool fileExists(const String& path);
 void listDir(const String& dirname, uint8_t levels);
 void createDir(const String& path);
 void deleteFile(const String& path);
 String loadPrayerDataFromSD(const String& filename);
-void savePrayerTimesToSD(const String& jsonData, const String& date);
+void savePrayerTimesToSD(const String& jsonData, const CivilDate& date);
+bool saveCacheDayToSD(const String& city, const CivilDate& date, const String& body);
+
+// Cache Manifest Functions
+void loadCacheManifest(const String& city, int year);
+bool isDayCached(const String& city, const CivilDate& date);
+uint32_t getCachedDayChecksum(const String& city, const CivilDate& date);
+void markDayCached(const String& city, const CivilDate& date, uint32_t checksum);
+void clearDayCached(const String& city, const CivilDate& date);
+bool ensureCacheMonthDir(const String& city, int year, int month);
+void flushCacheManifests();
 
-// Midnight Caching Functions
-void checkMidnightCaching();
-void performMidnightCache();
+// Flash Cache Functions
+extern bool flashCacheInitialized;
+void initializeFlashCache();
+bool loadFlashSchedule(int32_t dayNumber, DaySchedule& schedule);
+bool storeFlashSchedule(const DaySchedule& schedule);
+void storeFlashScheduleFromJson(const String& jsonData, const CivilDate& date);
+bool storeDaySchedule(const DaySchedule& schedule);
+bool getDaySchedule(const CivilDate& date, DaySchedule& schedule);
+bool isScheduleCached(const CivilDate& date);
+void promoteFlashWindow();
+void dropFlashSchedule(int32_t dayNumber);
+int countFlashScheduleDays();
+
+// Cache Prefetcher Functions
+void startCachePrefetcher();
+void wakeCachePrefetcher();
+void showPrefetcherStatus();
 
 // Display Manager Functions
 void initializeDisplay();
@@ -132,27 +406,40 @@ void updateDisplay();
 void clearDisplay();
 void displayWelcomeMessage();
 void displaySystemStatus();
+bool startDisplayTest();
+void stopDisplayTest();
 void displayCurrentInfo(DateTime now);
 void displayPrayerAlert(const String& prayerName);
 void displayWarningAlert(const String& prayerName, int minutesLeft);
 void displayError(const String& errorMsg);
+void showDisplayStats();
+void dumpDisplayScreenshot();
+void runRenderBenchmark(int iterations);
+
+// Audio Player Functions
+bool startAudioPlayback(const char* path);
+void stopAudioPlayback();
+bool audioPlaying();
+void showAudioStatus();
+void runAudioBenchmark(int blocks);
 
 // Buzzer Manager Functions
 void initializeBuzzer();
 void updateBuzzer();
 void testBuzzer();
+void stopBuzzerTest();
 void stopBuzzer();
-void startPrayerTimeBuzzer(const String& prayerName);
-void startPrayerWarningBuzzer(const String& prayerName);
+bool buzzerBusy();
+void startPrayerTimeBuzzer(int prayer);
+void startPrayerWarningBuzzer(int prayer);
+bool startBuzzerPattern(uint8_t pattern);
+void handlePatternCommand(const String& args);
+void showBuzzerPatterns();
 void checkPrayerAlerts();
-void checkPrayerTimeAlerts(DateTime now, const String& prayerTimesJson);
-void handleBuzzerPattern(unsigned long currentMillis);
-void handlePrayerTimeBuzzer(unsigned long elapsed);
-void handleWarningBuzzer(unsigned long elapsed);
-void handleAlarmBuzzer(unsigned long elapsed);
+void checkPrayerTimeAlerts(DateTime now, const DaySchedule& schedule);
 
 // Prayer Times Helper Functions
-String getPrayerTimesFromCache(const String& dateKey);
+String getPrayerTimesFromCache(const CivilDate& date);
 
 // Debug Utils Functions
 void debugPrint(const String& message);
@@ -0,0 +1,155 @@
+/*
+ * Glyph atlas for the framebuffer
+ * Everything here is generated by the compiler: the 5x7 source font is
+ * padded into CHAR_WIDTH-wide cells, the scale-2 row expansion is a
+ * 256-entry table, and the large clock digits are built from 7-segment
+ * masks. All tables are column-major in the framebuffer's bit order (bit 0
+ * on top), so drawing is one store per column and page with no decoding at
+ * run time. constexpr data ends up in flash (.rodata) on the ESP32.
+ * Include from framebuffer.cpp only.
+ */
+
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <stdint.h>
+#include "config.h"
+
+#define GLYPH_FIRST_CHAR 0x20
+#define GLYPH_LAST_CHAR 0x7E
+#define GLYPH_COUNT (GLYPH_LAST_CHAR - GLYPH_FIRST_CHAR + 1)
+
+// Large clock digits: four pages tall, one 32-bit word per column
+#define BIG_DIGIT_WIDTH 20
+#define BIG_DIGIT_HEIGHT 32
+#define BIG_DIGIT_GAP 4        // Blank columns after each digit
+#define BIG_COLON_WIDTH 8
+#define BIG_SEGMENT 4          // Segment thickness in pixels
+
+// Classic 5x7 ASCII font (0x20-0x7E), one byte per column, bit 0 on top
+inline constexpr uint8_t font5x7[GLYPH_COUNT][5] = {
+  {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00}, // ' ' ! "
+  {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62}, // # $ %
+  {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00}, // & ' (
+  {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x14, 0x08, 0x3E, 0x08, 0x14}, {0x08, 0x08, 0x3E, 0x08, 0x08}, // ) * +
+  {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00}, // , - .
+  {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00}, // / 0 1
+  {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4B, 0x31}, {0x18, 0x14, 0x12, 0x7F, 0x10}, // 2 3 4
+  {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03}, // 5 6 7
+  {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x36, 0x36, 0x00, 0x00}, // 8 9 :
+  {0x00, 0x56, 0x36, 0x00, 0x00}, {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14}, // ; < =
+  {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06}, {0x32, 0x49, 0x79, 0x41, 0x3E}, // > ? @
+  {0x7E, 0x11, 0x11, 0x11, 0x7E}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22}, // A B C
+  {0x7F, 0x41, 0x41, 0x22, 0x1C}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01}, // D E F
+  {0x3E, 0x41, 0x49, 0x49, 0x7A}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00}, // G H I
+  {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40}, // J K L
+  {0x7F, 0x02, 0x0C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E}, // M N O
+  {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46}, // P Q R
+  {0x46, 0x49, 0x49, 0x49, 0x31}, {0x01, 0x01, 0x7F, 0x01, 0x01}, {0x3F, 0x40, 0x40, 0x40, 0x3F}, // S T U
+  {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63}, // V W X
+  {0x07, 0x08, 0x70, 0x08, 0x07}, {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x00}, // Y Z [
+  {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7F, 0x00}, {0x04, 0x02, 0x01, 0x02, 0x04}, // \ ] ^
+  {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78}, // _ ` a
+  {0x7F, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20}, {0x38, 0x44, 0x44, 0x48, 0x7F}, // b c d
+  {0x38, 0x54, 0x54, 0x54, 0x18}, {0x08, 0x7E, 0x09, 0x01, 0x02}, {0x0C, 0x52, 0x52, 0x52, 0x3E}, // e f g
+  {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x44, 0x3D, 0x00}, // h i j
+  {0x7F, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x18, 0x04, 0x78}, // k l m
+  {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0x7C, 0x14, 0x14, 0x14, 0x08}, // n o p
+  {0x08, 0x14, 0x14, 0x18, 0x7C}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20}, // q r s
+  {0x04, 0x3F, 0x44, 0x40, 0x20}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C}, // t u v
+  {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0C, 0x50, 0x50, 0x50, 0x3C}, // w x y
+  {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x7F, 0x00, 0x00}, // z { |
+  {0x00, 0x41, 0x36, 0x08, 0x00}, {0x08, 0x04, 0x08, 0x10, 0x08}                                  // } ~
+};
+
+// Segments a-g as bits 0-6 for 0-9
+inline constexpr uint8_t sevenSegmentDigits[10] = {
+  0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F
+};
+
+struct TextAtlas {
+  uint8_t columns[GLYPH_COUNT][CHAR_WIDTH];   // Glyph plus its blank spacing columns
+};
+
+struct DoubledRows {
+  uint16_t rows[256];   // Column byte with every bit doubled vertically
+};
+
+struct BigDigitAtlas {
+  uint32_t digits[10][BIG_DIGIT_WIDTH];
+  uint32_t colon[BIG_COLON_WIDTH];
+};
+
+constexpr TextAtlas buildTextAtlas() {
+  TextAtlas atlas = {};
+  for (int glyph = 0; glyph < GLYPH_COUNT; glyph++) {
+    for (int column = 0; column < 5; column++) {
+      atlas.columns[glyph][column] = font5x7[glyph][column];
+    }
+  }
+  return atlas;
+}
+
+constexpr DoubledRows buildDoubledRows() {
+  DoubledRows table = {};
+  for (int value = 0; value < 256; value++) {
+    uint16_t doubled = 0;
+    for (int bit = 0; bit < 8; bit++) {
+      if (value & (1 << bit)) {
+        doubled |= 3 << (bit * 2);
+      }
+    }
+    table.rows[value] = doubled;
+  }
+  return table;
+}
+
+// Rows y0..y1-1 of a 32-pixel column
+constexpr uint32_t columnSpan(int y0, int y1) {
+  return (uint32_t)((1ULL << y1) - (1ULL << y0));
+}
+
+// One column of a 7-segment digit; segments are inset by a pixel so they do not touch
+constexpr uint32_t segmentColumn(uint8_t segments, int x) {
+  const int middle = BIG_DIGIT_HEIGHT / 2;
+  uint32_t column = 0;
+  if (x >= 1 && x < BIG_DIGIT_WIDTH - 1) {
+    if (segments & 0x01) column |= columnSpan(0, BIG_SEGMENT);                                          // a
+    if (segments & 0x40) column |= columnSpan(middle - BIG_SEGMENT / 2, middle + BIG_SEGMENT / 2);      // g
+    if (segments & 0x08) column |= columnSpan(BIG_DIGIT_HEIGHT - BIG_SEGMENT, BIG_DIGIT_HEIGHT);        // d
+  }
+  if (x < BIG_SEGMENT) {
+    if (segments & 0x20) column |= columnSpan(1, middle - 1);                                           // f
+    if (segments & 0x10) column |= columnSpan(middle + 1, BIG_DIGIT_HEIGHT - 1);                        // e
+  }
+  if (x >= BIG_DIGIT_WIDTH - BIG_SEGMENT) {
+    if (segments & 0x02) column |= columnSpan(1, middle - 1);                                           // b
+    if (segments & 0x04) column |= columnSpan(middle + 1, BIG_DIGIT_HEIGHT - 1);                        // c
+  }
+  return column;
+}
+
+constexpr BigDigitAtlas buildBigDigits() {
+  BigDigitAtlas atlas = {};
+  for (int digit = 0; digit < 10; digit++) {
+    for (int x = 0; x < BIG_DIGIT_WIDTH; x++) {
+      atlas.digits[digit][x] = segmentColumn(sevenSegmentDigits[digit], x);
+    }
+  }
+  // Two squares centred on the upper and lower halves
+  for (int x = 2; x < 2 + BIG_SEGMENT; x++) {
+    atlas.colon[x] = columnSpan(8, 8 + BIG_SEGMENT) | columnSpan(20, 20 + BIG_SEGMENT);
+  }
+  return atlas;
+}
+
+inline constexpr TextAtlas textAtlas = buildTextAtlas();
+inline constexpr DoubledRows doubledRows = buildDoubledRows();
+inline constexpr BigDigitAtlas bigDigits = buildBigDigits();
+
+static_assert(CHAR_WIDTH >= 5 && CHAR_HEIGHT == 8, "Text cells must fit the 5x7 font in one page");
+static_assert(doubledRows.rows[0x81] == 0xC003, "Scale-2 expansion");
+static_assert(bigDigits.digits[8][0] == (columnSpan(1, 15) | columnSpan(17, 31)), "Digit 8 left edge");
+static_assert(bigDigits.digits[1][BIG_DIGIT_WIDTH / 2] == 0, "Digit 1 has no horizontal segments");
+
+#endif // GLYPH_ATLAS_H
@@ -0,0 +1,68 @@
+/*
+ * Single-producer/single-consumer ring queue
+ * One task pushes and one task pops, possibly on different cores, without
+ * locks: each index is written by only one side and published with
+ * release/acquire ordering. Capacity must be a power of two; one slot is
+ * never used so that full and empty can be told apart.
+ * tools/spsc_queue_stress.cpp exercises it on the host under ThreadSanitizer.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+template <typename T, size_t Capacity>
+class SpscQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  // Producer side; false (and counted) when the queue is full
+  bool push(const T& item) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t next = (head + 1) & (Capacity - 1);
+    if (next == tail_.load(std::memory_order_acquire)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    slots_[head] = item;
+    head_.store(next, std::memory_order_release);
+
+    uint32_t depth = (next - tail_.load(std::memory_order_relaxed)) & (Capacity - 1);
+    if (depth > peak_.load(std::memory_order_relaxed)) {
+      peak_.store(depth, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  // Consumer side; false when the queue is empty
+  bool pop(T& item) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = slots_[tail];
+    tail_.store((tail + 1) & (Capacity - 1), std::memory_order_release);
+    return true;
+  }
+
+  // Approximate from either side
+  size_t size() const {
+    return (head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire)) & (Capacity - 1);
+  }
+
+  static constexpr size_t capacity() { return Capacity - 1; }
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+  uint32_t peak() const { return peak_.load(std::memory_order_relaxed); }
+
+private:
+  T slots_[Capacity];
+  std::atomic<uint32_t> head_{0};   // Next slot to write, owned by the producer
+  std::atomic<uint32_t> tail_{0};   // Next slot to read, owned by the consumer
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<uint32_t> peak_{0};
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,135 @@
+/*
+ * Timezone Table for ESP32 Prayer Times Controller
+ * GENERATED by scripts/gen_tz_table.py from scripts/tz_zones.csv - do not edit
+ */
+
+#ifndef TZ_TABLE_H
+#define TZ_TABLE_H
+
+#include <stdint.h>
+
+struct TzEntry {
+  uint32_t hash;            // FNV-1a of name
+  const char* name;         // IANA zone name
+  const char* posix;        // POSIX TZ rule for configTzTime()
+  const char* abbreviation; // Standard time abbreviation
+  int16_t offsetMinutes;    // Standard time offset east of UTC
+  const char* dstAbbreviation; // Daylight time; same as standard in fixed-offset zones
+  int16_t dstOffsetMinutes;
+};
+
+#define TZ_ENTRY_COUNT 72
+#define TZ_HASH_SIZE 256
+#define TZ_HASH_EMPTY 0xFFFF
+
+static const TzEntry tzEntries[TZ_ENTRY_COUNT] = {
+  {0xC9D160E2UL, "Asia/Jakarta", "WIB-7", "WIB", 420, "WIB", 420},
+  {0xDDE257D5UL, "Asia/Pontianak", "WIB-7", "WIB", 420, "WIB", 420},
+  {0xDC444367UL, "Asia/Makassar", "WITA-8", "WITA", 480, "WITA", 480},
+  {0xB0F63A1DUL, "Asia/Jayapura", "WIT-9", "WIT", 540, "WIT", 540},
+  {0x5D1A2684UL, "Asia/Kuala_Lumpur", "<+08>-8", "+08", 480, "+08", 480},
+  {0x505B70C1UL, "Asia/Kuching", "<+08>-8", "+08", 480, "+08", 480},
+  {0xDA5AB2B2UL, "Asia/Singapore", "<+08>-8", "+08", 480, "+08", 480},
+  {0xBC03606DUL, "Asia/Brunei", "<+08>-8", "+08", 480, "+08", 480},
+  {0x2B6486E8UL, "Asia/Manila", "PST-8", "PST", 480, "PST", 480},
+  {0x39E5C8BDUL, "Asia/Bangkok", "<+07>-7", "+07", 420, "+07", 420},
+  {0xCC18ACD9UL, "Asia/Ho_Chi_Minh", "<+07>-7", "+07", 420, "+07", 420},
+  {0x949D098AUL, "Asia/Phnom_Penh", "<+07>-7", "+07", 420, "+07", 420},
+  {0x215F0598UL, "Asia/Yangon", "<+0630>-6:30", "+0630", 390, "+0630", 390},
+  {0xBE181427UL, "Asia/Dhaka", "<+06>-6", "+06", 360, "+06", 360},
+  {0x6706F6BBUL, "Asia/Kathmandu", "<+0545>-5:45", "+0545", 345, "+0545", 345},
+  {0xEEBFA085UL, "Asia/Kolkata", "IST-5:30", "IST", 330, "IST", 330},
+  {0x4D386C51UL, "Asia/Colombo", "<+0530>-5:30", "+0530", 330, "+0530", 330},
+  {0xD5C98F4DUL, "Asia/Karachi", "PKT-5", "PKT", 300, "PKT", 300},
+  {0xA8DC3202UL, "Asia/Tashkent", "<+05>-5", "+05", 300, "+05", 300},
+  {0xC64ADC6CUL, "Asia/Almaty", "<+05>-5", "+05", 300, "+05", 300},
+  {0x0124A15FUL, "Asia/Bishkek", "<+06>-6", "+06", 360, "+06", 360},
+  {0x19B04026UL, "Asia/Dushanbe", "<+05>-5", "+05", 300, "+05", 300},
+  {0x3DCB75BFUL, "Asia/Ashgabat", "<+05>-5", "+05", 300, "+05", 300},
+  {0xD91F8E4AUL, "Indian/Maldives", "<+05>-5", "+05", 300, "+05", 300},
+  {0xFAAF5187UL, "Asia/Kabul", "<+0430>-4:30", "+0430", 270, "+0430", 270},
+  {0x00FFA612UL, "Asia/Tehran", "<+0330>-3:30", "+0330", 210, "+0330", 210},
+  {0x6B2F60CDUL, "Asia/Dubai", "<+04>-4", "+04", 240, "+04", 240},
+  {0xEBC4BAE9UL, "Asia/Muscat", "<+04>-4", "+04", 240, "+04", 240},
+  {0xDBFFE145UL, "Asia/Baku", "<+04>-4", "+04", 240, "+04", 240},
+  {0x184E6476UL, "Asia/Tbilisi", "<+04>-4", "+04", 240, "+04", 240},
+  {0xA8F0FA30UL, "Asia/Yerevan", "<+04>-4", "+04", 240, "+04", 240},
+  {0xBEFC6C3BUL, "Asia/Riyadh", "<+03>-3", "+03", 180, "+03", 180},
+  {0x61DB443DUL, "Asia/Qatar", "<+03>-3", "+03", 180, "+03", 180},
+  {0x270ED30DUL, "Asia/Bahrain", "<+03>-3", "+03", 180, "+03", 180},
+  {0xA76D1515UL, "Asia/Kuwait", "<+03>-3", "+03", 180, "+03", 180},
+  {0x5C4F25D2UL, "Asia/Aden", "<+03>-3", "+03", 180, "+03", 180},
+  {0x503DC8B7UL, "Asia/Baghdad", "<+03>-3", "+03", 180, "+03", 180},
+  {0x4391107EUL, "Asia/Amman", "<+03>-3", "+03", 180, "+03", 180},
+  {0xC89EC203UL, "Asia/Damascus", "<+03>-3", "+03", 180, "+03", 180},
+  {0xDE01881FUL, "Asia/Beirut", "EET-2EEST,M3.5.0/0,M10.5.0/0", "EET", 120, "EEST", 180},
+  {0xB8FFE55EUL, "Asia/Jerusalem", "IST-2IDT,M3.4.4/26,M10.5.0", "IST", 120, "IDT", 180},
+  {0xDA1FB251UL, "Asia/Gaza", "EET-2EEST,M3.4.4/50,M10.4.4/50", "EET", 120, "EEST", 180},
+  {0x087B2252UL, "Europe/Istanbul", "<+03>-3", "+03", 180, "+03", 180},
+  {0x0082155CUL, "Europe/Moscow", "MSK-3", "MSK", 180, "MSK", 180},
+  {0xEA8D067CUL, "Africa/Cairo", "EET-2EEST,M4.5.5/0,M10.5.4/24", "EET", 120, "EEST", 180},
+  {0xB52ADEE7UL, "Africa/Khartoum", "CAT-2", "CAT", 120, "CAT", 120},
+  {0x04BA57F3UL, "Africa/Tripoli", "EET-2", "EET", 120, "EET", 120},
+  {0xA3887BEBUL, "Africa/Tunis", "CET-1", "CET", 60, "CET", 60},
+  {0x97F3C9D7UL, "Africa/Algiers", "CET-1", "CET", 60, "CET", 60},
+  {0x9D46D8D5UL, "Africa/Casablanca", "<+01>-1", "+01", 60, "+01", 60},
+  {0x151EEB2AUL, "Africa/Lagos", "WAT-1", "WAT", 60, "WAT", 60},
+  {0xEDC8B11FUL, "Africa/Dakar", "GMT0", "GMT", 0, "GMT", 0},
+  {0x290A0946UL, "Africa/Nairobi", "EAT-3", "EAT", 180, "EAT", 180},
+  {0x86EC5AA7UL, "Africa/Mogadishu", "EAT-3", "EAT", 180, "EAT", 180},
+  {0x32957E52UL, "Africa/Johannesburg", "SAST-2", "SAST", 120, "SAST", 120},
+  {0xBE803F4EUL, "Europe/London", "GMT0BST,M3.5.0/1,M10.5.0", "GMT", 0, "BST", 60},
+  {0x6DFA7F8FUL, "Europe/Paris", "CET-1CEST,M3.5.0,M10.5.0/3", "CET", 60, "CEST", 120},
+  {0x31405CD4UL, "Europe/Berlin", "CET-1CEST,M3.5.0,M10.5.0/3", "CET", 60, "CEST", 120},
+  {0xD31F79B8UL, "Europe/Amsterdam", "CET-1CEST,M3.5.0,M10.5.0/3", "CET", 60, "CEST", 120},
+  {0x54CF41CFUL, "Europe/Sarajevo", "CET-1CEST,M3.5.0,M10.5.0/3", "CET", 60, "CEST", 120},
+  {0xB5393381UL, "Asia/Shanghai", "CST-8", "CST", 480, "CST", 480},
+  {0x9AF27096UL, "Asia/Hong_Kong", "HKT-8", "HKT", 480, "HKT", 480},
+  {0x8EEB637EUL, "Asia/Tokyo", "JST-9", "JST", 540, "JST", 540},
+  {0x488F56F8UL, "Asia/Seoul", "KST-9", "KST", 540, "KST", 540},
+  {0x1BA19858UL, "Asia/Dili", "<+09>-9", "+09", 540, "+09", 540},
+  {0x2C198415UL, "Australia/Perth", "AWST-8", "AWST", 480, "AWST", 480},
+  {0x7FD5A7F2UL, "Australia/Sydney", "AEST-10AEDT,M10.1.0,M4.1.0/3", "AEST", 600, "AEDT", 660},
+  {0x0796405CUL, "America/New_York", "EST5EDT,M3.2.0,M11.1.0", "EST", -300, "EDT", -240},
+  {0x365363D4UL, "America/Chicago", "CST6CDT,M3.2.0,M11.1.0", "CST", -360, "CDT", -300},
+  {0x99387CD4UL, "America/Los_Angeles", "PST8PDT,M3.2.0,M11.1.0", "PST", -480, "PDT", -420},
+  {0xBFD5A989UL, "America/Toronto", "EST5EDT,M3.2.0,M11.1.0", "EST", -300, "EDT", -240},
+  {0xC06E567DUL, "UTC", "UTC0", "UTC", 0, "UTC", 0},
+};
+
+static const uint16_t tzHashIndex[TZ_HASH_SIZE] = {
+  0xFFFF, 0xFFFF, 0x0012, 0x0026, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+  0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0021, 0xFFFF, 0xFFFF,
+  0xFFFF, 0xFFFF, 0x0019, 0xFFFF, 0xFFFF, 0x0022, 0x0041, 0xFFFF,
+  0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0003, 0xFFFF, 0x0027,
+  0x0033, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0015, 0x000D,
+  0xFFFF, 0xFFFF, 0x0032, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+  0x001E, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+  0xFFFF, 0xFFFF, 0xFFFF, 0x001F, 0xFFFF, 0x0020, 0xFFFF, 0xFFFF,
+  0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x001C, 0x0034, 0xFFFF,
+  0xFFFF, 0xFFFF, 0x0017, 0xFFFF, 0xFFFF, 0x0011, 0x0037, 0xFFFF,
+  0xFFFF, 0x0010, 0x0029, 0x002A, 0x0036, 0xFFFF, 0xFFFF, 0xFFFF,
+  0x0040, 0xFFFF, 0xFFFF, 0xFFFF, 0x002B, 0x0043, 0x0028, 0x0014,
+  0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0002,
+  0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0013, 0x0007, 0xFFFF, 0xFFFF,
+  0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x001D, 0xFFFF,
+  0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x002C, 0x0047, 0x0025, 0x003E,
+  0xFFFF, 0x003C, 0xFFFF, 0xFFFF, 0x0004, 0x000F, 0xFFFF, 0x0018,
+  0xFFFF, 0x0046, 0x000B, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0038,
+  0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x003D, 0xFFFF,
+  0x000C, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+  0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0035,
+  0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+  0xFFFF, 0xFFFF, 0x0006, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0024,
+  0x003A, 0xFFFF, 0xFFFF, 0x000E, 0xFFFF, 0x0009, 0xFFFF, 0x0016,
+  0xFFFF, 0x0005, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+  0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x001A, 0xFFFF, 0x003B,
+  0xFFFF, 0xFFFF, 0x0023, 0xFFFF, 0x0039, 0x0001, 0x0031, 0x0030,
+  0x0044, 0x000A, 0x0045, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+  0xFFFF, 0xFFFF, 0x0000, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x002D,
+  0x0008, 0x001B, 0xFFFF, 0x002F, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+  0xFFFF, 0xFFFF, 0x0042, 0x002E, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+  0x003F, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+};
+
+#endif // TZ_TABLE_H
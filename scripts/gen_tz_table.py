@@ -0,0 +1,144 @@
+"""
+Generates include/tz_table.h from scripts/tz_zones.csv.
+
+Each IANA zone name is mapped to its POSIX TZ rule plus the standard and
+daylight offsets and abbreviations parsed from that rule, and placed in an
+open-addressed FNV-1a hash index for O(1) lookup on the device.
+
+Runs automatically as a PlatformIO pre-build script (extra_scripts) and
+only rewrites the header when the zone list is newer. Can also be run
+directly: python scripts/gen_tz_table.py
+"""
+
+import os
+import re
+import sys
+
+FNV_OFFSET = 0x811C9DC5
+FNV_PRIME = 0x01000193
+
+
+def fnv1a(text):
+    value = FNV_OFFSET
+    for byte in text.encode("ascii"):
+        value ^= byte
+        value = (value * FNV_PRIME) & 0xFFFFFFFF
+    return value
+
+
+TZ_NAME = r"(<[^>]+>|[A-Za-z]{3,})"
+TZ_OFFSET = r"([+-]?)(\d{1,2})(?::(\d{2}))?"
+
+
+def offset_minutes(sign, hours, minutes):
+    value = int(hours) * 60 + int(minutes or 0)
+    # POSIX offsets are west-positive, the table stores east-positive
+    return value if sign == "-" else -value
+
+
+def parse_posix(rule):
+    """Returns (abbreviation, offset) of standard and of daylight time, in UTC minutes.
+
+    Fixed-offset zones repeat the standard values for daylight time; a
+    daylight part without its own offset is one hour ahead of standard.
+    """
+    match = re.match("^" + TZ_NAME + TZ_OFFSET + "(?:" + TZ_NAME + "(?:" + TZ_OFFSET + ")?)?(,|$)", rule)
+    if not match:
+        raise ValueError("Unsupported POSIX TZ rule: " + rule)
+    abbr = match.group(1).strip("<>")
+    minutes = offset_minutes(match.group(2), match.group(3), match.group(4))
+    if not match.group(5):
+        return abbr, minutes, abbr, minutes
+    dst_abbr = match.group(5).strip("<>")
+    if match.group(7):
+        dst_minutes = offset_minutes(match.group(6), match.group(7), match.group(8))
+    else:
+        dst_minutes = minutes + 60
+    return abbr, minutes, dst_abbr, dst_minutes
+
+
+def load_zones(csv_path):
+    zones = []
+    with open(csv_path, encoding="ascii") as handle:
+        for line in handle:
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            name, rule = line.split(",", 1)
+            zones.append((name, rule) + parse_posix(rule))
+    return zones
+
+
+def build_index(zones):
+    size = 1
+    while size < len(zones) * 2:
+        size <<= 1
+    index = [0xFFFF] * size
+    for position, zone in enumerate(zones):
+        slot = fnv1a(zone[0]) & (size - 1)
+        while index[slot] != 0xFFFF:
+            slot = (slot + 1) & (size - 1)
+        index[slot] = position
+    return index
+
+
+def render(zones, index):
+    lines = [
+        "/*",
+        " * Timezone Table for ESP32 Prayer Times Controller",
+        " * GENERATED by scripts/gen_tz_table.py from scripts/tz_zones.csv - do not edit",
+        " */",
+        "",
+        "#ifndef TZ_TABLE_H",
+        "#define TZ_TABLE_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        "struct TzEntry {",
+        "  uint32_t hash;            // FNV-1a of name",
+        "  const char* name;         // IANA zone name",
+        "  const char* posix;        // POSIX TZ rule for configTzTime()",
+        "  const char* abbreviation; // Standard time abbreviation",
+        "  int16_t offsetMinutes;    // Standard time offset east of UTC",
+        "  const char* dstAbbreviation; // Daylight time; same as standard in fixed-offset zones",
+        "  int16_t dstOffsetMinutes;",
+        "};",
+        "",
+        "#define TZ_ENTRY_COUNT %d" % len(zones),
+        "#define TZ_HASH_SIZE %d" % len(index),
+        "#define TZ_HASH_EMPTY 0xFFFF",
+        "",
+        "static const TzEntry tzEntries[TZ_ENTRY_COUNT] = {",
+    ]
+    for name, rule, abbr, offset, dst_abbr, dst_offset in zones:
+        lines.append('  {0x%08XUL, "%s", "%s", "%s", %d, "%s", %d},' %
+                     (fnv1a(name), name, rule, abbr, offset, dst_abbr, dst_offset))
+    lines.append("};")
+    lines.append("")
+    lines.append("static const uint16_t tzHashIndex[TZ_HASH_SIZE] = {")
+    for start in range(0, len(index), 8):
+        chunk = ", ".join("0x%04X" % value for value in index[start:start + 8])
+        lines.append("  " + chunk + ",")
+    lines.append("};")
+    lines.append("")
+    lines.append("#endif // TZ_TABLE_H")
+    return "\n".join(lines) + "\n"
+
+
+def generate(project_dir):
+    csv_path = os.path.join(project_dir, "scripts", "tz_zones.csv")
+    header_path = os.path.join(project_dir, "include", "tz_table.h")
+    if os.path.exists(header_path) and os.path.getmtime(header_path) >= os.path.getmtime(csv_path):
+        return
+    zones = load_zones(csv_path)
+    with open(header_path, "w", encoding="ascii", newline="\n") as handle:
+        handle.write(render(zones, build_index(zones)))
+    print("Generated %s (%d zones)" % (header_path, len(zones)))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    generate(env["PROJECT_DIR"])  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        generate(os.path.dirname(os.path.dirname(os.path.abspath(sys.argv[0]))))
@@ -0,0 +1,106 @@
+/*
+ * Active Schedule Implementation
+ * Today's and tomorrow's schedules for the alert path, published through an
+ * atomically swapped pointer. Writers fill the spare buffer under
+ * StorageLock and swap it in with one store; readers copy without a lock
+ * and retry if a later publish reused the buffer they were reading
+ * (sequence check). Tomorrow is loaded ahead, so midnight needs no storage.
+ */
+
+#include "global.h"
+#include <atomic>
+
+struct ActiveSchedule {
+  std::atomic<uint32_t> seq;          // Odd while the buffer is being written
+  DaySchedule days[WARM_BOOT_DAYS];   // dayNumber 0 = empty
+};
+
+static ActiveSchedule scheduleBuffers[2];
+static std::atomic<ActiveSchedule*> activeSchedule(&scheduleBuffers[0]);
+static std::atomic<uint32_t> readRetries(0);
+static std::atomic<uint32_t> publishCount(0);
+static unsigned long lastPrepare = 0;
+
+// Caller passes WARM_BOOT_DAYS schedules; one writer at a time
+void publishActiveSchedule(const DaySchedule* days) {
+  StorageLock lock;
+  ActiveSchedule* current = activeSchedule.load(std::memory_order_relaxed);
+  ActiveSchedule* spare = current == &scheduleBuffers[0] ? &scheduleBuffers[1] : &scheduleBuffers[0];
+
+  uint32_t seq = spare->seq.load(std::memory_order_relaxed);
+  spare->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(spare->days, days, sizeof(spare->days));
+  spare->seq.store(seq + 2, std::memory_order_release);
+
+  activeSchedule.store(spare, std::memory_order_release);
+  publishCount.fetch_add(1, std::memory_order_release);
+}
+
+// Lock-free; false if the day is not published or the copy kept racing a writer
+bool readActiveSchedule(int32_t dayNumber, DaySchedule& schedule) {
+  if (dayNumber == 0) {
+    return false;
+  }
+
+  for (int attempt = 0; attempt < ACTIVE_SCHEDULE_READ_ATTEMPTS; attempt++) {
+    const ActiveSchedule* current = activeSchedule.load(std::memory_order_acquire);
+    uint32_t before = current->seq.load(std::memory_order_acquire);
+    bool found = false;
+    if ((before & 1) == 0) {
+      for (int i = 0; i < WARM_BOOT_DAYS && !found; i++) {
+        if (current->days[i].dayNumber == dayNumber) {
+          schedule = current->days[i];
+          found = true;
+        }
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (current->seq.load(std::memory_order_relaxed) == before) {
+        return found && schedule.crc == dayScheduleCrc(schedule);
+      }
+    }
+    readRetries.fetch_add(1, std::memory_order_relaxed);
+  }
+  return false;
+}
+
+// Changes on every publish, so readers can tell their copy is stale
+uint32_t activeScheduleGeneration() {
+  return publishCount.load(std::memory_order_acquire);
+}
+
+// Loads tomorrow ahead of midnight and rolls the pair forward after it,
+// from loop() rather than the alert check
+void serviceActiveSchedule() {
+  if (millis() - lastPrepare < ACTIVE_SCHEDULE_PREPARE_INTERVAL) {
+    return;
+  }
+  lastPrepare = millis();
+
+  CivilDate today = getToday();
+  if (!isValidDate(today)) {
+    return;
+  }
+  int32_t todayNumber = daysFromCivil(today);
+  DaySchedule schedule;
+  if (readActiveSchedule(todayNumber, schedule) && readActiveSchedule(todayNumber + 1, schedule)) {
+    return;
+  }
+  refreshWarmBootSchedules(today);
+}
+
+void showActiveScheduleStatus() {
+  CivilDate today = getToday();
+  int32_t todayNumber = isValidDate(today) ? daysFromCivil(today) : 0;
+  DaySchedule schedule;
+
+  SerialBT.print(F("Alert schedule: today "));
+  SerialBT.print(readActiveSchedule(todayNumber, schedule) ? F("ready") : F("missing"));
+  SerialBT.print(F(", tomorrow "));
+  SerialBT.print(readActiveSchedule(todayNumber + 1, schedule) ? F("ready") : F("missing"));
+  SerialBT.print(F(" ("));
+  SerialBT.print(activeScheduleGeneration());
+  SerialBT.print(F(" swaps, "));
+  SerialBT.print(readRetries.load(std::memory_order_relaxed));
+  SerialBT.println(F(" read retries)"));
+}
@@ -0,0 +1,436 @@
+/*
+ * Aladhan API Client Implementation
+ * One keep-alive HTTP/1.1 connection to the API host with a cached DNS
+ * result. Multi-day fetches are pipelined: up to API_PIPELINE_DEPTH
+ * requests are in flight and answered in order on the same socket.
+ * Request starts stay API_REQUEST_INTERVAL apart to respect the API's rate limit.
+ * Bodies are requested gzip-compressed and inflated as they arrive.
+ */
+
+#include "global.h"
+#include <algorithm>
+
+static WiFiClient apiSocket;
+static IPAddress apiAddress;
+static unsigned long apiAddressResolvedAt = 0;
+static bool apiAddressValid = false;
+static uint32_t requestsOnConnection = 0;
+static unsigned long lastRequestAt = 0;
+static bool acceptGzip = false;
+static ApiClientStats stats = {0, 0, 0, 0, 0, 0, 0, 0, UINT32_MAX, 0, 0, 0, 0, 0};
+static uint32_t latencySamples[API_LATENCY_SAMPLES];
+
+// Where body bytes go: straight into the String, or through the gzip decoder
+struct ResponseBody {
+  String* body;
+  bool gzip;
+  size_t wireBytes;
+  int error;        // API_ERROR_* once the body cannot be used
+};
+
+static void recordLatency(uint32_t ms) {
+  latencySamples[stats.responses % API_LATENCY_SAMPLES] = ms;
+  stats.responses++;
+  stats.lastMs = ms;
+  stats.minMs = min(stats.minMs, ms);
+  stats.maxMs = max(stats.maxMs, ms);
+  stats.totalMs += ms;
+}
+
+static bool resolveApiHost() {
+  if (apiAddressValid && millis() - apiAddressResolvedAt < API_DNS_TTL) {
+    return true;
+  }
+
+  stats.dnsLookups++;
+  if (WiFi.hostByName(ALADHAN_API_HOST, apiAddress) != 1) {
+    debugPrintln("DNS lookup failed for " + String(ALADHAN_API_HOST));
+    apiAddressValid = false;
+    return false;
+  }
+  apiAddressValid = true;
+  apiAddressResolvedAt = millis();
+  return true;
+}
+
+static bool ensureConnected() {
+  if (apiSocket.connected()) {
+    return true;
+  }
+
+  apiSocket.stop();
+  requestsOnConnection = 0;
+  if (!isWiFiConnected() || !resolveApiHost()) {
+    return false;
+  }
+
+  if (!apiSocket.connect(apiAddress, ALADHAN_API_PORT, HTTP_TIMEOUT)) {
+    // The address may have moved; resolve again next time
+    apiAddressValid = false;
+    debugPrintln("API connect failed: " + apiAddress.toString());
+    return false;
+  }
+  apiSocket.setNoDelay(true);
+  stats.connections++;
+  return true;
+}
+
+static void sendRequest(const String& path) {
+  String request;
+  request.reserve(path.length() + 96);
+  request += "GET ";
+  request += path;
+  request += " HTTP/1.1\r\nHost: ";
+  request += ALADHAN_API_HOST;
+  request += "\r\nConnection: keep-alive\r\nAccept: application/json\r\n";
+  if (acceptGzip) {
+    request += "Accept-Encoding: gzip\r\n";
+  }
+  request += "\r\n";
+  apiSocket.write(reinterpret_cast<const uint8_t*>(request.c_str()), request.length());
+
+  if (requestsOnConnection > 0) {
+    stats.reusedRequests++;
+  }
+  requestsOnConnection++;
+}
+
+// Reads one CRLF-terminated line; false on timeout or closed socket
+static bool readLine(char* line, size_t size, unsigned long deadline) {
+  size_t length = 0;
+  while ((long)(deadline - millis()) > 0) {
+    if (!apiSocket.available()) {
+      if (!apiSocket.connected()) {
+        return false;
+      }
+      delay(1);
+      continue;
+    }
+    char c = apiSocket.read();
+    if (c == '\n') {
+      if (length > 0 && line[length - 1] == '\r') {
+        length--;
+      }
+      line[length] = '\0';
+      return true;
+    }
+    if (length + 1 < size) {
+      line[length++] = c;
+    }
+  }
+  return false;
+}
+
+static bool writeBody(ResponseBody& response, const uint8_t* data, size_t length) {
+  response.wireBytes += length;
+  if (!response.gzip) {
+    response.body->concat(reinterpret_cast<const char*>(data), length);
+    return true;
+  }
+
+  GzipStatus status = gzipInflateWrite(data, length);
+  if (status == GZIP_TOO_LARGE) {
+    response.error = API_ERROR_TOO_LARGE;
+  } else if (status == GZIP_FAILED) {
+    response.error = API_ERROR_DECODE;
+  }
+  return response.error == 0;
+}
+
+static bool readBody(ResponseBody& response, size_t length, unsigned long deadline) {
+  uint8_t buffer[256];
+  while (length > 0 && (long)(deadline - millis()) > 0) {
+    int available = apiSocket.available();
+    if (available <= 0) {
+      if (!apiSocket.connected()) {
+        return false;
+      }
+      delay(1);
+      continue;
+    }
+    int count = apiSocket.read(buffer, min((size_t)available, min(length, sizeof(buffer))));
+    if (count > 0) {
+      if (!writeBody(response, buffer, count)) {
+        return false;
+      }
+      length -= count;
+    }
+  }
+  return length == 0;
+}
+
+// Returns the HTTP status, or API_ERROR_* when the response was not read in full
+static int readResponse(String& body, bool& keepAlive) {
+  unsigned long deadline = millis() + HTTP_TIMEOUT;
+  char line[128];
+  body = "";
+  keepAlive = true;
+
+  if (!readLine(line, sizeof(line), deadline) || strncmp(line, "HTTP/1.", 7) != 0) {
+    return API_ERROR_CONNECTION;
+  }
+  int status = atoi(line + 9);
+  if (line[7] == '0') {
+    keepAlive = false; // HTTP/1.0 closes unless told otherwise
+  }
+
+  long contentLength = -1;
+  bool chunked = false;
+  ResponseBody response = {&body, false, 0, 0};
+  while (true) {
+    if (!readLine(line, sizeof(line), deadline)) {
+      return API_ERROR_CONNECTION;
+    }
+    if (line[0] == '\0') {
+      break;
+    }
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      contentLength = atol(line + 15);
+    } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 && strstr(line + 18, "chunked")) {
+      chunked = true;
+    } else if (strncasecmp(line, "Connection:", 11) == 0) {
+      keepAlive = strstr(line + 11, "close") == nullptr;
+    } else if (strncasecmp(line, "Content-Encoding:", 17) == 0 && strstr(line + 17, "gzip")) {
+      response.gzip = true;
+    }
+  }
+
+  if (response.gzip && !gzipInflateStart()) {
+    return API_ERROR_DECODE;
+  }
+
+  if (chunked) {
+    while (true) {
+      if (!readLine(line, sizeof(line), deadline)) {
+        return API_ERROR_CONNECTION;
+      }
+      size_t chunkLength = strtoul(line, nullptr, 16);
+      if (chunkLength == 0) {
+        readLine(line, sizeof(line), deadline); // Trailer end
+        break;
+      }
+      if (response.wireBytes + chunkLength > MAX_FILE_SIZE) {
+        return API_ERROR_TOO_LARGE;
+      }
+      if (!readBody(response, chunkLength, deadline) || !readLine(line, sizeof(line), deadline)) {
+        return response.error ? response.error : API_ERROR_CONNECTION;
+      }
+    }
+  } else if (contentLength >= 0) {
+    if (contentLength > MAX_FILE_SIZE) {
+      return API_ERROR_TOO_LARGE;
+    }
+    if (!response.gzip) {
+      body.reserve(contentLength);
+    }
+    if (!readBody(response, contentLength, deadline)) {
+      return response.error ? response.error : API_ERROR_CONNECTION;
+    }
+  } else {
+    // No framing: the body runs until the server closes
+    keepAlive = false;
+    if (!readBody(response, MAX_FILE_SIZE, deadline) && response.error) {
+      return response.error;
+    }
+  }
+
+  if (response.gzip) {
+    if (!gzipInflateFinish(body)) {
+      return API_ERROR_DECODE;
+    }
+    stats.gzipResponses++;
+  }
+  stats.wireBytes += response.wireBytes;
+  stats.bodyBytes += body.length();
+  return status;
+}
+
+// Percent-encodes every byte outside the RFC 3986 unreserved set, so names
+// with '&', '#', '+' or UTF-8 letters stay one query value
+static void appendQueryValue(String& out, const char* value) {
+  static const char hex[] = "0123456789ABCDEF";
+  for (const uint8_t* c = reinterpret_cast<const uint8_t*>(value); *c; c++) {
+    if (isalnum(*c) || *c == '-' || *c == '.' || *c == '_' || *c == '~') {
+      out += (char)*c;
+    } else {
+      out += '%';
+      out += hex[*c >> 4];
+      out += hex[*c & 0x0F];
+    }
+  }
+}
+
+String prayerTimesPath(const CivilDate& date) {
+  char dateKey[DATE_KEY_LENGTH + 1];
+  formatDateKey(date, dateKey);
+
+  String path;
+  path.reserve(sizeof(ALADHAN_API_PATH) + DATE_KEY_LENGTH + 3 * currentCity.length() + 64);
+  path += ALADHAN_API_PATH "/";
+  path += dateKey;
+  path += "?city=";
+  appendQueryValue(path, currentCity.c_str());
+  path += "&country=";
+  appendQueryValue(path, DEFAULT_COUNTRY);
+  path += "&method=";
+  path += PRAYER_METHOD;
+  return path;
+}
+
+int apiGetPipelined(const String* paths, int count, ApiResponseHandler handler, void* context) {
+  ApiLock socketLock; // One socket for every task
+  unsigned long sentAt[API_PIPELINE_DEPTH];
+  int sent = 0;
+  int received = 0;
+  int succeeded = 0;
+  int retries = 0;
+
+  // Without heap for the decoder the server is asked for plain bodies
+  acceptGzip = API_GZIP_ENABLED && gzipInflateReserve();
+
+  while (received < count) {
+    if (!ensureConnected()) {
+      break;
+    }
+    while (sent < count && sent - received < API_PIPELINE_DEPTH) {
+      // Keep the old one-request-per-second pace; the connection is still shared
+      unsigned long sinceLast = millis() - lastRequestAt;
+      if (sinceLast < API_REQUEST_INTERVAL) {
+        if (sent > received) {
+          break; // Read what is in flight while waiting
+        }
+        delay(API_REQUEST_INTERVAL - sinceLast);
+      }
+      lastRequestAt = millis();
+      sentAt[sent % API_PIPELINE_DEPTH] = lastRequestAt;
+      sendRequest(paths[sent]);
+      sent++;
+    }
+
+    String body;
+    bool keepAlive;
+    int status = readResponse(body, keepAlive);
+    if (status == API_ERROR_TOO_LARGE || status == API_ERROR_DECODE) {
+      // Unread body bytes leave the stream out of sync; fail this one and reconnect
+      apiSocket.stop();
+      stats.failures++;
+      handler(received, status, String(), context);
+      received++;
+      sent = received;
+      continue;
+    }
+    if (status < 0) {
+      // Lost the connection: resend everything still unanswered
+      apiSocket.stop();
+      stats.reconnects++;
+      stats.resentRequests += sent - received;
+      sent = received;
+      if (++retries > API_RETRY_LIMIT) {
+        break;
+      }
+      continue;
+    }
+
+    recordLatency(millis() - sentAt[received % API_PIPELINE_DEPTH]);
+    if (status == HTTP_CODE_OK) {
+      succeeded++;
+    } else {
+      stats.failures++;
+    }
+    handler(received, status, body, context);
+    received++;
+    retries = 0;
+
+    if (!keepAlive) {
+      // Requests sent after this response were dropped by the server
+      apiSocket.stop();
+      stats.resentRequests += sent - received;
+      sent = received;
+    }
+  }
+
+  for (int i = received; i < count; i++) {
+    stats.failures++;
+    handler(i, API_ERROR_CONNECTION, String(), context);
+  }
+  gzipInflateRelease();
+  return succeeded;
+}
+
+struct SingleResponse {
+  String* body;
+  int status;
+};
+
+static void storeSingleResponse(int index, int status, const String& body, void* context) {
+  SingleResponse* response = static_cast<SingleResponse*>(context);
+  response->status = status;
+  *response->body = body;
+}
+
+int apiGet(const String& path, String& body) {
+  SingleResponse response = {&body, API_ERROR_CONNECTION};
+  apiGetPipelined(&path, 1, storeSingleResponse, &response);
+  return response.status;
+}
+
+void apiClientClose() {
+  apiSocket.stop();
+  requestsOnConnection = 0;
+}
+
+const ApiClientStats& apiClientStats() {
+  return stats;
+}
+
+void resetApiClientStats() {
+  stats = ApiClientStats{0, 0, 0, 0, 0, 0, 0, 0, UINT32_MAX, 0, 0, 0, 0, 0};
+}
+
+// Percentile over the most recent API_LATENCY_SAMPLES responses
+uint32_t apiLatencyPercentile(int percent) {
+  int count = min(stats.responses, (uint32_t)API_LATENCY_SAMPLES);
+  if (count == 0) {
+    return 0;
+  }
+  uint32_t sorted[API_LATENCY_SAMPLES];
+  memcpy(sorted, latencySamples, count * sizeof(uint32_t));
+  std::sort(sorted, sorted + count);
+  return sorted[min(count - 1, (count * percent) / 100)];
+}
+
+void showApiClientStats() {
+  SerialBT.print(F("API client: "));
+  SerialBT.print(stats.responses);
+  SerialBT.print(F(" responses, "));
+  SerialBT.print(stats.connections);
+  SerialBT.print(F(" connections, "));
+  SerialBT.print(stats.reusedRequests);
+  SerialBT.print(F(" reused, "));
+  SerialBT.print(stats.dnsLookups);
+  SerialBT.print(F(" DNS lookups, "));
+  SerialBT.print(stats.failures);
+  SerialBT.print(F(" failed, "));
+  SerialBT.print(stats.resentRequests);
+  SerialBT.println(F(" resent"));
+
+  if (stats.responses > 0) {
+    SerialBT.print(F("API latency: last "));
+    SerialBT.print(stats.lastMs);
+    SerialBT.print(F(" ms, min "));
+    SerialBT.print(stats.minMs);
+    SerialBT.print(F(" / avg "));
+    SerialBT.print((uint32_t)(stats.totalMs / stats.responses));
+    SerialBT.print(F(" / max "));
+    SerialBT.print(stats.maxMs);
+    SerialBT.println(F(" ms"));
+
+    // Bytes on air drive radio-on time per cached day
+    char line[96];
+    snprintf(line, sizeof(line), "API transfer: %lu B on air, %lu B decoded (%.1fx), %lu B/response, %lu gzip",
+             (unsigned long)stats.wireBytes, (unsigned long)stats.bodyBytes,
+             stats.wireBytes > 0 ? (float)stats.bodyBytes / stats.wireBytes : 0.0f,
+             (unsigned long)(stats.wireBytes / stats.responses), (unsigned long)stats.gzipResponses);
+    SerialBT.println(line);
+  }
+}
@@ -0,0 +1,261 @@
+/*
+ * Audio Pipeline Implementation
+ * WAV parsing, PCM conversion and IMA-ADPCM decoding for the player.
+ * See audio_pipeline.h.
+ */
+
+#include "audio_pipeline.h"
+#include <string.h>
+
+// IMA-ADPCM step sizes and index adjustments (IMA Digital Audio Focus and
+// Technical Working Groups, 1992)
+static constexpr int16_t adpcmStepTable[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+  253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+  1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+  3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+  11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+  32767
+};
+
+static constexpr int8_t adpcmIndexTable[16] = {
+  -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+// Both per-nibble computations folded into tables indexed by [step][nibble],
+// so the decode loop is two loads, an add and a clamp per sample
+struct AdpcmTables {
+  int32_t delta[89][16];
+  uint8_t nextIndex[89][16];
+};
+
+static constexpr AdpcmTables buildAdpcmTables() {
+  AdpcmTables tables = {};
+  for (int index = 0; index < 89; index++) {
+    int step = adpcmStepTable[index];
+    for (int nibble = 0; nibble < 16; nibble++) {
+      int delta = step >> 3;
+      if (nibble & 4) delta += step;
+      if (nibble & 2) delta += step >> 1;
+      if (nibble & 1) delta += step >> 2;
+      tables.delta[index][nibble] = (nibble & 8) ? -delta : delta;
+
+      int next = index + adpcmIndexTable[nibble];
+      tables.nextIndex[index][nibble] = next < 0 ? 0 : (next > 88 ? 88 : next);
+    }
+  }
+  return tables;
+}
+
+static constexpr AdpcmTables adpcmTables = buildAdpcmTables();
+static_assert(adpcmTables.delta[0][7] == 11 && adpcmTables.delta[88][15] == -61436, "IMA-ADPCM delta table");
+
+static uint16_t readLe16(const uint8_t* bytes) {
+  return bytes[0] | (bytes[1] << 8);
+}
+
+static uint32_t readLe32(const uint8_t* bytes) {
+  return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static void writeLe16(uint8_t* bytes, uint16_t value) {
+  bytes[0] = value & 0xFF;
+  bytes[1] = value >> 8;
+}
+
+static void writeLe32(uint8_t* bytes, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    bytes[i] = (value >> (i * 8)) & 0xFF;
+  }
+}
+
+// Sources may return short reads (SD sectors, pipes); loop until done or EOF
+static size_t readFully(AudioStream& stream, uint8_t* buffer, size_t length) {
+  size_t total = 0;
+  while (total < length) {
+    size_t count = stream.read(buffer + total, length - total, stream.context);
+    if (count == 0) {
+      break;
+    }
+    total += count;
+  }
+  return total;
+}
+
+static bool skipBytes(AudioStream& stream, uint32_t length) {
+  while (length > 0) {
+    size_t count = length < sizeof(stream.raw) ? length : sizeof(stream.raw);
+    if (readFully(stream, stream.raw, count) != count) {
+      return false;
+    }
+    length -= count;
+  }
+  return true;
+}
+
+static bool formatSupported(const AudioFormat& format) {
+  if (format.channels < 1 || format.channels > 2 || format.sampleRate == 0) {
+    return false;
+  }
+  if (format.encoding == WAV_FORMAT_IMA_ADPCM) {
+    return format.channels == 1 && format.bitsPerSample == 4 && format.blockAlign > 4 &&
+           format.blockAlign <= AUDIO_READ_CHUNK && format.samplesPerBlock == (format.blockAlign - 4) * 2 + 1;
+  }
+  return format.encoding == WAV_FORMAT_PCM && (format.bitsPerSample == 8 || format.bitsPerSample == 16);
+}
+
+// Walks the RIFF chunks up to "data"; unknown chunks (LIST, fact) are skipped
+bool audioStreamOpen(AudioStream& stream, AudioReadFn read, void* context) {
+  memset(&stream.format, 0, sizeof(stream.format));
+  stream.read = read;
+  stream.context = context;
+  stream.remaining = 0;
+
+  uint8_t header[12];
+  if (readFully(stream, header, sizeof(header)) != sizeof(header) ||
+      memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+    return false;
+  }
+
+  bool haveFormat = false;
+  uint8_t chunk[8];
+  while (readFully(stream, chunk, sizeof(chunk)) == sizeof(chunk)) {
+    uint32_t size = readLe32(chunk + 4);
+    if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+      // ADPCM appends cbSize and samplesPerBlock to the PCM fields
+      uint8_t fmt[20] = {};
+      uint32_t used = size >= 20 ? 20 : 16;
+      if (readFully(stream, fmt, used) != used || !skipBytes(stream, size - used + (size & 1))) {
+        return false;
+      }
+      stream.format.encoding = readLe16(fmt);
+      stream.format.channels = readLe16(fmt + 2);
+      stream.format.sampleRate = readLe32(fmt + 4);
+      stream.format.blockAlign = readLe16(fmt + 12);
+      stream.format.bitsPerSample = readLe16(fmt + 14);
+      stream.format.samplesPerBlock = readLe16(fmt + 18);
+      haveFormat = true;
+    } else if (memcmp(chunk, "data", 4) == 0) {
+      stream.format.dataBytes = size;
+      stream.remaining = size;
+      return haveFormat && formatSupported(stream.format);
+    } else if (!skipBytes(stream, size + (size & 1))) {
+      return false;
+    }
+  }
+  return false;
+}
+
+size_t adpcmDecodeBlock(const uint8_t* block, size_t blockBytes, int16_t* out) {
+  if (blockBytes < 4) {
+    return 0;
+  }
+  int32_t predictor = (int16_t)readLe16(block);
+  uint8_t index = block[2] > 88 ? 88 : block[2];
+  int16_t* start = out;
+  *out++ = (int16_t)predictor;
+
+  // Low nibble first
+  for (const uint8_t* in = block + 4; in < block + blockBytes; in++) {
+    uint8_t nibble = *in & 0x0F;
+    predictor += adpcmTables.delta[index][nibble];
+    index = adpcmTables.nextIndex[index][nibble];
+    predictor = predictor < -32768 ? -32768 : (predictor > 32767 ? 32767 : predictor);
+    *out++ = (int16_t)predictor;
+
+    nibble = *in >> 4;
+    predictor += adpcmTables.delta[index][nibble];
+    index = adpcmTables.nextIndex[index][nibble];
+    predictor = predictor < -32768 ? -32768 : (predictor > 32767 ? 32767 : predictor);
+    *out++ = (int16_t)predictor;
+  }
+  return out - start;
+}
+
+// Whole blocks straight into the caller's buffer, no intermediate copy
+static size_t readAdpcm(AudioStream& stream, int16_t* out, size_t maxSamples) {
+  size_t produced = 0;
+  while (stream.remaining > 0 && maxSamples - produced >= stream.format.samplesPerBlock) {
+    size_t blockBytes = stream.remaining < stream.format.blockAlign ? stream.remaining : stream.format.blockAlign;
+    size_t bytes = readFully(stream, stream.raw, blockBytes);
+    if (bytes != blockBytes) {
+      stream.remaining = 0; // Truncated file: end the stream
+    } else {
+      stream.remaining -= bytes;
+    }
+    produced += adpcmDecodeBlock(stream.raw, bytes, out + produced);
+  }
+  return produced;
+}
+
+bool audioStreamEnded(const AudioStream& stream) {
+  return stream.remaining == 0;
+}
+
+// PCM to mono 16-bit; stereo is averaged, 8-bit is unsigned per the WAV spec
+size_t audioStreamRead(AudioStream& stream, int16_t* out, size_t maxSamples) {
+  const AudioFormat& format = stream.format;
+  if (format.encoding == WAV_FORMAT_IMA_ADPCM) {
+    return readAdpcm(stream, out, maxSamples);
+  }
+  size_t frameBytes = format.channels * (format.bitsPerSample / 8);
+  size_t frames = sizeof(stream.raw) / frameBytes;
+  if (frames > maxSamples) {
+    frames = maxSamples;
+  }
+  if (frames > stream.remaining / frameBytes) {
+    frames = stream.remaining / frameBytes;
+  }
+  if (frames == 0) {
+    stream.remaining = 0; // Only a partial frame was left
+    return 0;
+  }
+
+  size_t bytes = readFully(stream, stream.raw, frames * frameBytes);
+  stream.remaining = bytes == frames * frameBytes ? stream.remaining - bytes : 0;
+  frames = bytes / frameBytes;
+
+  const uint8_t* in = stream.raw;
+  for (size_t i = 0; i < frames; i++) {
+    int32_t sample = 0;
+    for (int channel = 0; channel < format.channels; channel++) {
+      if (format.bitsPerSample == 16) {
+        sample += (int16_t)readLe16(in);
+        in += 2;
+      } else {
+        sample += (*in++ - 128) << 8;
+      }
+    }
+    out[i] = (int16_t)(sample / format.channels);
+  }
+  return frames;
+}
+
+const char* audioFormatName(uint16_t encoding) {
+  switch (encoding) {
+    case WAV_FORMAT_PCM:
+      return "PCM";
+    case WAV_FORMAT_IMA_ADPCM:
+      return "IMA-ADPCM";
+    default:
+      return "unsupported";
+  }
+}
+
+void wavWriteHeader(AudioWriteFn write, void* context, uint32_t sampleRate, uint32_t dataBytes) {
+  uint8_t header[44];
+  memcpy(header, "RIFF", 4);
+  writeLe32(header + 4, 36 + dataBytes);
+  memcpy(header + 8, "WAVEfmt ", 8);
+  writeLe32(header + 16, 16);
+  writeLe16(header + 20, WAV_FORMAT_PCM);
+  writeLe16(header + 22, 1);
+  writeLe32(header + 24, sampleRate);
+  writeLe32(header + 28, sampleRate * 2);
+  writeLe16(header + 32, 2);
+  writeLe16(header + 34, 16);
+  memcpy(header + 36, "data", 4);
+  writeLe32(header + 40, dataBytes);
+  write(header, sizeof(header), context);
+}
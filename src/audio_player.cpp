@@ -0,0 +1,303 @@
+/*
+ * Audio Player Implementation
+ * Streams a WAV file from SD to I2S (external amp or the internal DAC).
+ * Two tasks on core 0 share the ping-pong buffers in audio_pipeline.h:
+ * the feeder reads and decodes the next buffer under StorageLock, the
+ * output task copies the previous one into the I2S DMA ring. Storage
+ * stalls (a cache write holding the lock, a slow SD sector) only delay the
+ * feeder; the player keeps up to two buffers plus the DMA ring queued.
+ */
+
+#include "global.h"
+#include "audio_pipeline.h"
+#include <driver/i2s.h>
+
+#define AUDIO_I2S_PORT I2S_NUM_0
+#define AUDIO_FEEDER_POLL_MS 5   // Feeder re-check while both buffers are queued
+
+static AudioPingPong pingPong;
+static AudioStream stream;
+static File audioFile;
+static String audioPath = "";
+
+static std::atomic<int> runningTasks(0);
+static std::atomic<bool> stopRequested(false);
+
+// Playback counters, reset per file
+static uint32_t buffersPlayed = 0;
+static uint32_t samplesPlayed = 0;
+static uint32_t lateBuffers = 0;        // Player found no full buffer, DMA ring still playing
+static uint32_t underruns = 0;          // Wait outlasted the DMA ring: audible silence
+static uint32_t longestWaitMicros = 0;
+static uint32_t slowestFillMicros = 0;  // Feeder time for one buffer
+static uint32_t bufferMicros = 0;       // Playback time of one full buffer
+
+static size_t readAudioFile(uint8_t* buffer, size_t length, void* context) {
+  StorageLock lock; // Shares the SPI bus and FS with the cache writers
+  return static_cast<File*>(context)->read(buffer, length);
+}
+
+static bool installI2S(uint32_t sampleRate) {
+  i2s_config_t config = {};
+  config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX | (AUDIO_USE_INTERNAL_DAC ? I2S_MODE_DAC_BUILT_IN : 0));
+  config.sample_rate = sampleRate;
+  config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+  config.channel_format = I2S_CHANNEL_FMT_ONLY_RIGHT;
+  config.communication_format = AUDIO_USE_INTERNAL_DAC ? I2S_COMM_FORMAT_STAND_MSB : I2S_COMM_FORMAT_STAND_I2S;
+  config.dma_buf_count = AUDIO_DMA_BUFFERS;
+  config.dma_buf_len = AUDIO_DMA_BUFFER_LEN;
+  config.tx_desc_auto_clear = true; // Silence, not a repeated buffer, on underrun
+
+  if (i2s_driver_install(AUDIO_I2S_PORT, &config, 0, nullptr) != ESP_OK) {
+    return false;
+  }
+  if (AUDIO_USE_INTERNAL_DAC) {
+    i2s_set_pin(AUDIO_I2S_PORT, nullptr);
+    i2s_set_dac_mode(I2S_DAC_CHANNEL_RIGHT_EN);
+  } else {
+    i2s_pin_config_t pins = {};
+    pins.mck_io_num = I2S_PIN_NO_CHANGE;
+    pins.bck_io_num = AUDIO_I2S_BCLK_PIN;
+    pins.ws_io_num = AUDIO_I2S_LRCK_PIN;
+    pins.data_out_num = AUDIO_I2S_DOUT_PIN;
+    pins.data_in_num = I2S_PIN_NO_CHANGE;
+    i2s_set_pin(AUDIO_I2S_PORT, &pins);
+  }
+  i2s_zero_dma_buffer(AUDIO_I2S_PORT);
+  return true;
+}
+
+// Decodes until the buffer is full or the data chunk ends; false at the end
+static bool fillBuffer(int16_t* buffer) {
+  uint32_t started = micros();
+  size_t samples = 0;
+  while (samples < AudioPingPong::capacity()) {
+    size_t count = audioStreamRead(stream, buffer + samples, AudioPingPong::capacity() - samples);
+    if (count == 0) {
+      break;
+    }
+    samples += count;
+  }
+  bool last = audioStreamEnded(stream);
+  pingPong.commitFill(samples, last);
+
+  uint32_t elapsed = micros() - started;
+  if (elapsed > slowestFillMicros) {
+    slowestFillMicros = elapsed;
+  }
+  return !last;
+}
+
+// Last task out closes the file and releases the I2S driver
+static void releaseTask() {
+  if (runningTasks.fetch_sub(1) == 1) {
+    {
+      StorageLock lock;
+      audioFile.close();
+    }
+    i2s_driver_uninstall(AUDIO_I2S_PORT);
+    Serial.printf("Audio: finished %s, %lu underruns\n", audioPath.c_str(), (unsigned long)underruns);
+  }
+}
+
+static void finishTask() {
+  releaseTask();
+  vTaskDelete(nullptr);
+}
+
+static void audioFeederTask(void* parameter) {
+  bool more = true;
+  while (more && !stopRequested.load()) {
+    int16_t* buffer = pingPong.acquireFill();
+    if (buffer == nullptr) {
+      vTaskDelay(pdMS_TO_TICKS(AUDIO_FEEDER_POLL_MS));
+      continue;
+    }
+    more = fillBuffer(buffer);
+  }
+  finishTask();
+}
+
+static void audioOutputTask(void* parameter) {
+  // i2s_write() returns once the last chunk is queued, so the ring is about full
+  const uint32_t ringMicros = (uint32_t)((uint64_t)AUDIO_DMA_BUFFERS * AUDIO_DMA_BUFFER_LEN * 1000000ULL /
+                                         stream.format.sampleRate);
+  bool waiting = false;
+  uint32_t waitStarted = 0;
+  while (true) {
+    size_t samples;
+    bool last;
+    int16_t* buffer = pingPong.acquirePlay(samples, last);
+    if (buffer == nullptr) {
+      if (stopRequested.load()) {
+        break;
+      }
+      if (!waiting) {
+        lateBuffers++;
+        waiting = true;
+        waitStarted = micros();
+      }
+      vTaskDelay(1);
+      continue;
+    }
+    if (waiting) {
+      // The ring played out and then cleared to silence if the wait was longer
+      uint32_t waited = micros() - waitStarted;
+      if (waited > ringMicros) {
+        underruns++;
+      }
+      if (waited > longestWaitMicros) {
+        longestWaitMicros = waited;
+      }
+      waiting = false;
+    }
+
+    if (AUDIO_USE_INTERNAL_DAC) {
+      // The DAC takes the high byte as unsigned
+      for (size_t i = 0; i < samples; i++) {
+        buffer[i] ^= 0x8000;
+      }
+    }
+    size_t written;
+    i2s_write(AUDIO_I2S_PORT, buffer, samples * sizeof(int16_t), &written, portMAX_DELAY);
+    pingPong.releasePlay();
+    buffersPlayed++;
+    samplesPlayed += samples;
+
+    if (last || stopRequested.load()) {
+      break;
+    }
+  }
+  // Let the queued DMA descriptors drain before the driver is removed
+  vTaskDelay(pdMS_TO_TICKS(AUDIO_DMA_BUFFERS * AUDIO_DMA_BUFFER_LEN * 1000UL / stream.format.sampleRate + 1));
+  finishTask();
+}
+
+bool startAudioPlayback(const char* path) {
+  if (!AUDIO_ENABLED || audioPlaying() || !sdCardInitialized) {
+    return false;
+  }
+
+  {
+    StorageLock lock;
+    if (!SD.exists(path)) {
+      return false;
+    }
+    audioFile = SD.open(path, FILE_READ);
+  }
+  if (!audioFile) {
+    return false;
+  }
+  if (!audioStreamOpen(stream, readAudioFile, &audioFile)) {
+    Serial.printf("Audio: %s is not a supported WAV file (%s, %u-bit, %u ch)\n", path,
+                  audioFormatName(stream.format.encoding), stream.format.bitsPerSample, stream.format.channels);
+    StorageLock lock;
+    audioFile.close();
+    return false;
+  }
+  if (!installI2S(stream.format.sampleRate)) {
+    Serial.println(F("Audio: I2S driver install failed"));
+    StorageLock lock;
+    audioFile.close();
+    return false;
+  }
+
+  audioPath = path;
+  buffersPlayed = 0;
+  samplesPlayed = 0;
+  lateBuffers = 0;
+  underruns = 0;
+  longestWaitMicros = 0;
+  slowestFillMicros = 0;
+  bufferMicros = (uint32_t)((uint64_t)AudioPingPong::capacity() * 1000000ULL / stream.format.sampleRate);
+  stopRequested.store(false);
+  pingPong.reset();
+
+  // Prime both buffers so playback starts with the full margin
+  if (fillBuffer(pingPong.acquireFill())) {
+    fillBuffer(pingPong.acquireFill());
+  }
+
+  runningTasks.store(2);
+  if (xTaskCreatePinnedToCore(audioFeederTask, "audio_feed", AUDIO_FEEDER_STACK, nullptr,
+                              AUDIO_FEEDER_PRIORITY, nullptr, AUDIO_TASK_CORE) != pdPASS) {
+    runningTasks.store(0);
+    i2s_driver_uninstall(AUDIO_I2S_PORT);
+    StorageLock lock;
+    audioFile.close();
+    return false;
+  }
+  if (xTaskCreatePinnedToCore(audioOutputTask, "audio_out", AUDIO_OUTPUT_STACK, nullptr,
+                              AUDIO_OUTPUT_PRIORITY, nullptr, AUDIO_TASK_CORE) != pdPASS) {
+    // The feeder stops on its own and cleans up as the last task
+    stopRequested.store(true);
+    releaseTask();
+    return false;
+  }
+
+  Serial.printf("Audio: playing %s (%s, %lu Hz, %u ch)\n", path, audioFormatName(stream.format.encoding),
+                (unsigned long)stream.format.sampleRate, stream.format.channels);
+  return true;
+}
+
+void stopAudioPlayback() {
+  if (audioPlaying()) {
+    stopRequested.store(true);
+  }
+}
+
+bool audioPlaying() {
+  return runningTasks.load() > 0;
+}
+
+// Decode throughput on a synthetic 512-byte block, as a share of one core
+void runAudioBenchmark(int blocks) {
+  static uint8_t block[512];
+  static int16_t decoded[(sizeof(block) - 4) * 2 + 1];
+  uint32_t seed = 1;
+  for (size_t i = 0; i < sizeof(block); i++) {
+    seed = seed * 1103515245 + 12345;
+    block[i] = seed >> 16;
+  }
+  block[2] = 40; // Mid-range step index
+
+  uint32_t started = micros();
+  uint32_t samples = 0;
+  for (int i = 0; i < blocks; i++) {
+    samples += adpcmDecodeBlock(block, sizeof(block), decoded);
+  }
+  uint32_t elapsed = micros() - started;
+
+  float samplesPerSecond = samples * 1000000.0f / elapsed;
+  float cyclesPerSample = (float)ESP.getCpuFreqMHz() * elapsed / samples;
+  SerialBT.printf("IMA-ADPCM decode: %lu samples in %lu us, %.2f Msamples/s, %.1f cycles/sample\n",
+                  (unsigned long)samples, (unsigned long)elapsed, samplesPerSecond / 1e6f, cyclesPerSample);
+  SerialBT.printf("Core load for 16 kHz playback: %.3f%% at %lu MHz\n", 16000.0f * 100.0f / samplesPerSecond,
+                  (unsigned long)ESP.getCpuFreqMHz());
+}
+
+void showAudioStatus() {
+  SerialBT.print(F("Audio: "));
+  if (audioPath.length() == 0) {
+    SerialBT.println(sdCardInitialized ? F("idle") : F("no SD card"));
+    return;
+  }
+  SerialBT.print(audioPlaying() ? F("playing ") : F("last played "));
+  SerialBT.print(audioPath);
+  SerialBT.print(F(" ("));
+  SerialBT.print(samplesPlayed / stream.format.sampleRate);
+  SerialBT.print(F(" s, "));
+  SerialBT.print(buffersPlayed);
+  SerialBT.print(F(" buffers, "));
+  SerialBT.print(lateBuffers);
+  SerialBT.print(F(" late, "));
+  SerialBT.print(underruns);
+  SerialBT.print(F(" underruns, longest wait "));
+  SerialBT.print(longestWaitMicros / 1000);
+  SerialBT.println(F(" ms)"));
+  SerialBT.print(F("Audio feeder: slowest buffer "));
+  SerialBT.print(slowestFillMicros / 1000);
+  SerialBT.print(F(" ms of "));
+  SerialBT.print(bufferMicros / 1000);
+  SerialBT.println(F(" ms budget"));
+}
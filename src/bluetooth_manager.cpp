@@ -0,0 +1,114 @@
+/*
+ * Bluetooth Manager Implementation
+ * Bluetooth Classic runs only inside a configuration window (after boot or
+ * a long press of the trigger button) and is torn down afterwards, so its
+ * heap goes back to HTTP and JSON. BLE controller memory is never used and
+ * is released at startup.
+ */
+
+#include "global.h"
+#include <esp_bt.h>
+
+static unsigned long windowLastActivity = 0;
+static unsigned long windowLength = 0;
+static unsigned long triggerPressedAt = 0;
+static uint32_t bleReleasedBytes = 0;
+static uint32_t classicStackBytes = 0;
+
+// Must run before anything initialises the BT controller
+void releaseBleControllerMemory() {
+  uint32_t heapBefore = ESP.getFreeHeap();
+  if (esp_bt_controller_mem_release(ESP_BT_MODE_BLE) == ESP_OK) {
+    bleReleasedBytes = ESP.getFreeHeap() - heapBefore;
+    debugPrintln("BLE controller memory released: " + String(bleReleasedBytes) + " bytes");
+  }
+
+  pinMode(BT_TRIGGER_PIN, INPUT_PULLUP);
+}
+
+bool openBluetoothWindow(unsigned long durationMs) {
+  windowLastActivity = millis();
+  windowLength = durationMs;
+  if (bluetoothConnected) {
+    return true;
+  }
+
+  // Classic-only controller; the default mode would also claim BLE memory
+  uint32_t heapBefore = ESP.getFreeHeap();
+  if (!btStartMode(BT_MODE_CLASSIC_BT) || !SerialBT.begin(BLUETOOTH_NAME)) {
+    debugPrintln("ERROR: Bluetooth initialization failed");
+    return false;
+  }
+
+  bluetoothConnected = true;
+  classicStackBytes = heapBefore - ESP.getFreeHeap();
+  debugPrintln("Bluetooth window open: " + String(BLUETOOTH_NAME) + " for " + String(durationMs / 60000) +
+               " min (" + String(classicStackBytes) + " bytes heap)");
+  return true;
+}
+
+void closeBluetoothWindow() {
+  if (!bluetoothConnected) {
+    return;
+  }
+
+  uint32_t heapBefore = ESP.getFreeHeap();
+  SerialBT.end();
+  bluetoothConnected = false;
+  waitingForInput = false;
+  inputPrompt = "";
+  debugPrintln("Bluetooth window closed, " + String(ESP.getFreeHeap() - heapBefore) + " bytes heap recovered");
+}
+
+void noteBluetoothActivity() {
+  windowLastActivity = millis();
+}
+
+// Without saved WiFi the menu is the only way to configure the device
+static bool bluetoothRequired() {
+  return isFirstBoot || savedSSID.length() == 0 || waitingForInput || SerialBT.hasClient() || bulkUploadActive();
+}
+
+void serviceBluetoothWindow() {
+  // Long press on the trigger button opens a fresh window
+  if (digitalRead(BT_TRIGGER_PIN) == LOW) {
+    if (triggerPressedAt == 0) {
+      triggerPressedAt = millis();
+    } else if (millis() - triggerPressedAt >= BT_TRIGGER_HOLD_MS && !bluetoothConnected) {
+      openBluetoothWindow(BT_WINDOW_MINUTES * 60000UL);
+    }
+  } else {
+    triggerPressedAt = 0;
+  }
+
+  if (!bluetoothConnected) {
+    return;
+  }
+  if (bluetoothRequired()) {
+    windowLastActivity = millis();
+    return;
+  }
+  if (millis() - windowLastActivity >= windowLength) {
+    closeBluetoothWindow();
+  }
+}
+
+void showBluetoothStatus() {
+  SerialBT.print(F("Bluetooth: "));
+  if (bluetoothConnected) {
+    unsigned long idle = millis() - windowLastActivity;
+    SerialBT.print(F("Active ("));
+    SerialBT.print(BLUETOOTH_NAME);
+    SerialBT.print(F("), closes after "));
+    SerialBT.print(idle < windowLength ? (windowLength - idle) / 1000 : 0);
+    SerialBT.println(F(" s idle"));
+  } else {
+    SerialBT.println(F("Off"));
+  }
+
+  SerialBT.print(F("BT heap: "));
+  SerialBT.print(bleReleasedBytes);
+  SerialBT.print(F(" bytes BLE released, "));
+  SerialBT.print(classicStackBytes);
+  SerialBT.println(F(" bytes returned when the window closes"));
+}
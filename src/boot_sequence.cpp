@@ -0,0 +1,165 @@
+/*
+ * Boot Sequence Implementation
+ * Brings up the alert path first, mounts storage while Bluetooth starts,
+ * and leaves WiFi, NTP and the first fetch to a background task.
+ * Every stage is timed for the status screen.
+ */
+
+#include "global.h"
+#include <esp_timer.h>
+
+SemaphoreHandle_t storageMutex = nullptr;
+SemaphoreHandle_t apiMutex = nullptr;
+
+struct BootStageTiming {
+  int64_t startMicros;
+  int64_t endMicros;
+  bool ok;
+};
+
+static const char* const bootStageNames[BOOT_STAGE_COUNT] = {
+  "Settings", "RTC", "Buzzer", "Display", "Storage", "Bluetooth", "WiFi", "NTP", "Fetch"
+};
+
+static BootStageTiming bootStages[BOOT_STAGE_COUNT];
+static SemaphoreHandle_t storageReady = nullptr;
+static volatile bool bootNetworkRunning = false;
+
+static void beginBootStage(BootStage stage) {
+  bootStages[stage].startMicros = esp_timer_get_time();
+  bootStages[stage].endMicros = 0;
+}
+
+static void endBootStage(BootStage stage, bool ok) {
+  bootStages[stage].endMicros = esp_timer_get_time();
+  bootStages[stage].ok = ok;
+}
+
+// SD card and flash tier, in parallel with Bluetooth on the setup task
+static void storageInitTask(void* parameter) {
+  beginBootStage(BOOT_STAGE_STORAGE);
+  initializeSDCard();
+  initializeFlashCache();
+  endBootStage(BOOT_STAGE_STORAGE, sdCardInitialized || flashCacheInitialized);
+
+  xSemaphoreGive(storageReady);
+  vTaskDelete(nullptr);
+}
+
+static void bootNetworkTask(void* parameter) {
+  beginBootStage(BOOT_STAGE_WIFI);
+  bool connected = connectToWiFi(savedSSID, savedPassword);
+  endBootStage(BOOT_STAGE_WIFI, connected);
+
+  if (connected) {
+    beginBootStage(BOOT_STAGE_NTP);
+    syncTimeWithNTP();
+    endBootStage(BOOT_STAGE_NTP, true);
+
+    // A warm boot or the flash tier may already hold today's schedule
+    beginBootStage(BOOT_STAGE_FETCH);
+    DaySchedule schedule;
+    bool cached = readActiveSchedule(daysFromCivil(getToday()), schedule);
+    if (!cached) {
+      fetchPrayerTimes();
+    }
+    endBootStage(BOOT_STAGE_FETCH, true);
+  }
+
+  debugPrintln("Boot network stage finished (" + String((uint32_t)(esp_timer_get_time() / 1000)) + " ms)");
+  bootNetworkRunning = false;
+  vTaskDelete(nullptr);
+}
+
+void runBootSequence() {
+  storageMutex = xSemaphoreCreateRecursiveMutex();
+  apiMutex = xSemaphoreCreateRecursiveMutex();
+  initializeSystemEvents();
+  releaseBleControllerMemory();
+
+  // Alert path: RTC memory snapshot (warm boot), clock and buzzer
+  bool warm = restoreWarmBoot();
+
+  beginBootStage(BOOT_STAGE_SETTINGS);
+  preferences.begin("prayer_times", false);
+  if (!warm) {
+    loadSettings();
+  }
+  endBootStage(BOOT_STAGE_SETTINGS, true);
+
+  beginBootStage(BOOT_STAGE_RTC);
+  initializeRTC();
+  endBootStage(BOOT_STAGE_RTC, rtcInitialized);
+
+  beginBootStage(BOOT_STAGE_BUZZER);
+  initializeBuzzer();
+  endBootStage(BOOT_STAGE_BUZZER, buzzerInitialized);
+
+  if (warm) {
+    checkPrayerAlerts();
+    dispatchSystemEvents(); // An alert due right now should not wait for loop()
+  }
+
+  beginBootStage(BOOT_STAGE_DISPLAY);
+  initializeDisplay();
+  endBootStage(BOOT_STAGE_DISPLAY, true);
+
+  // Storage and Bluetooth share nothing, so they start together
+  storageReady = xSemaphoreCreateBinary();
+  if (xTaskCreatePinnedToCore(storageInitTask, "boot_storage", BOOT_STORAGE_STACK, nullptr, 1, nullptr, 0) != pdPASS) {
+    storageInitTask(nullptr);
+  }
+
+  beginBootStage(BOOT_STAGE_BLUETOOTH);
+  openBluetoothWindow(BT_WINDOW_MINUTES * 60000UL);
+  endBootStage(BOOT_STAGE_BLUETOOTH, bluetoothConnected);
+
+  xSemaphoreTake(storageReady, portMAX_DELAY);
+  vSemaphoreDelete(storageReady);
+  storageReady = nullptr;
+
+  // Cold boot: today's schedule from the flash tier or SD
+  checkPrayerAlerts();
+
+  // Waits on its own for WiFi, the clock and the boot network task
+  startCachePrefetcher();
+  debugPrintln("System initialization complete");
+}
+
+// WiFi, NTP and the first fetch run on core 0 while loop() keeps the clock and alerts going
+void startBootNetwork() {
+  if (savedSSID.length() == 0) {
+    return;
+  }
+
+  bootNetworkRunning = true;
+  if (xTaskCreatePinnedToCore(bootNetworkTask, "boot_network", BOOT_NETWORK_STACK, nullptr, 1, nullptr, 0) != pdPASS) {
+    debugPrintln("ERROR: Could not start boot network task, loop() will reconnect");
+    bootNetworkRunning = false;
+  }
+}
+
+bool bootNetworkActive() {
+  return bootNetworkRunning;
+}
+
+void showBootTimeline() {
+  SerialBT.println(F("Boot timeline (ms from start):"));
+  for (int i = 0; i < BOOT_STAGE_COUNT; i++) {
+    const BootStageTiming& stage = bootStages[i];
+    if (stage.startMicros == 0) {
+      continue;
+    }
+
+    char line[64];
+    if (stage.endMicros == 0) {
+      snprintf(line, sizeof(line), "  %-10s %6lu  running",
+               bootStageNames[i], (unsigned long)(stage.startMicros / 1000));
+    } else {
+      snprintf(line, sizeof(line), "  %-10s %6lu  +%lu ms%s",
+               bootStageNames[i], (unsigned long)(stage.startMicros / 1000),
+               (unsigned long)((stage.endMicros - stage.startMicros) / 1000), stage.ok ? "" : " (failed)");
+    }
+    SerialBT.println(line);
+  }
+}
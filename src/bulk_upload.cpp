@@ -0,0 +1,472 @@
+/*
+ * Bulk Schedule Upload Implementation
+ * Takes compact schedule records over SerialBT (protocol in bulk_protocol.h)
+ * for sites without WiFi. Two tasks on core 0 split the work: the reader
+ * drains the Bluetooth receive queue, checks frames and acknowledges them
+ * as soon as they are queued; the store task writes the records to SD and,
+ * for the current city, the flash tier. The send window is the free space
+ * in the chunk queue, so a slow SD card throttles the host instead of
+ * overflowing the receive queue. loop() stops reading commands meanwhile.
+ */
+
+#include "global.h"
+#include "bulk_protocol.h"
+#include "spsc_queue.h"
+
+struct UploadChunk {
+  uint16_t sequence;
+  uint16_t length;        // 0: nothing to store, the chunk only advances the sequence
+  uint8_t payload[BULK_MAX_PAYLOAD];
+};
+
+// Last chunk stored for a session, kept in NVS so a dropped link can resume
+struct BulkResumePoint {
+  uint32_t sessionId;
+  uint16_t nextChunk;
+  uint16_t chunkCount;
+};
+
+typedef SpscQueue<UploadChunk, BULK_QUEUE_CHUNKS> UploadQueue;
+
+static UploadQueue* chunkQueue = nullptr;      // Allocated per session, about 7 KB
+static BulkFrameParser* frameParser = nullptr;
+static std::atomic<int> runningTasks(0);
+static std::atomic<bool> uploadActive(false);  // Cleared only after the last task has reported
+static std::atomic<bool> stopRequested(false);
+static std::atomic<uint16_t> storedNext(0);    // Chunks below this are stored
+
+// Session state; the reader owns it, the last task out reports it
+static uint32_t sessionId = 0;
+static uint16_t chunkCount = 0;
+static bool sessionStarted = false;
+static bool sessionComplete = false;
+static uint16_t expectedChunk = 0;
+static bool nakSent = false;
+static uint16_t lastOutOfOrder = 0;      // Highest chunk seen past the gap since the NAK
+static uint16_t advertisedWindow = 0;
+static uint16_t advertisedStored = 0;
+static unsigned long sessionStartedAt = 0;
+static const char* endReason = "";
+
+// Each task counts into its own copy. They are merged only once the store
+// task has caught up (storedNext) or both tasks are done (runningTasks).
+static BulkUploadStats readerStats;   // Link counters and malformed chunks
+static BulkUploadStats storeStats;    // stored, unchanged, skipped and rejected records
+static BulkUploadStats lastStats;
+static bool haveLastStats = false;
+
+static BulkUploadStats mergedStats() {
+  BulkUploadStats total = readerStats;
+  total.stored = storeStats.stored;
+  total.unchanged = storeStats.unchanged;
+  total.skipped = storeStats.skipped;
+  total.rejected += storeStats.rejected;
+  total.elapsedMs = millis() - sessionStartedAt;
+  return total;
+}
+
+static uint16_t windowEnd() {
+  uint32_t end = storedNext.load() + UploadQueue::capacity();
+  return end < chunkCount ? end : chunkCount;
+}
+
+static void sendFrame(uint8_t type, uint16_t sequence, const void* payload, uint16_t length) {
+  uint8_t frame[sizeof(BulkFrameHeader) + sizeof(BulkUploadStats) + sizeof(uint32_t)];
+  size_t size = encodeBulkFrame(frame, type, sequence, payload, length);
+  SerialBT.write(frame, size);
+}
+
+static void sendAck(uint8_t type) {
+  BulkAck ack = {windowEnd(), storedNext.load()};
+  advertisedWindow = ack.windowEnd;
+  advertisedStored = ack.storedChunks;
+  sendFrame(type, expectedChunk, &ack, sizeof(ack));
+}
+
+// Go-back-N: one NAK per gap, the host's timeout covers a lost NAK
+static void requestResend() {
+  if (sessionStarted && !nakSent) {
+    sendAck(BULK_NAK);
+    nakSent = true;
+  }
+}
+
+static void saveResumePoint() {
+  StorageLock lock;
+  BulkResumePoint point = {sessionId, storedNext.load(), chunkCount};
+  preferences.putBytes(BULK_RESUME_KEY, &point, sizeof(point));
+}
+
+static uint16_t loadResumePoint(uint32_t id, uint16_t count) {
+  StorageLock lock;
+  BulkResumePoint point;
+  if (preferences.getBytes(BULK_RESUME_KEY, &point, sizeof(point)) != sizeof(point) ||
+      point.sessionId != id || point.chunkCount != count || point.nextChunk > count) {
+    return 0;
+  }
+  return point.nextChunk;
+}
+
+// --- Store task ---
+
+static bool validRecord(const DaySchedule& record) {
+  if (record.crc != dayScheduleCrc(record) || !isValidDate(civilFromDays(record.dayNumber))) {
+    return false;
+  }
+  for (int i = 0; i < PRAYER_COUNT; i++) {
+    if (record.minutes[i] >= 1440) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void storeRecord(const String& city, const char* zone, const DaySchedule& record) {
+  if (!validRecord(record)) {
+    storeStats.rejected++;
+    return;
+  }
+  CivilDate date = civilFromDays(record.dayNumber);
+
+  StorageLock lock;
+  bool written = false;
+  bool unchanged = false;
+  if (sdCardInitialized) {
+    char body[DAY_JSON_LENGTH];
+    size_t length = formatDayScheduleJson(body, sizeof(body), record, zone);
+    uint32_t checksum = cacheCrc32(reinterpret_cast<const uint8_t*>(body), length);
+    // Same file already on the card: a resumed or repeated upload costs no SD write
+    if (isDayCached(city, date) && getCachedDayChecksum(city, date) == checksum) {
+      unchanged = true;
+    } else {
+      written = saveCacheDayToSD(city, date, String(body));
+    }
+  }
+  if (city == currentCity && storeDaySchedule(record)) {
+    written = written || !unchanged;
+  }
+
+  if (written) {
+    storeStats.stored++;
+  } else if (unchanged) {
+    storeStats.unchanged++;
+  } else {
+    storeStats.skipped++;
+  }
+}
+
+static void storeChunk(const UploadChunk& chunk) {
+  if (chunk.length == 0) {
+    return;
+  }
+  BulkChunkHeader header;
+  memcpy(&header, chunk.payload, sizeof(header));
+  size_t recordsAt = sizeof(header) + header.cityLength + header.zoneLength;
+
+  // Checked by the reader; names are copied out so the records stay unaligned-safe
+  char city[BULK_NAME_LENGTH + 1];
+  char zone[BULK_NAME_LENGTH + 1];
+  memcpy(city, chunk.payload + sizeof(header), header.cityLength);
+  city[header.cityLength] = '\0';
+  memcpy(zone, chunk.payload + sizeof(header) + header.cityLength, header.zoneLength);
+  zone[header.zoneLength] = '\0';
+  String cityName(city);
+
+  for (int i = 0; i < header.recordCount; i++) {
+    DaySchedule record;
+    memcpy(&record, chunk.payload + recordsAt + i * sizeof(DaySchedule), sizeof(record));
+    storeRecord(cityName, zone, record);
+  }
+}
+
+static void releaseTask();
+
+static void uploadStoreTask(void* parameter) {
+  static UploadChunk chunk; // One task at a time; keeps the chunk off the stack
+  while (true) {
+    if (chunkQueue->pop(chunk)) {
+      storeChunk(chunk);
+      storedNext.store(chunk.sequence + 1);
+      if ((chunk.sequence + 1) % BULK_RESUME_EVERY == 0) {
+        saveResumePoint();
+      }
+      continue;
+    }
+    if (stopRequested.load()) {
+      break;
+    }
+    vTaskDelay(pdMS_TO_TICKS(2));
+  }
+  releaseTask();
+  vTaskDelete(nullptr);
+}
+
+// --- Reader task ---
+
+static bool validChunk(const uint8_t* payload, uint16_t length) {
+  BulkChunkHeader header;
+  if (length < sizeof(header)) {
+    return false;
+  }
+  memcpy(&header, payload, sizeof(header));
+  return header.cityLength > 0 && header.cityLength <= MAX_CITY_NAME_LENGTH &&
+         header.zoneLength <= BULK_NAME_LENGTH && header.recordCount <= BULK_CHUNK_RECORDS &&
+         length == sizeof(header) + header.cityLength + header.zoneLength + header.recordCount * sizeof(DaySchedule);
+}
+
+static void beginSession(const uint8_t* payload, uint16_t length) {
+  BulkBegin begin;
+  if (length != sizeof(begin)) {
+    return;
+  }
+  memcpy(&begin, payload, sizeof(begin));
+  if (begin.version != BULK_PROTOCOL_VERSION) {
+    sendFrame(BULK_ABORT, 0, nullptr, 0);
+    return;
+  }
+
+  // A repeated BEGIN (lost READY) restarts from what is stored, not from zero
+  if (!sessionStarted || begin.sessionId != sessionId) {
+    // A different upload replaces this one: the store task finishes the chunks
+    // already queued first, so none of them moves storedNext or the counters
+    while (sessionStarted && storedNext.load() != expectedChunk) {
+      vTaskDelay(pdMS_TO_TICKS(2));
+    }
+    sessionId = begin.sessionId;
+    chunkCount = begin.chunkCount;
+    storedNext.store(loadResumePoint(sessionId, chunkCount));
+    expectedChunk = storedNext.load();
+    memset(&readerStats, 0, sizeof(readerStats));
+    memset(&storeStats, 0, sizeof(storeStats));
+    sessionStartedAt = millis();
+    sessionStarted = true;
+  }
+  nakSent = false;
+
+  BulkReady ready = {sessionId, expectedChunk, windowEnd(), BULK_CHUNK_RECORDS, 0};
+  advertisedWindow = ready.windowEnd;
+  advertisedStored = storedNext.load();
+  sendFrame(BULK_READY, 0, &ready, sizeof(ready));
+}
+
+static void receiveChunk(const BulkFrameHeader& header, const uint8_t* payload) {
+  if (header.sequence < expectedChunk) {
+    readerStats.duplicates++; // Our ACK was lost or the host went back too far
+    sendAck(BULK_ACK);
+    return;
+  }
+  if (header.sequence > expectedChunk || header.sequence >= windowEnd()) {
+    readerStats.outOfOrder++;
+    // Lower than before: the host went back and lost the first chunk again
+    if (header.sequence <= lastOutOfOrder) {
+      nakSent = false;
+    }
+    lastOutOfOrder = header.sequence;
+    requestResend();
+    return;
+  }
+
+  static UploadChunk chunk;
+  chunk.sequence = header.sequence;
+  chunk.length = 0;
+  if (validChunk(payload, header.length)) {
+    chunk.length = header.length;
+    memcpy(chunk.payload, payload, header.length);
+    BulkChunkHeader chunkHeader;
+    memcpy(&chunkHeader, payload, sizeof(chunkHeader));
+    readerStats.records += chunkHeader.recordCount;
+  } else {
+    readerStats.rejected++; // Intact but malformed: nothing a resend would fix
+  }
+  if (!chunkQueue->push(chunk)) {
+    readerStats.outOfOrder++; // Cannot happen inside the window; retried like a gap
+    requestResend();
+    return;
+  }
+  expectedChunk++;
+  nakSent = false;
+  lastOutOfOrder = 0;
+  sendAck(BULK_ACK);
+}
+
+static void handleFrame(const BulkFrameHeader& header, const uint8_t* payload) {
+  switch (header.type) {
+    case BULK_BEGIN:
+      beginSession(payload, header.length);
+      break;
+    case BULK_DATA:
+      if (sessionStarted) {
+        receiveChunk(header, payload);
+      }
+      break;
+    case BULK_END:
+      if (sessionStarted && header.sequence == chunkCount && expectedChunk == chunkCount) {
+        sessionComplete = true;
+      } else {
+        requestResend();
+      }
+      break;
+    case BULK_ABORT:
+      endReason = "aborted by host";
+      stopRequested.store(true);
+      break;
+  }
+}
+
+static void uploadReaderTask(void* parameter) {
+  uint8_t input[256];
+  unsigned long lastByteAt = millis();
+  while (!stopRequested.load()) {
+    // storedNext is published after each chunk's counters, so they are final here
+    if (sessionComplete && storedNext.load() == chunkCount) {
+      flushCacheManifests();
+      BulkUploadStats stats = mergedStats();
+      sendFrame(BULK_DONE, chunkCount, &stats, sizeof(stats));
+      endReason = "complete";
+      break;
+    }
+
+    int available = SerialBT.available();
+    if (available <= 0) {
+      if (!SerialBT.hasClient()) {
+        endReason = "link lost";
+        break;
+      }
+      if (millis() - lastByteAt >= BULK_IDLE_TIMEOUT) {
+        endReason = "timed out";
+        break;
+      }
+      if (frameParser->partial() && millis() - lastByteAt >= BULK_FRAME_TIMEOUT) {
+        frameParser->reset(); // The rest of the frame was dropped on the way in
+        readerStats.crcErrors++;
+        requestResend();
+      }
+      // The store task freed queue slots: open the window. After END the
+      // window no longer moves, so report progress to keep the host waiting
+      if (sessionStarted && (windowEnd() != advertisedWindow ||
+                             (sessionComplete && storedNext.load() != advertisedStored))) {
+        sendAck(BULK_ACK);
+      }
+      vTaskDelay(1);
+      continue;
+    }
+
+    size_t count = SerialBT.readBytes(input, available < (int)sizeof(input) ? available : sizeof(input));
+    lastByteAt = millis();
+    readerStats.bytes += count;
+    size_t offset = 0;
+    while (offset < count) {
+      size_t used;
+      BulkFrameParser::Result result = frameParser->feed(input + offset, count - offset, used);
+      offset += used;
+      if (result == BulkFrameParser::FRAME) {
+        handleFrame(frameParser->header(), frameParser->payload());
+      } else if (result == BulkFrameParser::BAD_FRAME) {
+        readerStats.crcErrors++;
+        requestResend();
+      }
+    }
+  }
+  stopRequested.store(true);
+  releaseTask();
+  vTaskDelete(nullptr);
+}
+
+// Last task out keeps the resume point, frees the session and reports.
+// loop() reads lastStats once uploadActive drops, so that comes last.
+static void releaseTask() {
+  if (runningTasks.fetch_sub(1) != 1) {
+    return;
+  }
+  if (sessionStarted) {
+    if (sessionComplete) {
+      StorageLock lock;
+      preferences.remove(BULK_RESUME_KEY);
+    } else {
+      saveResumePoint();
+      flushCacheManifests();
+    }
+    lastStats = mergedStats();
+    haveLastStats = true;
+  }
+  delete chunkQueue;
+  delete frameParser;
+  chunkQueue = nullptr;
+  frameParser = nullptr;
+
+  SerialBT.printf("\nUpload %s", endReason);
+  if (sessionStarted && !sessionComplete) {
+    SerialBT.printf(", %u of %u chunks stored; send again to resume", storedNext.load(), chunkCount);
+  }
+  SerialBT.println();
+  if (sessionStarted) {
+    showBulkUploadStatus();
+  }
+  uploadActive.store(false);
+}
+
+bool startBulkUpload() {
+  if (bulkUploadActive()) {
+    return false;
+  }
+  chunkQueue = new (std::nothrow) UploadQueue();
+  frameParser = new (std::nothrow) BulkFrameParser();
+  if (chunkQueue == nullptr || frameParser == nullptr) {
+    delete chunkQueue;
+    delete frameParser;
+    chunkQueue = nullptr;
+    frameParser = nullptr;
+    return false;
+  }
+
+  sessionStarted = false;
+  sessionComplete = false;
+  expectedChunk = 0;
+  storedNext.store(0);
+  endReason = "";
+  stopRequested.store(false);
+
+  uploadActive.store(true);
+  runningTasks.store(2);
+  if (xTaskCreatePinnedToCore(uploadStoreTask, "bulk_store", BULK_STORE_STACK, nullptr,
+                              BULK_STORE_PRIORITY, nullptr, BULK_TASK_CORE) != pdPASS) {
+    runningTasks.store(0);
+    uploadActive.store(false);
+    delete chunkQueue;
+    delete frameParser;
+    chunkQueue = nullptr;
+    frameParser = nullptr;
+    return false;
+  }
+  if (xTaskCreatePinnedToCore(uploadReaderTask, "bulk_read", BULK_READER_STACK, nullptr,
+                              BULK_READER_PRIORITY, nullptr, BULK_TASK_CORE) != pdPASS) {
+    // The store task sees the stop and frees the session as the last task
+    endReason = "could not start";
+    stopRequested.store(true);
+    releaseTask();
+    return false;
+  }
+  return true;
+}
+
+bool bulkUploadActive() {
+  return uploadActive.load();
+}
+
+void showBulkUploadStatus() {
+  if (!haveLastStats) {
+    SerialBT.println(F("Upload: no session yet"));
+    return;
+  }
+  const BulkUploadStats& s = lastStats;
+  float seconds = s.elapsedMs / 1000.0f;
+  if (seconds <= 0) {
+    seconds = 0.001f;
+  }
+  SerialBT.printf("Upload: %lu records in %.1f s (%lu stored, %lu unchanged, %lu skipped, %lu rejected)\n",
+                  (unsigned long)s.records, seconds, (unsigned long)s.stored, (unsigned long)s.unchanged,
+                  (unsigned long)s.skipped, (unsigned long)s.rejected);
+  SerialBT.printf("Upload link: %.1f KB/s, %.0f records/s, %lu bad frames, %lu out of order, %lu duplicates\n",
+                  s.bytes / 1024.0f / seconds, s.records / seconds, (unsigned long)s.crcErrors,
+                  (unsigned long)s.outOfOrder, (unsigned long)s.duplicates);
+}
@@ -1,21 +1,78 @@
 #include "global.h"
+#include "buzzer_patterns.h"
+#include <esp_timer.h>
 
-// Buzzer control variables
-unsigned long buzzerStartTime = 0;
-bool buzzerActive = false;
 unsigned long lastBuzzerCheck = 0;
 
-// Prayer alert tracking
-String lastAlertPrayer = "";
-int lastAlertDay = -1;
-String lastWarningPrayer = "";
-int lastWarningDay = -1;
+// Pattern player: the current step and when it started (esp_timer microseconds).
+// Steps advance in a one-shot esp_timer armed for the next edge, so loop()'s
+// pace does not move edges; loop() only starts, stops and reads the player.
+// playerMutex covers everything below between the timer task and loop().
+static esp_timer_handle_t stepTimer = nullptr;
+static SemaphoreHandle_t playerMutex = nullptr;
+static const BuzzerStep* playStep = nullptr;
+static const BuzzerStep* playEnd = nullptr;
+static const BuzzerStep* loopStep = nullptr;   // Loop end being repeated
+static uint8_t loopsLeft = 0;
+static int64_t stepStartedAt = 0;
+static uint16_t outputTone = 0;
+
+struct PlayerLock {
+    PlayerLock() { xSemaphoreTake(playerMutex, portMAX_DELAY); }
+    ~PlayerLock() { xSemaphoreGive(playerMutex); }
+};
+
+// Output edges against their scheduled times, from the start of the pattern.
+// Errors are the timer task's dispatch latency, normally tens of microseconds.
+struct EdgeTiming {
+    int64_t startMicros;
+    uint16_t edges;
+    int32_t sumMicros;
+    int32_t worstMicros;        // Largest magnitude, signed
+    int32_t lengthMicros;       // End of the pattern against durationMs
+    bool complete;              // Played to the end, not stopped
+};
+
+static EdgeTiming edgeTiming = {};
+
+// Menu 12: every pattern in turn, stepped from updateBuzzer()
+struct BuzzerTest {
+    bool active;
+    bool playing;
+    uint8_t pattern;
+    unsigned long idleSince;
+    int32_t worstMicros;
+    bool passed;
+};
+
+static BuzzerTest buzzerTest = {};
+
+static void advanceBuzzerPattern(void*);
+static void serviceBuzzerTest(unsigned long currentMillis);
+
+// Prayer alert tracking (mirrored into the warm boot snapshot)
+AlertDedupe alertDedupe = {-1, -1, -1, -1, {0, 0}};
 
 void initializeBuzzer() {
     Serial.println(F("Buzzer Manager: Initializing buzzer..."));
     
-    pinMode(BUZZER_PIN, OUTPUT);
-    digitalWrite(BUZZER_PIN, LOW); // Ensure buzzer is off
+    if (BUZZER_PASSIVE) {
+        ledcSetup(BUZZER_LEDC_CHANNEL, BUZZER_TONE_HZ, 8);
+        ledcAttachPin(BUZZER_PIN, BUZZER_LEDC_CHANNEL);
+        ledcWrite(BUZZER_LEDC_CHANNEL, 0);
+    } else {
+        pinMode(BUZZER_PIN, OUTPUT);
+        digitalWrite(BUZZER_PIN, LOW); // Ensure buzzer is off
+    }
+    
+    playerMutex = xSemaphoreCreateMutex();
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = advanceBuzzerPattern;
+    timerArgs.name = "buzzer_step";
+    if (playerMutex == nullptr || esp_timer_create(&timerArgs, &stepTimer) != ESP_OK) {
+        Serial.println(F("Buzzer Manager: cannot create the step timer"));
+        return;
+    }
     
     buzzerInitialized = true;
     Serial.printf("Buzzer Manager: Buzzer initialized on pin %d\n", BUZZER_PIN);
@@ -27,259 +84,392 @@ void updateBuzzer() {
     unsigned long currentMillis = millis();
     
     // Check buzzer status every second
-    if (currentMillis - lastBuzzerCheck >= 1000) {
+    if (currentMillis - lastBuzzerCheck >= BUZZER_CHECK_INTERVAL) {
         lastBuzzerCheck = currentMillis;
         checkPrayerAlerts();
     }
     
-    // Handle active buzzer patterns
-    handleBuzzerPattern(currentMillis);
+    serviceBuzzerTest(currentMillis);
 }
 
 void checkPrayerAlerts() {
     DateTime now = rtc.now();
     if (now.year() <= 2000) return; // Invalid time
     
-    String todayPrayerTimes = getPrayerTimesFromCache(getCurrentDateString());
-    if (todayPrayerTimes == "") return;
+    // Lock-free read of the published today/tomorrow pair; storage only on a miss
+    CivilDate today = civilDateFrom(now);
+    int32_t todayNumber = daysFromCivil(today);
+    DaySchedule schedule;
+    if (!readActiveSchedule(todayNumber, schedule)) {
+        refreshWarmBootSchedules(today);
+        if (!readActiveSchedule(todayNumber, schedule)) return;
+    }
     
-    // Parse prayer times and check for alerts
-    checkPrayerTimeAlerts(now, todayPrayerTimes);
+    noteAlertPathReady();
+    checkPrayerTimeAlerts(now, schedule);
 }
 
-void checkPrayerTimeAlerts(DateTime now, const String& prayerTimesJson) {
-    if (prayerTimesJson.length() < 10) return; // Invalid data
-    
-    // Parse JSON to extract prayer times
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, prayerTimesJson);
-    
-    if (error) {
-        Serial.printf("JSON parsing failed: %s\n", error.f_str());
-        return;
-    }
-    
-    // Check if we have the timings object
-    if (!doc["data"]["timings"]) {
-        Serial.println("No timings data found in JSON");
-        return;
-    }
-    
-    JsonObject timings = doc["data"]["timings"];
-    
-    struct PrayerTime {
-        String name;
-        int hour;
-        int minute;
-    };
-    
-    // Extract prayer times from JSON
-    PrayerTime prayers[5];
-    int prayerCount = 0;
-    
-    // Helper function to parse time string "HH:MM" to hour and minute
-    auto parseTime = [](const String& timeStr, int& hour, int& minute) {
-        int colonPos = timeStr.indexOf(':');
-        if (colonPos > 0) {
-            hour = timeStr.substring(0, colonPos).toInt();
-            minute = timeStr.substring(colonPos + 1, colonPos + 3).toInt();
-            return true;
-        }
-        return false;
-    };
-    
-    // Parse each prayer time
-    if (timings["Fajr"]) {
-        String fajrTime = timings["Fajr"].as<String>();
-        if (parseTime(fajrTime, prayers[prayerCount].hour, prayers[prayerCount].minute)) {
-            prayers[prayerCount].name = "Fajr";
-            prayerCount++;
-        }
-    }
-    
-    if (timings["Dhuhr"]) {
-        String dhuhrTime = timings["Dhuhr"].as<String>();
-        if (parseTime(dhuhrTime, prayers[prayerCount].hour, prayers[prayerCount].minute)) {
-            prayers[prayerCount].name = "Dhuhr";
-            prayerCount++;
-        }
-    }
-    
-    if (timings["Asr"]) {
-        String asrTime = timings["Asr"].as<String>();
-        if (parseTime(asrTime, prayers[prayerCount].hour, prayers[prayerCount].minute)) {
-            prayers[prayerCount].name = "Asr";
-            prayerCount++;
-        }
-    }
-    
-    if (timings["Maghrib"]) {
-        String maghribTime = timings["Maghrib"].as<String>();
-        if (parseTime(maghribTime, prayers[prayerCount].hour, prayers[prayerCount].minute)) {
-            prayers[prayerCount].name = "Maghrib";
-            prayerCount++;
-        }
-    }
-    
-    if (timings["Isha"]) {
-        String ishaTime = timings["Isha"].as<String>();
-        if (parseTime(ishaTime, prayers[prayerCount].hour, prayers[prayerCount].minute)) {
-            prayers[prayerCount].name = "Isha";
-            prayerCount++;
-        }
-    }
-    
-    int currentHour = now.hour();
-    int currentMinute = now.minute();
-    int currentDay = now.day();
+// Buzzer and display start when loop() applies the event
+static void postAlertFired(int prayer, bool warning) {
+    SystemEvent event;
+    event.type = EVENT_ALERT_FIRED;
+    event.alert.prayer = prayer;
+    event.alert.warning = warning;
+    postSystemEvent(event);
+}
+
+void checkPrayerTimeAlerts(DateTime now, const DaySchedule& schedule) {
+    int currentMinutes = now.hour() * 60 + now.minute();
+    int32_t currentDay = schedule.dayNumber;
     
     // Check each prayer time
-    for (int i = 0; i < prayerCount; i++) {
-        PrayerTime prayer = prayers[i];
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        if (i == PRAYER_SUNRISE) continue;
         
-        // Calculate minutes difference
-        int prayerMinutes = prayer.hour * 60 + prayer.minute;
-        int currentMinutes = currentHour * 60 + currentMinute;
+        String prayerName = schedulePrayerName(i);
+        int prayerMinutes = schedule.minutes[i];
         int timeDiff = prayerMinutes - currentMinutes;
         
         // Check for exact prayer time (on-off buzzer for 10 seconds)
         if (timeDiff == 0) {
-            if (lastAlertPrayer != prayer.name || lastAlertDay != currentDay) {
-                Serial.printf("PRAYER TIME ALERT: %s at %02d:%02d\n", prayer.name.c_str(), prayer.hour, prayer.minute);
-                startPrayerTimeBuzzer(prayer.name);
-                lastAlertPrayer = prayer.name;
-                lastAlertDay = currentDay;
+            if (alertDedupe.alertPrayer != i || alertDedupe.alertDay != currentDay) {
+                Serial.printf("PRAYER TIME ALERT: %s at %02d:%02d\n", prayerName.c_str(), prayerMinutes / 60, prayerMinutes % 60);
+                {
+                    StorageLock lock;
+                    alertDedupe.alertPrayer = i;
+                    alertDedupe.alertDay = currentDay;
+                    saveWarmBootSnapshot();
+                }
+                postAlertFired(i, false);
             }
         }
         
         // Check for 10 minutes warning (continuous buzz for 1 second)
-        else if (timeDiff == 10) {
-            if (lastWarningPrayer != prayer.name || lastWarningDay != currentDay) {
-                Serial.printf("PRAYER WARNING: %s in 10 minutes (%02d:%02d)\n", prayer.name.c_str(), prayer.hour, prayer.minute);
-                startPrayerWarningBuzzer(prayer.name);
-                lastWarningPrayer = prayer.name;
-                lastWarningDay = currentDay;
+        else if (timeDiff == PRAYER_WARNING_MINUTES) {
+            if (alertDedupe.warningPrayer != i || alertDedupe.warningDay != currentDay) {
+                Serial.printf("PRAYER WARNING: %s in 10 minutes (%02d:%02d)\n", prayerName.c_str(), prayerMinutes / 60, prayerMinutes % 60);
+                {
+                    StorageLock lock;
+                    alertDedupe.warningPrayer = i;
+                    alertDedupe.warningDay = currentDay;
+                    saveWarmBootSnapshot();
+                }
+                postAlertFired(i, true);
             }
         }
     }
 }
 
-void startPrayerTimeBuzzer(const String& prayerName) {
-    Serial.printf("Starting prayer time buzzer for %s\n", prayerName.c_str());
-    currentBuzzerMode = BUZZER_PRAYER_TIME;
-    buzzerStartTime = millis();
-    buzzerActive = true;
+static uint8_t selectedPattern(int prayer, bool warning) {
+    uint8_t pattern = warning ? deviceSettings.warningPatterns[prayer] : deviceSettings.alertPatterns[prayer];
+    return pattern < BUZZER_PATTERN_COUNT ? pattern : (warning ? BUZZER_PATTERN_LONG : BUZZER_PATTERN_PULSE);
+}
+
+static void interruptBuzzerTest() {
+    if (buzzerTest.active) {
+        buzzerTest.active = false;
+        SerialBT.println(F("Buzzer test interrupted by an alert"));
+    }
+}
+
+void startPrayerTimeBuzzer(int prayer) {
+    String prayerName = schedulePrayerName(prayer);
+    interruptBuzzerTest();
+    
+    // Real adhan when one is on the SD card, buzzer pattern otherwise
+    if (startAudioPlayback(ADHAN_AUDIO_PATH)) {
+        Serial.printf("Playing adhan for %s\n", prayerName.c_str());
+    } else {
+        uint8_t pattern = selectedPattern(prayer, false);
+        Serial.printf("Starting prayer time buzzer for %s (%s)\n", prayerName.c_str(), buzzerPatterns[pattern].name);
+        startBuzzerPattern(pattern);
+    }
     
     // Display alert as well
     displayPrayerAlert(prayerName);
 }
 
-void startPrayerWarningBuzzer(const String& prayerName) {
-    Serial.printf("Starting prayer warning buzzer for %s\n", prayerName.c_str());
-    currentBuzzerMode = BUZZER_WARNING;
-    buzzerStartTime = millis();
-    buzzerActive = true;
+void startPrayerWarningBuzzer(int prayer) {
+    String prayerName = schedulePrayerName(prayer);
+    interruptBuzzerTest();
+    uint8_t pattern = selectedPattern(prayer, true);
+    Serial.printf("Starting prayer warning buzzer for %s (%s)\n", prayerName.c_str(), buzzerPatterns[pattern].name);
+    startBuzzerPattern(pattern);
     
     // Display warning as well
-    displayWarningAlert(prayerName, 10);
+    displayWarningAlert(prayerName, PRAYER_WARNING_MINUTES);
 }
 
-void handleBuzzerPattern(unsigned long currentMillis) {
-    if (!buzzerActive) return;
-    
-    unsigned long elapsed = currentMillis - buzzerStartTime;
-    
-    switch (currentBuzzerMode) {
-        case BUZZER_PRAYER_TIME:
-            handlePrayerTimeBuzzer(elapsed);
-            break;
-            
-        case BUZZER_WARNING:
-            handleWarningBuzzer(elapsed);
-            break;
-            
-        case BUZZER_ALARM:
-            handleAlarmBuzzer(elapsed);
-            break;
-            
-        default:
-            stopBuzzer();
-            break;
+// Pin or LEDC write, only when the tone actually changes
+static bool setBuzzerOutput(uint16_t toneHz) {
+    if (toneHz == outputTone) return false;
+    outputTone = toneHz;
+    if (BUZZER_PASSIVE) {
+        ledcWriteTone(BUZZER_LEDC_CHANNEL, toneHz);
+    } else {
+        digitalWrite(BUZZER_PIN, toneHz != 0 ? HIGH : LOW);
+    }
+    return true;
+}
+
+// Microseconds between the scheduled edge and now
+static int32_t edgeError(int64_t scheduledMicros) {
+    return (int32_t)(esp_timer_get_time() - scheduledMicros);
+}
+
+static void recordEdge(int64_t scheduledMicros) {
+    int32_t error = edgeError(scheduledMicros);
+    edgeTiming.edges++;
+    edgeTiming.sumMicros += error;
+    if (abs(error) > abs(edgeTiming.worstMicros)) {
+        edgeTiming.worstMicros = error;
     }
 }
 
-void handlePrayerTimeBuzzer(unsigned long elapsed) {
-    // On-off pattern for 10 seconds total
-    // 0.5s ON, 0.5s OFF, repeat for 10 cycles = 10 seconds
+static int64_t stepEndsAt() {
+    return stepStartedAt + playStep->durationMs * 1000LL;
+}
+
+// Caller holds playerMutex; stop first so a pending expiry is replaced
+static void armStepTimer() {
+    esp_timer_stop(stepTimer);
+    int64_t wait = stepEndsAt() - esp_timer_get_time();
+    esp_timer_start_once(stepTimer, wait > 0 ? wait : 0);
+}
+
+bool startBuzzerPattern(uint8_t pattern) {
+    if (!buzzerInitialized || pattern >= BUZZER_PATTERN_COUNT) return false;
     
-    if (elapsed >= 10000) { // 10 seconds total
+    const BuzzerPattern& selected = buzzerPatterns[pattern];
+    if (selected.durationMs == 0) {
         stopBuzzer();
-        return;
+        return false;
     }
+    PlayerLock lock;
+    playStep = selected.steps;
+    playEnd = selected.steps + selected.stepCount;
+    loopStep = nullptr;
+    loopsLeft = 0;
+    stepStartedAt = esp_timer_get_time();
+    edgeTiming = {stepStartedAt, 0, 0, 0, 0, false};
+    setBuzzerOutput(playStep->toneHz);
+    armStepTimer();
+    return true;
+}
+
+// Next step after `step`, following its loop if it ends one
+static const BuzzerStep* nextBuzzerStep(const BuzzerStep* step) {
+    if (step->loopSteps != 0) {
+        if (loopStep != step) {
+            loopStep = step;
+            loopsLeft = step->loopRepeats;
+        }
+        if (loopsLeft > 0) {
+            loopsLeft--;
+            return step + 1 - step->loopSteps;
+        }
+        loopStep = nullptr;
+    }
+    return step + 1;
+}
+
+// Step timer callback (esp_timer task)
+static void advanceBuzzerPattern(void*) {
+    PlayerLock lock;
+    // Nothing playing, or an expiry that raced a restart: the new step is armed already
+    if (playStep == nullptr) return;
+    int64_t now = esp_timer_get_time();
+    if (now < stepEndsAt()) return;
+    
+    // Step edges are scheduled from the previous edge, so a late callback
+    // does not stretch the pattern; zero-length steps are passed through
+    do {
+        stepStartedAt += playStep->durationMs * 1000LL;
+        playStep = nextBuzzerStep(playStep);
+        if (playStep == playEnd) {
+            if (setBuzzerOutput(0)) recordEdge(stepStartedAt);
+            edgeTiming.lengthMicros = edgeError(stepStartedAt);
+            edgeTiming.complete = true;
+            playStep = nullptr;
+            loopStep = nullptr;
+            return;
+        }
+    } while (now >= stepEndsAt());
     
-    unsigned long cycle = elapsed % 1000; // 1 second cycles
-    
-    if (cycle < 500) {
-        digitalWrite(BUZZER_PIN, HIGH); // ON for 0.5 seconds
-    } else {
-        digitalWrite(BUZZER_PIN, LOW);  // OFF for 0.5 seconds
+    if (setBuzzerOutput(playStep->toneHz)) recordEdge(stepStartedAt);
+    armStepTimer();
+}
+
+static bool patternPlaying() {
+    PlayerLock lock;
+    return playStep != nullptr;
+}
+
+bool buzzerBusy() {
+    return (buzzerInitialized && patternPlaying()) || audioPlaying();
+}
+
+void stopBuzzer() {
+    if (!buzzerInitialized) return;
+    bool wasPlaying;
+    {
+        PlayerLock lock;
+        esp_timer_stop(stepTimer);
+        setBuzzerOutput(0);
+        wasPlaying = playStep != nullptr;
+        playStep = nullptr;
+        loopStep = nullptr;
+    }
+    if (wasPlaying) {
+        Serial.println(F("Buzzer stopped"));
+    }
+}
+
+static int findBuzzerPattern(const String& name) {
+    for (int i = 0; i < BUZZER_PATTERN_COUNT; i++) {
+        if (name == buzzerPatterns[i].name) return i;
     }
+    return -1;
 }
 
-void handleWarningBuzzer(unsigned long elapsed) {
-    // Continuous buzz for 1 second
+// Prayer index by lowercase name, PRAYER_COUNT for "all", -1 if unknown
+static int findPrayer(const String& name) {
+    if (name == "all") return PRAYER_COUNT;
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        String prayer = schedulePrayerName(i);
+        prayer.toLowerCase();
+        if (name == prayer && i != PRAYER_SUNRISE) return i;
+    }
+    return -1;
+}
+
+void showBuzzerPatterns() {
+    SerialBT.println(F("\n=== Buzzer Patterns ==="));
+    for (int i = 0; i < BUZZER_PATTERN_COUNT; i++) {
+        SerialBT.printf("%-7s %2u steps, %5.1f s\n", buzzerPatterns[i].name, buzzerPatterns[i].stepCount,
+                        buzzerPatterns[i].durationMs / 1000.0f);
+    }
+    SerialBT.println(F("Prayer   alert   warning"));
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        if (i == PRAYER_SUNRISE) continue;
+        SerialBT.printf("%-8s %-7s %s\n", schedulePrayerName(i), buzzerPatterns[selectedPattern(i, false)].name,
+                        buzzerPatterns[selectedPattern(i, true)].name);
+    }
+    SerialBT.println(F("'pattern <prayer|all> [warning] <name>' to change, 'pattern play <name>' to preview"));
+}
+
+// "pattern play <name>", "pattern <prayer|all> [warning] <name>"
+void handlePatternCommand(const String& args) {
+    String words[3];
+    int count = 0;
+    int start = 0;
+    String line = args;
+    line.trim();
+    while (start < (int)line.length() && count < 3) {
+        int space = line.indexOf(' ', start);
+        if (space < 0) space = line.length();
+        if (space > start) words[count++] = line.substring(start, space);
+        start = space + 1;
+    }
     
-    if (elapsed >= 1000) { // 1 second total
-        stopBuzzer();
+    if (count == 0) {
+        showBuzzerPatterns();
+        return;
+    }
+    int pattern = findBuzzerPattern(words[count - 1]);
+    if (count >= 2 && pattern < 0) {
+        SerialBT.println("Unknown pattern: " + words[count - 1]);
+        return;
+    }
+    if (words[0] == "play" && count == 2) {
+        if (audioPlaying()) {
+            SerialBT.println(F("Adhan playing, 'stop' it first"));
+        } else if (startBuzzerPattern(pattern)) {
+            SerialBT.printf("Playing %s (%.1f s)\n", buzzerPatterns[pattern].name, buzzerPatterns[pattern].durationMs / 1000.0f);
+        }
         return;
     }
     
-    digitalWrite(BUZZER_PIN, HIGH); // Continuous ON
+    int prayer = findPrayer(words[0]);
+    bool warning = count == 3 && words[1] == "warning";
+    if (prayer < 0 || count < 2 || (count == 3 && !warning)) {
+        SerialBT.println(F("Usage: pattern <fajr|dhuhr|asr|maghrib|isha|all> [warning] <pattern>"));
+        return;
+    }
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        if ((prayer == PRAYER_COUNT || prayer == i) && i != PRAYER_SUNRISE) {
+            settingsSetBuzzerPattern(i, warning, pattern);
+        }
+    }
+    SerialBT.printf("%s %s pattern set to %s\n", prayer == PRAYER_COUNT ? "All" : schedulePrayerName(prayer),
+                    warning ? "warning" : "alert", buzzerPatterns[pattern].name);
 }
 
-void handleAlarmBuzzer(unsigned long elapsed) {
-    // Custom alarm pattern (can be used for other alerts)
-    // Fast beeping: 0.1s ON, 0.1s OFF
-    
-    if (elapsed >= 5000) { // 5 seconds total
-        stopBuzzer();
+static void reportBuzzerTiming(const BuzzerPattern& pattern) {
+    EdgeTiming timing;
+    {
+        PlayerLock lock;
+        timing = edgeTiming;
+    }
+    if (!timing.complete) {
+        SerialBT.printf("  %-7s stopped early\n", pattern.name);
+        buzzerTest.passed = false;
         return;
     }
-    
-    unsigned long cycle = elapsed % 200; // 0.2 second cycles
-    
-    if (cycle < 100) {
-        digitalWrite(BUZZER_PIN, HIGH); // ON for 0.1 seconds
-    } else {
-        digitalWrite(BUZZER_PIN, LOW);  // OFF for 0.1 seconds
+    float mean = timing.edges > 0 ? timing.sumMicros / 1000.0f / timing.edges : 0;
+    SerialBT.printf("  %-7s %3u edges, mean %+.2f ms, worst %+.2f ms, length %+.2f ms\n", pattern.name,
+                    timing.edges, mean, timing.worstMicros / 1000.0f, timing.lengthMicros / 1000.0f);
+    int32_t worst = max(abs(timing.worstMicros), abs(timing.lengthMicros));
+    buzzerTest.worstMicros = max(buzzerTest.worstMicros, worst);
+    if (worst > BUZZER_EDGE_TOLERANCE_US) {
+        buzzerTest.passed = false;
     }
 }
 
-void stopBuzzer() {
-    digitalWrite(BUZZER_PIN, LOW);
-    buzzerActive = false;
-    currentBuzzerMode = BUZZER_OFF;
-    buzzerStartTime = 0;
-    Serial.println(F("Buzzer stopped"));
+static void serviceBuzzerTest(unsigned long currentMillis) {
+    if (!buzzerTest.active) return;
+    if (buzzerTest.playing) {
+        if (patternPlaying()) return;
+        buzzerTest.playing = false;
+        buzzerTest.idleSince = currentMillis;
+        reportBuzzerTiming(buzzerPatterns[buzzerTest.pattern]);
+    }
+    if (currentMillis - buzzerTest.idleSince < BUZZER_TEST_GAP) return;
+    
+    // Silent patterns have nothing to time
+    do {
+        buzzerTest.pattern++;
+    } while (buzzerTest.pattern < BUZZER_PATTERN_COUNT && buzzerPatterns[buzzerTest.pattern].durationMs == 0);
+    if (buzzerTest.pattern >= BUZZER_PATTERN_COUNT) {
+        buzzerTest.active = false;
+        SerialBT.printf("Buzzer self-test %s: worst edge %.2f ms (limit %.1f ms)\n",
+                        buzzerTest.passed ? "PASS" : "FAIL", buzzerTest.worstMicros / 1000.0f,
+                        BUZZER_EDGE_TOLERANCE_US / 1000.0f);
+        return;
+    }
+    startBuzzerPattern(buzzerTest.pattern);
+    buzzerTest.playing = true;
 }
 
+// Plays every pattern while loop() keeps running, then reports edge timing
 void testBuzzer() {
-    Serial.println(F("Testing buzzer..."));
-    
-    // Test different patterns
-    Serial.println(F("Testing prayer time pattern..."));
-    startPrayerTimeBuzzer("Test");
-    delay(11000);
-    
-    Serial.println(F("Testing warning pattern..."));
-    startPrayerWarningBuzzer("Test");
-    delay(2000);
-    
-    Serial.println(F("Testing alarm pattern..."));
-    currentBuzzerMode = BUZZER_ALARM;
-    buzzerStartTime = millis();
-    buzzerActive = true;
-    delay(6000);
-    
-    Serial.println(F("Buzzer test complete"));
-}
\ No newline at end of file
+    if (audioPlaying() || !buzzerInitialized) {
+        SerialBT.println(F("Buzzer busy or not initialized"));
+        return;
+    }
+    uint32_t totalMs = 0;
+    for (const BuzzerPattern& pattern : buzzerPatterns) {
+        if (pattern.durationMs > 0) totalMs += pattern.durationMs + BUZZER_TEST_GAP;
+    }
+    SerialBT.printf("Buzzer self-test: all patterns, about %lu s ('stop' to cancel)\n", (unsigned long)(totalMs / 1000));
+    buzzerTest = {true, true, 0, 0, 0, true};
+    startBuzzerPattern(0);
+}
+
+void stopBuzzerTest() {
+    if (buzzerTest.active) {
+        buzzerTest.active = false;
+        SerialBT.println(F("Buzzer test cancelled"));
+    }
+    stopBuzzer();
+}
@@ -0,0 +1,256 @@
+/*
+ * SD Cache Manifest Implementation
+ * Keeps per-city, per-year cache coverage in RAM so coverage queries
+ * never touch the SD card. One manifest file per city and year.
+ */
+
+#include "global.h"
+
+struct ManifestSlot {
+  CacheManifest manifest;
+  String city;
+  bool loaded;
+  bool dirty;
+  bool yearDirReady;
+  unsigned long lastUsed;
+};
+
+static ManifestSlot manifestSlots[CACHE_MANIFEST_SLOTS];
+
+static String manifestYearDir(const String& city, int year) {
+  return "/" + city + "/" + String(year);
+}
+
+static void resetManifest(CacheManifest& manifest, int year) {
+  memset(&manifest, 0, sizeof(manifest));
+  manifest.magic = CACHE_MANIFEST_MAGIC;
+  manifest.version = CACHE_MANIFEST_VERSION;
+  manifest.year = year;
+}
+
+static void setDayBit(CacheManifest& manifest, int index, bool cached) {
+  uint8_t mask = 1 << (index & 7);
+  bool wasCached = manifest.dayBits[index >> 3] & mask;
+  if (cached && !wasCached) {
+    manifest.dayBits[index >> 3] |= mask;
+    manifest.cachedDays++;
+  } else if (!cached && wasCached) {
+    manifest.dayBits[index >> 3] &= ~mask;
+    manifest.cachedDays--;
+  }
+}
+
+static bool getDayBit(const CacheManifest& manifest, int index) {
+  return manifest.dayBits[index >> 3] & (1 << (index & 7));
+}
+
+// One-time directory walk for caches written before manifests existed
+static void rebuildManifestFromSD(ManifestSlot& slot) {
+  String yearDir = manifestYearDir(slot.city, slot.manifest.year);
+  File root = SD.open(yearDir.c_str());
+  if (!root || !root.isDirectory()) {
+    slot.yearDirReady = false;
+    return;
+  }
+
+  slot.yearDirReady = true;
+  File monthDir = root.openNextFile();
+  while (monthDir) {
+    int month = atoi(monthDir.name());
+    if (monthDir.isDirectory() && month >= 1 && month <= 12) {
+      slot.manifest.monthDirs |= (1 << (month - 1));
+
+      File entry = monthDir.openNextFile();
+      while (entry) {
+        // Day files are named dd-mm-yyyy.json
+        CivilDate date;
+        if (!entry.isDirectory() && parseDateKey(entry.name(), date) && date.year == slot.manifest.year) {
+          setDayBit(slot.manifest, dayOfYearIndex(date), true);
+        }
+        entry = monthDir.openNextFile();
+      }
+    }
+    monthDir = root.openNextFile();
+  }
+
+  slot.dirty = true;
+  debugPrintln("Cache manifest rebuilt for " + yearDir + ": " + String(slot.manifest.cachedDays) + " days");
+}
+
+static bool writeManifest(ManifestSlot& slot) {
+  if (!slot.yearDirReady) {
+    createDir("/" + slot.city);
+    createDir(manifestYearDir(slot.city, slot.manifest.year));
+    slot.yearDirReady = true;
+  }
+
+  slot.manifest.crc = cacheManifestCrc(slot.manifest);
+  String path = manifestYearDir(slot.city, slot.manifest.year) + "/" + CACHE_MANIFEST_FILE;
+  String tempPath = path + CACHE_TEMP_SUFFIX;
+  File file = SD.open(tempPath.c_str(), FILE_WRITE);
+  if (!file) {
+    debugPrintln("Failed to write cache manifest: " + path);
+    return false;
+  }
+
+  size_t written = file.write(reinterpret_cast<const uint8_t*>(&slot.manifest), sizeof(CacheManifest));
+  file.close();
+  if (written != sizeof(CacheManifest)) {
+    debugPrintln("Short write on cache manifest: " + path);
+    SD.remove(tempPath.c_str());
+    return false;
+  }
+
+  if (!commitFile(tempPath, path)) {
+    return false;
+  }
+
+  slot.dirty = false;
+  return true;
+}
+
+static void loadManifest(ManifestSlot& slot, const String& city, int year) {
+  slot.city = city;
+  slot.loaded = true;
+  slot.dirty = false;
+  slot.yearDirReady = false;
+  resetManifest(slot.manifest, year);
+
+  String path = manifestYearDir(city, year) + "/" + CACHE_MANIFEST_FILE;
+  File file = SD.open(path.c_str(), FILE_READ);
+  if (file) {
+    CacheManifest stored;
+    size_t bytesRead = file.read(reinterpret_cast<uint8_t*>(&stored), sizeof(CacheManifest));
+    file.close();
+
+    if (bytesRead == sizeof(CacheManifest) &&
+        stored.magic == CACHE_MANIFEST_MAGIC &&
+        stored.version == CACHE_MANIFEST_VERSION &&
+        stored.year == year &&
+        stored.crc == cacheManifestCrc(stored)) {
+      slot.manifest = stored;
+      slot.yearDirReady = true;
+      debugPrintln("Cache manifest loaded: " + path + " (" + String(stored.cachedDays) + " days)");
+      return;
+    }
+    debugPrintln("Cache manifest invalid, rebuilding: " + path);
+  }
+
+  rebuildManifestFromSD(slot);
+}
+
+static ManifestSlot* getManifestSlot(const String& city, int year) {
+  if (!sdCardInitialized || year < 2000) {
+    return nullptr;
+  }
+
+  ManifestSlot* victim = &manifestSlots[0];
+  for (int i = 0; i < CACHE_MANIFEST_SLOTS; i++) {
+    ManifestSlot& slot = manifestSlots[i];
+    if (slot.loaded && slot.manifest.year == year && slot.city == city) {
+      slot.lastUsed = millis();
+      return &slot;
+    }
+    if (!slot.loaded) {
+      victim = &slot;
+    } else if (victim->loaded && slot.lastUsed < victim->lastUsed) {
+      victim = &slot;
+    }
+  }
+
+  if (victim->loaded && victim->dirty) {
+    writeManifest(*victim);
+  }
+
+  loadManifest(*victim, city, year);
+  victim->lastUsed = millis();
+  return victim;
+}
+
+void loadCacheManifest(const String& city, int year) {
+  StorageLock lock;
+  getManifestSlot(city, year);
+}
+
+bool isDayCached(const String& city, const CivilDate& date) {
+  StorageLock lock;
+  ManifestSlot* slot = getManifestSlot(city, date.year);
+  if (slot == nullptr) {
+    return false;
+  }
+  return getDayBit(slot->manifest, dayOfYearIndex(date));
+}
+
+uint32_t getCachedDayChecksum(const String& city, const CivilDate& date) {
+  StorageLock lock;
+  ManifestSlot* slot = getManifestSlot(city, date.year);
+  if (slot == nullptr) {
+    return 0;
+  }
+  return slot->manifest.checksums[dayOfYearIndex(date)];
+}
+
+void markDayCached(const String& city, const CivilDate& date, uint32_t checksum) {
+  StorageLock lock;
+  ManifestSlot* slot = getManifestSlot(city, date.year);
+  if (slot == nullptr) {
+    return;
+  }
+
+  int index = dayOfYearIndex(date);
+  setDayBit(slot->manifest, index, true);
+  slot->manifest.checksums[index] = checksum;
+  slot->dirty = true;
+}
+
+void clearDayCached(const String& city, const CivilDate& date) {
+  StorageLock lock;
+  ManifestSlot* slot = getManifestSlot(city, date.year);
+  if (slot == nullptr) {
+    return;
+  }
+
+  int index = dayOfYearIndex(date);
+  if (getDayBit(slot->manifest, index)) {
+    setDayBit(slot->manifest, index, false);
+    slot->manifest.checksums[index] = 0;
+    slot->dirty = true;
+  }
+}
+
+bool ensureCacheMonthDir(const String& city, int year, int month) {
+  StorageLock lock;
+  ManifestSlot* slot = getManifestSlot(city, year);
+  if (slot == nullptr) {
+    return false;
+  }
+
+  uint16_t monthBit = 1 << (month - 1);
+  if (slot->manifest.monthDirs & monthBit) {
+    return true;
+  }
+
+  String yearDir = manifestYearDir(city, year);
+  if (!slot->yearDirReady) {
+    createDir("/" + city);
+    createDir(yearDir);
+    slot->yearDirReady = true;
+  }
+
+  char monthDir[4];
+  sprintf(monthDir, "/%02d", month);
+  createDir(yearDir + monthDir);
+
+  slot->manifest.monthDirs |= monthBit;
+  slot->dirty = true;
+  return true;
+}
+
+void flushCacheManifests() {
+  StorageLock lock;
+  for (int i = 0; i < CACHE_MANIFEST_SLOTS; i++) {
+    if (manifestSlots[i].loaded && manifestSlots[i].dirty) {
+      writeManifest(manifestSlots[i]);
+    }
+  }
+}
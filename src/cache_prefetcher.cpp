@@ -0,0 +1,226 @@
+/*
+ * Cache Prefetcher Implementation
+ * Keeps today plus PREFETCH_HORIZON_DAYS cached whenever WiFi is up and the
+ * signal is good enough. Days are fetched in small paced batches; failed
+ * batches back off exponentially and repeated failures open a circuit
+ * breaker that is probed with a single day after a cooldown.
+ *
+ * The state machine runs in its own low-priority task on core 0, so a batch
+ * (up to PREFETCH_BATCH_DAYS paced requests, each allowed HTTP_TIMEOUT)
+ * never holds up loop() and the alert path. loop() only wakes the task.
+ */
+
+#include "global.h"
+#include <atomic>
+
+enum PrefetchState {
+  PREFETCH_WAITING,    // No WiFi, weak signal, no clock or no cache tier
+  PREFETCH_IDLE,       // Horizon full
+  PREFETCH_FILLING,
+  PREFETCH_BACKOFF,
+  PREFETCH_OPEN,       // Breaker tripped, cooling down
+  PREFETCH_HALF_OPEN   // Probing with one day
+};
+
+static const char* const prefetchStateNames[] = {
+  "waiting", "idle", "filling", "backing off", "breaker open", "probing"
+};
+
+static TaskHandle_t prefetchTask = nullptr;
+
+// Written by the prefetch task; loop() reads them for status and wakes
+static std::atomic<PrefetchState> prefetchState(PREFETCH_WAITING);
+static std::atomic<unsigned long> nextAttemptAt(0);
+static std::atomic<unsigned long> lastBatchAt(0);
+static std::atomic<int> cachedInHorizon(0);
+static std::atomic<int32_t> lastRssi(0);
+static std::atomic<uint32_t> daysFetched(0);
+static std::atomic<uint32_t> failedBatches(0);
+static std::atomic<uint32_t> breakerTrips(0);
+
+// Prefetch task only
+static int consecutiveFailures = 0;
+static int32_t lastScanToday = 0;
+static String lastScanCity = "";
+
+static void scheduleNext(unsigned long delayMs) {
+  nextAttemptAt = millis() + delayMs;
+}
+
+static bool prefetchDue() {
+  return (long)(millis() - nextAttemptAt) >= 0;
+}
+
+static bool prefetchAllowed() {
+  if (bootNetworkActive() || !isWiFiConnected() || !(sdCardInitialized || flashCacheInitialized)) {
+    return false;
+  }
+  lastRssi = WiFi.RSSI();
+  return lastRssi >= PREFETCH_MIN_RSSI;
+}
+
+// Collects up to maxCount uncached days, nearest first; counts the cached ones
+static int collectMissingDays(const CivilDate& today, CivilDate* missing, int maxCount) {
+  int missingCount = 0;
+  int cached = 0;
+  for (int i = 0; i <= PREFETCH_HORIZON_DAYS; i++) {
+    CivilDate date = addDays(today, i);
+    if (isScheduleCached(date)) {
+      cached++;
+    } else if (missingCount < maxCount) {
+      missing[missingCount++] = date;
+    }
+  }
+  cachedInHorizon = cached;
+  return missingCount;
+}
+
+static void recordFailure() {
+  failedBatches++;
+  consecutiveFailures++;
+
+  if (prefetchState == PREFETCH_HALF_OPEN || consecutiveFailures >= PREFETCH_BREAKER_FAILURES) {
+    if (prefetchState != PREFETCH_HALF_OPEN) {
+      breakerTrips++;
+    }
+    prefetchState = PREFETCH_OPEN;
+    scheduleNext(PREFETCH_BREAKER_COOLDOWN);
+    debugPrintln("Prefetch breaker open after " + String(consecutiveFailures) + " failed batches");
+    return;
+  }
+
+  // 2^n growth with up to 25% jitter so retries do not line up with other clients
+  unsigned long backoff = PREFETCH_BACKOFF_BASE << min(consecutiveFailures - 1, 16);
+  backoff = min(backoff, (unsigned long)PREFETCH_BACKOFF_MAX);
+  backoff += random(backoff / 4 + 1);
+  prefetchState = PREFETCH_BACKOFF;
+  scheduleNext(backoff);
+  debugPrintln("Prefetch batch failed, retrying in " + String(backoff / 1000) + " s");
+}
+
+static void runPrefetchStep() {
+  if (buzzerBusy()) {
+    scheduleNext(PREFETCH_CHECK_INTERVAL);
+    return;
+  }
+
+  CivilDate today = getToday();
+  if (!isValidDate(today) || !prefetchAllowed()) {
+    if (prefetchState != PREFETCH_OPEN) {
+      prefetchState = PREFETCH_WAITING;
+    }
+    scheduleNext(PREFETCH_CHECK_INTERVAL);
+    return;
+  }
+
+  // Held to the end of the step, so the city cannot change under the batch
+  ApiLock fetchLock;
+
+  // New day: pull the SD-cached part of the window into flash before fetching
+  int32_t todayNumber = daysFromCivil(today);
+  if (todayNumber != lastScanToday || currentCity != lastScanCity) {
+    lastScanToday = todayNumber;
+    lastScanCity = currentCity;
+    promoteFlashWindow();
+  }
+
+  bool probing = prefetchState == PREFETCH_OPEN || prefetchState == PREFETCH_HALF_OPEN;
+  CivilDate missing[PREFETCH_BATCH_DAYS];
+  int missingCount = collectMissingDays(today, missing, probing ? 1 : PREFETCH_BATCH_DAYS);
+  if (missingCount == 0) {
+    prefetchState = PREFETCH_IDLE;
+    consecutiveFailures = 0;
+    scheduleNext(PREFETCH_IDLE_INTERVAL);
+    return;
+  }
+
+  prefetchState = probing ? PREFETCH_HALF_OPEN : PREFETCH_FILLING;
+  lastBatchAt = millis();
+  fetchAndCacheDays(missing, missingCount);
+  flushCacheManifests();
+
+  // Count what actually landed in a cache tier, not just HTTP 200s
+  int stored = 0;
+  for (int i = 0; i < missingCount; i++) {
+    if (isScheduleCached(missing[i])) {
+      stored++;
+    }
+  }
+  daysFetched += stored;
+  cachedInHorizon += stored;
+
+  if (stored == 0) {
+    recordFailure();
+    return;
+  }
+  if (prefetchState == PREFETCH_HALF_OPEN) {
+    debugPrintln(F("Prefetch breaker closed"));
+  }
+  consecutiveFailures = 0;
+  prefetchState = PREFETCH_FILLING;
+  scheduleNext(PREFETCH_SPACING);
+}
+
+// Sleeps until the next attempt is due or loop() wakes it
+static void prefetchTaskMain(void* parameter) {
+  for (;;) {
+    long wait = (long)(nextAttemptAt - millis());
+    if (wait > 0) {
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+      continue;
+    }
+    runPrefetchStep();
+  }
+}
+
+void startCachePrefetcher() {
+  scheduleNext(PREFETCH_CHECK_INTERVAL);
+  if (xTaskCreatePinnedToCore(prefetchTaskMain, "prefetch", PREFETCH_STACK, nullptr, PREFETCH_PRIORITY,
+                              &prefetchTask, 0) != pdPASS) {
+    prefetchTask = nullptr;
+    debugPrintln("ERROR: Could not start the cache prefetcher task");
+  }
+}
+
+// Skips any pending wait, e.g. after a cache entry failed verification
+void wakeCachePrefetcher() {
+  if (prefetchState != PREFETCH_OPEN) {
+    nextAttemptAt = millis();
+    if (prefetchTask != nullptr) {
+      xTaskNotifyGive(prefetchTask);
+    }
+  }
+}
+
+void showPrefetcherStatus() {
+  SerialBT.print(F("Prefetch: "));
+  SerialBT.print(prefetchStateNames[prefetchState]);
+  SerialBT.print(F(", "));
+  SerialBT.print(cachedInHorizon.load());
+  SerialBT.print(F("/"));
+  SerialBT.print(PREFETCH_HORIZON_DAYS + 1);
+  SerialBT.print(F(" days cached"));
+  if (!prefetchDue()) {
+    SerialBT.print(F(", next check in "));
+    SerialBT.print((nextAttemptAt.load() - millis()) / 1000);
+    SerialBT.print(F(" s"));
+  }
+  SerialBT.println();
+
+  SerialBT.print(F("Prefetch stats: "));
+  SerialBT.print(daysFetched.load());
+  SerialBT.print(F(" days fetched, "));
+  SerialBT.print(failedBatches.load());
+  SerialBT.print(F(" failed batches, "));
+  SerialBT.print(breakerTrips.load());
+  SerialBT.print(F(" breaker trips, RSSI "));
+  SerialBT.print(lastRssi.load());
+  SerialBT.print(F(" dBm (min "));
+  SerialBT.print(PREFETCH_MIN_RSSI);
+  SerialBT.println(F(")"));
+  if (lastBatchAt != 0) {
+    SerialBT.print(F("Last prefetch batch: "));
+    SerialBT.print((millis() - lastBatchAt.load()) / 1000);
+    SerialBT.println(F(" s ago"));
+  }
+}
@@ -0,0 +1,66 @@
+/*
+ * Display Layouts Implementation
+ * Screen layouts drawn into the framebuffer; see display_layouts.h.
+ */
+
+#include "display_layouts.h"
+#include "framebuffer.h"
+#include <stdio.h>
+
+void drawTextLine(int page, int x, const char* text, int scale, bool invert) {
+  fbFillRect(0, page * 8, x, scale * 8, invert);
+  int end = x + fbDrawText(x, page, text, scale, invert);
+  fbFillRect(end, page * 8, DISPLAY_WIDTH - end, scale * 8, invert);
+}
+
+void drawCenteredText(int page, const char* text, int scale, bool invert) {
+  int x = (DISPLAY_WIDTH - fbTextWidth(text, scale)) / 2;
+  drawTextLine(page, x < 0 ? 0 : x, text, scale, invert);
+}
+
+// Large HH:MM on pages page..page+3 with small seconds beside the last digit
+static void drawClock(int page, const char* clock, const char* seconds) {
+  int x = (DISPLAY_WIDTH - fbBigTextWidth(clock) - fbTextWidth(seconds)) / 2;
+  fbClearSpan(page, 0, x, 4);
+  x += fbDrawBigText(x, page, clock);
+  fbClearSpan(page, x, DISPLAY_WIDTH, 3);
+  x += fbDrawText(x, page + 3, seconds);
+  fbClearSpan(page + 3, x, DISPLAY_WIDTH);
+}
+
+// Redraws everything; unchanged bytes do not reach the panel
+void drawClockScreen(const ClockScreen& screen) {
+  drawTextLine(0, 0, screen.topLine);
+  drawClock(1, screen.clock, screen.seconds);
+  drawCenteredText(5, screen.city);
+  drawTextLine(6, 0, screen.nextLine);
+  drawTextLine(7, 0, screen.statusLine);
+}
+
+void drawAlertScreen(const char* banner, const char* detail) {
+  fbClear();
+  drawCenteredText(2, banner, fbTextWidth(banner, 2) <= DISPLAY_WIDTH ? 2 : 1, true);
+  drawCenteredText(5, detail);
+  fbFillRect(4, 57, DISPLAY_WIDTH - 8, 6, true);
+}
+
+// Seconds left and a bar that shrinks from the right
+void drawAlertProgress(unsigned long elapsed, unsigned long duration) {
+  char countdown[12];
+  snprintf(countdown, sizeof(countdown), "%us", (unsigned)((duration - elapsed + 999) / 1000));
+  drawCenteredText(6, countdown);
+
+  int barWidth = DISPLAY_WIDTH - 8;
+  int remaining = barWidth - (int)((unsigned long)barWidth * elapsed / duration);
+  fbFillRect(4, 57, remaining, 6, true);
+  fbFillRect(4 + remaining, 57, barWidth - remaining, 6, false);
+}
+
+void drawStatusScreen(const StatusScreen& status) {
+  fbClear();
+  drawCenteredText(0, "System Status");
+  drawTextLine(2, 0, status.wifiConnected ? "WiFi: Connected" : "WiFi: Disconnected");
+  drawTextLine(3, 0, status.rtcOk ? "RTC:  OK" : "RTC:  Error");
+  drawTextLine(4, 0, status.sdOk ? "SD:   OK" : "SD:   Error");
+  drawTextLine(5, 0, status.panelPresent ? "OLED: SSD1306" : "OLED: off-screen");
+}
@@ -1,32 +1,239 @@
 #include "global.h"
+#include "framebuffer.h"
+#include "display_layouts.h"
 
 // Display update intervals
 unsigned long lastDisplayUpdate = 0;
 
+// SSD1306 control bytes
+#define SSD1306_COMMAND 0x00
+#define SSD1306_DATA 0x40
+
+static bool panelPresent = false;
+
+// Flush accounting: only changed columns of changed pages go over I2C
+static uint32_t flushCount = 0;
+static uint32_t flushedBytes = 0;     // GDDRAM bytes, excluding addressing
+static uint32_t lastFlushBytes = 0;
+static uint32_t lastFlushMicros = 0;
+
+// Alert animation, advanced from updateDisplay() instead of blocking the loop
+struct AlertAnimation {
+    bool active;
+    bool flashing;              // Prayer time flashes, the warning is steady
+    bool inverted;              // Current panel inversion
+    unsigned long startedAt;
+    unsigned long duration;
+    unsigned long lastFrameAt;
+    char banner[20];
+    char detail[22];
+};
+
+static AlertAnimation alert = {};
+static uint32_t alertFrames = 0;
+static uint32_t maxAlertFrameMicros = 0;
+
+// Menu 11 test screens, stepped from updateDisplay(); an alert cancels it
+struct DisplayTest {
+    bool active;
+    uint8_t screen;
+    unsigned long shownAt;
+};
+
+static DisplayTest displayTest = {};
+
+// Power-on sequence for a 128x64 panel with the internal charge pump
+static const uint8_t ssd1306Init[] = {
+    0xAE,        // Display off
+    0xD5, 0x80,  // Clock divide ratio / oscillator
+    0xA8, 0x3F,  // Multiplex ratio 64
+    0xD3, 0x00,  // No display offset
+    0x40,        // Start line 0
+    0x8D, 0x14,  // Charge pump on
+    0x20, 0x00,  // Horizontal addressing, so a column window wraps by page
+    0xA1,        // Segment remap (column 127 -> SEG0)
+    0xC8,        // COM scan descending
+    0xDA, 0x12,  // COM pins, alternative configuration
+    0x81, 0xCF,  // Contrast
+    0xD9, 0xF1,  // Pre-charge period
+    0xDB, 0x40,  // VCOMH deselect level
+    0xA4,        // Resume from GDDRAM
+    0xA6,        // Normal (not inverted)
+    0x2E,        // No scrolling
+    0xAF         // Display on
+};
+
+static bool sendCommands(const uint8_t* commands, size_t length) {
+    Wire.beginTransmission(DISPLAY_I2C_ADDRESS);
+    Wire.write(SSD1306_COMMAND);
+    Wire.write(commands, length);
+    return Wire.endTransmission() == 0;
+}
+
+// Sends the dirty column range of every changed page, then marks the frame clean
+static void flushDisplay() {
+    uint32_t started = micros();
+    uint32_t bytes = 0;
+    const uint8_t* frame = fbData();
+
+    for (int page = 0; page < FRAMEBUFFER_PAGES; page++) {
+        int first, last;
+        if (!fbPageDirty(page, first, last)) {
+            continue;
+        }
+        bytes += last - first + 1;
+        if (!panelPresent) {
+            continue;
+        }
+
+        const uint8_t window[] = {
+            0x21, (uint8_t)first, (uint8_t)last,  // Column range
+            0x22, (uint8_t)page, (uint8_t)page    // Page range
+        };
+        sendCommands(window, sizeof(window));
+
+        const uint8_t* data = frame + page * DISPLAY_WIDTH;
+        for (int x = first; x <= last; x += DISPLAY_I2C_CHUNK) {
+            int count = min(DISPLAY_I2C_CHUNK, last - x + 1);
+            Wire.beginTransmission(DISPLAY_I2C_ADDRESS);
+            Wire.write(SSD1306_DATA);
+            Wire.write(data + x, count);
+            Wire.endTransmission();
+        }
+    }
+    fbMarkClean();
+
+    if (bytes > 0) {
+        flushCount++;
+        flushedBytes += bytes;
+        lastFlushBytes = bytes;
+        lastFlushMicros = micros() - started;
+    }
+}
+
+// Whole-panel inversion is a single command, far cheaper than redrawing
+static void setPanelInverted(bool inverted) {
+    if (alert.inverted == inverted) {
+        return;
+    }
+    alert.inverted = inverted;
+    if (panelPresent) {
+        const uint8_t command = inverted ? 0xA7 : 0xA6;
+        sendCommands(&command, 1);
+    }
+}
+
 void initializeDisplay() {
     Serial.println(F("Display Manager: Initializing display hardware..."));
-    Serial.println(F("Display Manager: Display hardware initialized"));
-    clearDisplay();
+
+    // The RTC already started the bus; this only raises the clock
+    Wire.begin(RTC_SDA_PIN, RTC_SCL_PIN);
+    Wire.setClock(DISPLAY_I2C_CLOCK);
+    Wire.beginTransmission(DISPLAY_I2C_ADDRESS);
+    panelPresent = Wire.endTransmission() == 0 && sendCommands(ssd1306Init, sizeof(ssd1306Init));
+
+    if (panelPresent) {
+        Serial.println(F("Display Manager: Display hardware initialized"));
+    } else {
+        // Keep rendering so status and screenshots still work
+        Serial.println(F("Display Manager: No SSD1306 found, rendering off-screen"));
+    }
+
+    // Panel RAM is undefined after power-up, so the first frame goes out whole
+    fbClear();
+    fbMarkAllDirty();
     displayWelcomeMessage();
 }
 
 void clearDisplay() {
+    fbClear();
+    flushDisplay();
     Serial.println(F("Display cleared"));
 }
 
 void displayWelcomeMessage() {
     Serial.println(F("=== Islamic Prayer Times System ==="));
-    Serial.println(F("    Initializing..."));
-    delay(2000);
+    // Stays up while storage and network start; boot does not wait on it
+    Serial.println(warmBoot ? F("    Resuming...") : F("    Initializing..."));
+
+    fbClear();
+    drawCenteredText(1, "Prayer Times");
+    drawCenteredText(3, warmBoot ? "Resuming..." : "Initializing...");
+    flushDisplay();
+}
+
+static void startAlertAnimation(const String& banner, const char* detail, unsigned long duration, bool flashing) {
+    if (displayTest.active) {
+        displayTest.active = false;
+        SerialBT.println(F("Display test interrupted by an alert"));
+    }
+    alert.active = true;
+    alert.flashing = flashing;
+    alert.startedAt = millis();
+    alert.duration = duration;
+    alert.lastFrameAt = alert.startedAt - DISPLAY_ALERT_FRAME_INTERVAL;
+    snprintf(alert.banner, sizeof(alert.banner), "%s", banner.c_str());
+    snprintf(alert.detail, sizeof(alert.detail), "%s", detail);
+
+    // Static parts once; frames only touch the countdown, the bar and the inversion
+    drawAlertScreen(alert.banner, alert.detail);
+}
+
+static void finishAlertAnimation(unsigned long currentMillis) {
+    alert.active = false;
+    setPanelInverted(false);
+    fbClear();
+    // Redraw the clock on this pass instead of a second later
+    lastDisplayUpdate = currentMillis - DISPLAY_UPDATE_INTERVAL;
+}
+
+// One animation frame: flash phase, seconds left and a shrinking progress bar
+static void renderAlertFrame(unsigned long currentMillis) {
+    uint32_t started = micros();
+    unsigned long elapsed = currentMillis - alert.startedAt;
+
+    setPanelInverted(alert.flashing && (elapsed / DISPLAY_ALERT_FLASH_PERIOD) % 2 == 1);
+    drawAlertProgress(elapsed, alert.duration);
+    flushDisplay();
+
+    uint32_t frameMicros = micros() - started;
+    alertFrames++;
+    if (frameMicros > maxAlertFrameMicros) {
+        maxAlertFrameMicros = frameMicros;
+    }
 }
 
+static void serviceAlertAnimation(unsigned long currentMillis) {
+    if (currentMillis - alert.startedAt >= alert.duration) {
+        finishAlertAnimation(currentMillis);
+        return;
+    }
+    if (currentMillis - alert.lastFrameAt >= DISPLAY_ALERT_FRAME_INTERVAL) {
+        alert.lastFrameAt = currentMillis;
+        renderAlertFrame(currentMillis);
+    }
+}
+
+static void serviceDisplayTest(unsigned long currentMillis);
+
 void updateDisplay() {
     unsigned long currentMillis = millis();
-    
+
+    if (alert.active) {
+        serviceAlertAnimation(currentMillis);
+        if (alert.active) {
+            return;
+        }
+    }
+    if (displayTest.active) {
+        serviceDisplayTest(currentMillis);
+        return;
+    }
+
     // Update display every second
-    if (currentMillis - lastDisplayUpdate >= 1000) {
+    if (currentMillis - lastDisplayUpdate >= DISPLAY_UPDATE_INTERVAL) {
         lastDisplayUpdate = currentMillis;
-        
+
         DateTime now = rtc.now();
         if (now.year() > 2000) { // Valid time check
             displayCurrentInfo(now);
@@ -36,14 +243,50 @@ void updateDisplay() {
     }
 }
 
+// "Asr in 00:42:13" from the incremental countdown
+static void formatNextPrayer(char* buffer, size_t size) {
+    NextPrayer next;
+    if (!getNextPrayer(next)) {
+        snprintf(buffer, size, "No schedule");
+        return;
+    }
+    snprintf(buffer, size, "%s in %02ld:%02ld:%02ld", schedulePrayerName(next.prayer),
+             (long)(next.secondsLeft / 3600), (long)(next.secondsLeft / 60 % 60),
+             (long)(next.secondsLeft % 60));
+}
+
 void displayCurrentInfo(DateTime now) {
     // Format current time and date
     char timeStr[9];
     char dateStr[11];
-    
+
     sprintf(timeStr, "%02d:%02d:%02d", now.hour(), now.minute(), now.second());
     sprintf(dateStr, "%02d/%02d/%04d", now.day(), now.month(), now.year());
-    
+    char clockStr[6];
+    char secondsStr[3];
+    snprintf(clockStr, sizeof(clockStr), "%02d:%02d", now.hour(), now.minute());
+    snprintf(secondsStr, sizeof(secondsStr), "%02d", now.second());
+
+    char topLine[22];
+    char cityLine[22];
+    {
+        StorageLock lock; // City and timezone can change from the boot network task
+        snprintf(topLine, sizeof(topLine), "%s %s", dateStr,
+                 isDaylightTime(now) ? activeTimezone.dstOffsetLabel : activeTimezone.offsetLabel);
+        snprintf(cityLine, sizeof(cityLine), "%s", currentCity.c_str());
+    }
+    updatePrayerCountdown(now);
+    char nextLine[22];
+    formatNextPrayer(nextLine, sizeof(nextLine));
+    char statusLine[22];
+    snprintf(statusLine, sizeof(statusLine), "WiFi:%s BT:%s SD:%s",
+             isWiFiConnected() ? "on" : "--", bluetoothConnected ? "on" : "--",
+             sdCardInitialized ? "ok" : "--");
+
+    ClockScreen screen = {topLine, clockStr, secondsStr, cityLine, nextLine, statusLine};
+    drawClockScreen(screen);
+    flushDisplay();
+
     // Display to Serial (for debugging) - only every 10 seconds to avoid spam
     static unsigned long lastSerialUpdate = 0;
     if (millis() - lastSerialUpdate >= 10000) {
@@ -51,36 +294,205 @@ void displayCurrentInfo(DateTime now) {
         Serial.println(F("=== Current Display Info ==="));
         Serial.printf("Time: %s\n", timeStr);
         Serial.printf("Date: %s\n", dateStr);
+        StorageLock lock;
         Serial.printf("City: %s (%s)\n", currentCity.c_str(), currentTimezone.c_str());
     }
 }
 
 void displayPrayerAlert(const String& prayerName) {
     Serial.printf("PRAYER ALERT: %s TIME!\n", prayerName.c_str());
-    
-    // Flash display for 10 seconds
-    for (int i = 0; i < 10; i++) {
-        delay(500);
-        delay(500);
-    }
+
+    // Flashes for DISPLAY_ALERT_DURATION while the buzzer pattern runs
+    startAlertAnimation(prayerName, "Prayer time", DISPLAY_ALERT_DURATION, true);
 }
 
 void displayWarningAlert(const String& prayerName, int minutesLeft) {
     Serial.printf("PRAYER WARNING: %s in %d minutes\n", prayerName.c_str(), minutesLeft);
+
+    char detail[22];
+    snprintf(detail, sizeof(detail), "in %d minutes", minutesLeft);
+    startAlertAnimation(prayerName, detail, DISPLAY_WARNING_DURATION, false);
 }
 
 void displayError(const String& errorMsg) {
     Serial.printf("DISPLAY ERROR: %s\n", errorMsg.c_str());
+
+    fbClear();
+    drawCenteredText(3, errorMsg.c_str());
+    flushDisplay();
 }
 
 void displaySystemStatus() {
     Serial.println(F("=== System Status ==="));
-    
-    extern bool wifiConnected;
+
     extern bool rtcInitialized;
     extern bool sdCardInitialized;
-    
-    Serial.printf("WiFi: %s\n", wifiConnected ? "Connected" : "Disconnected");
+
+    Serial.printf("WiFi: %s\n", isWiFiConnected() ? "Connected" : "Disconnected");
     Serial.printf("RTC: %s\n", rtcInitialized ? "OK" : "Error");
     Serial.printf("SD Card: %s\n", sdCardInitialized ? "OK" : "Error");
-}
\ No newline at end of file
+
+    StatusScreen status = {isWiFiConnected(), rtcInitialized, sdCardInitialized, panelPresent};
+    drawStatusScreen(status);
+}
+
+// Test screens: every pixel on and off, both text scales, the clock digits
+// and panel inversion. Each is drawn whole so its flush cost is comparable.
+static void drawTestAllOn() {
+    fbFillRect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, true);
+}
+
+static void drawTestCheckerboard() {
+    for (int page = 0; page < FRAMEBUFFER_PAGES; page++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            fbWriteByte(page, x, (x & 1) ? 0xAA : 0x55);
+        }
+    }
+}
+
+static void drawTestText() {
+    drawTextLine(0, 0, " !\"#$%&'()*+,-./0123");
+    drawTextLine(1, 0, "456789:;<=>?@ABCDEFG");
+    drawTextLine(2, 0, "HIJKLMNOPQRSTUVWXYZ[");
+    drawTextLine(3, 0, "abcdefghijklmnopqrst");
+    drawCenteredText(5, "Scale 2", 2);
+}
+
+static void drawTestDigits() {
+    drawCenteredText(0, "Clock digits");
+    fbDrawBigText((DISPLAY_WIDTH - fbBigTextWidth("88:88")) / 2, 2, "88:88");
+}
+
+static void drawTestInverted() {
+    drawCenteredText(3, "Inverted");
+    setPanelInverted(true);
+}
+
+struct DisplayTestScreen {
+    const char* name;
+    void (*draw)();
+};
+
+static const DisplayTestScreen displayTestScreens[] = {
+    {"all on", drawTestAllOn},
+    {"checkerboard", drawTestCheckerboard},
+    {"text", drawTestText},
+    {"digits", drawTestDigits},
+    {"inverted", drawTestInverted},
+    {"status", displaySystemStatus},
+};
+
+static const int displayTestScreenCount = sizeof(displayTestScreens) / sizeof(displayTestScreens[0]);
+
+static void showDisplayTestScreen(unsigned long currentMillis) {
+    const DisplayTestScreen& screen = displayTestScreens[displayTest.screen];
+    displayTest.shownAt = currentMillis;
+    setPanelInverted(false);
+    fbClear();
+    screen.draw();
+    flushDisplay();
+    SerialBT.printf("  %-12s %4lu bytes in %lu us\n", screen.name, (unsigned long)lastFlushBytes,
+                    (unsigned long)lastFlushMicros);
+}
+
+static void serviceDisplayTest(unsigned long currentMillis) {
+    if (currentMillis - displayTest.shownAt < DISPLAY_TEST_STEP) {
+        return;
+    }
+    if (++displayTest.screen < displayTestScreenCount) {
+        showDisplayTestScreen(currentMillis);
+        return;
+    }
+    displayTest.active = false;
+    setPanelInverted(false);
+    fbClear();
+    lastDisplayUpdate = currentMillis - DISPLAY_UPDATE_INTERVAL;
+    SerialBT.println(F("Display test complete"));
+}
+
+// Runs alongside loop(); returns false while an alert owns the panel
+bool startDisplayTest() {
+    if (alert.active) {
+        return false;
+    }
+    SerialBT.printf("Display test: %d screens, %.1f s each\n", displayTestScreenCount, DISPLAY_TEST_STEP / 1000.0f);
+    displayTest.active = true;
+    displayTest.screen = 0;
+    showDisplayTestScreen(millis());
+    return true;
+}
+
+void stopDisplayTest() {
+    if (displayTest.active) {
+        // The next service pass finishes the sequence and restores the clock
+        displayTest.screen = displayTestScreenCount - 1;
+        displayTest.shownAt = millis() - DISPLAY_TEST_STEP;
+    }
+}
+
+void showDisplayStats() {
+    SerialBT.print(F("Display: "));
+    SerialBT.print(panelPresent ? F("SSD1306") : F("not found (off-screen)"));
+    SerialBT.print(F(", "));
+    SerialBT.print(flushCount);
+    SerialBT.print(F(" flushes, "));
+    SerialBT.print(flushedBytes);
+    SerialBT.print(F(" bytes (full frame "));
+    SerialBT.print(FRAMEBUFFER_SIZE);
+    SerialBT.print(F("), last "));
+    SerialBT.print(lastFlushBytes);
+    SerialBT.print(F(" bytes in "));
+    SerialBT.print(lastFlushMicros);
+    SerialBT.println(F(" us"));
+    SerialBT.print(F("Alert frames: "));
+    SerialBT.print(alertFrames);
+    SerialBT.print(F(", slowest "));
+    SerialBT.print(maxAlertFrameMicros);
+    SerialBT.println(F(" us"));
+}
+
+// Draw cost per call for each glyph path; the frame is redrawn afterwards
+void runRenderBenchmark(int iterations) {
+    struct RenderCase {
+        const char* name;
+        const char* text[2];   // Alternated so every call changes the frame
+        int kind;              // 0 = text, 1 = scale-2 text, 2 = large digits
+    };
+    static const RenderCase cases[] = {
+        {"text 6x8", {"Next: Maghrib 18:05", "Next: Isha    19:17"}, 0},
+        {"text x2", {"12:34:56", "23:45:07"}, 1},
+        {"big digits", {"12:34", "09:58"}, 2},
+    };
+
+    SerialBT.print(F("Render benchmark, "));
+    SerialBT.print(iterations);
+    SerialBT.println(F(" draws per case (no flush):"));
+    for (const RenderCase& test : cases) {
+        uint32_t started = micros();
+        for (int i = 0; i < iterations; i++) {
+            const char* text = test.text[i & 1];
+            if (test.kind == 2) {
+                fbDrawBigText(0, 1, text);
+            } else {
+                fbDrawText(0, test.kind == 1 ? 2 : 6, text, test.kind == 1 ? 2 : 1);
+            }
+        }
+        uint32_t elapsed = micros() - started;
+        float perDraw = (float)elapsed / iterations;
+        SerialBT.printf("  %-10s %7.2f us/draw, %5.2f us/glyph\n", test.name, perDraw,
+                        perDraw / strlen(test.text[0]));
+    }
+
+    // Put the clock face back on the next pass
+    fbClear();
+    lastDisplayUpdate = millis() - DISPLAY_UPDATE_INTERVAL;
+}
+
+static void writeToBluetooth(const uint8_t* data, size_t length, void* context) {
+    SerialBT.write(data, length);
+}
+
+// Plain PBM so a terminal capture can be saved straight to a .pbm file
+void dumpDisplayScreenshot() {
+    fbWritePbm(writeToBluetooth, nullptr, true);
+}
@@ -0,0 +1,265 @@
+/*
+ * Flash Cache Tier Implementation
+ * Compact binary schedules for the current plus next FLASH_CACHE_HORIZON_DAYS
+ * days in LittleFS, mirrored in RAM. SD card keeps the long history.
+ */
+
+#include "global.h"
+#include <LittleFS.h>
+
+bool flashCacheInitialized = false;
+
+static DaySchedule flashSlots[FLASH_TIER_SLOTS];
+static String flashTierCity = "";
+static bool flashTierLoaded = false;
+
+static String flashTierPath(const String& city) {
+  return "/" + city + ".bin";
+}
+
+static int flashSlotIndex(int32_t dayNumber) {
+  return ((dayNumber % FLASH_TIER_SLOTS) + FLASH_TIER_SLOTS) % FLASH_TIER_SLOTS;
+}
+
+static bool isWithinFlashWindow(int32_t dayNumber) {
+  CivilDate date = getToday();
+  if (!isValidDate(date)) {
+    return true;
+  }
+  int32_t today = daysFromCivil(date);
+  return dayNumber >= today - 1 && dayNumber <= today + FLASH_CACHE_HORIZON_DAYS;
+}
+
+static bool writeFlashTierFile(const String& city) {
+  FlashTierHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = FLASH_TIER_MAGIC;
+  header.version = FLASH_TIER_VERSION;
+  header.slotCount = FLASH_TIER_SLOTS;
+  city.toCharArray(header.city, sizeof(header.city));
+
+  File file = LittleFS.open(flashTierPath(city), FILE_WRITE);
+  if (!file) {
+    debugPrintln("Failed to create flash cache file for " + city);
+    return false;
+  }
+  file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const uint8_t*>(flashSlots), sizeof(flashSlots));
+  file.close();
+  return true;
+}
+
+// Mirrors one city's slot table into RAM; lookups afterwards are memory only
+static void loadFlashTier(const String& city) {
+  memset(flashSlots, 0, sizeof(flashSlots));
+  flashTierCity = city;
+  flashTierLoaded = true;
+
+  File file = LittleFS.open(flashTierPath(city), FILE_READ);
+  if (!file) {
+    return;
+  }
+
+  FlashTierHeader header;
+  bool valid = file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+               header.magic == FLASH_TIER_MAGIC &&
+               header.version == FLASH_TIER_VERSION &&
+               header.slotCount == FLASH_TIER_SLOTS &&
+               file.read(reinterpret_cast<uint8_t*>(flashSlots), sizeof(flashSlots)) == sizeof(flashSlots);
+  file.close();
+
+  if (!valid) {
+    debugPrintln("Flash cache file invalid, resetting: " + flashTierPath(city));
+    memset(flashSlots, 0, sizeof(flashSlots));
+    return;
+  }
+
+  int validCount = 0;
+  for (int i = 0; i < FLASH_TIER_SLOTS; i++) {
+    if (flashSlots[i].dayNumber != 0 && flashSlots[i].crc == dayScheduleCrc(flashSlots[i])) {
+      validCount++;
+    } else {
+      memset(&flashSlots[i], 0, sizeof(DaySchedule));
+    }
+  }
+  debugPrintln("Flash cache loaded for " + city + ": " + String(validCount) + " days");
+}
+
+static void ensureFlashTierCity() {
+  if (!flashTierLoaded || flashTierCity != currentCity) {
+    loadFlashTier(currentCity);
+  }
+}
+
+void initializeFlashCache() {
+  // Partition label matches the spare data partition in huge_app.csv
+  if (LittleFS.begin(true, "/littlefs", 4, "spiffs")) {
+    flashCacheInitialized = true;
+    debugPrintln("Flash cache initialized (" + String((uint32_t)(LittleFS.usedBytes() / 1024)) + "/" +
+                 String((uint32_t)(LittleFS.totalBytes() / 1024)) + " KB used)");
+    ensureFlashTierCity();
+  } else {
+    flashCacheInitialized = false;
+    debugPrintln("ERROR: Could not mount flash cache partition");
+  }
+}
+
+bool loadFlashSchedule(int32_t dayNumber, DaySchedule& schedule) {
+  StorageLock lock;
+  if (!flashCacheInitialized) {
+    return false;
+  }
+  ensureFlashTierCity();
+
+  const DaySchedule& slot = flashSlots[flashSlotIndex(dayNumber)];
+  if (slot.dayNumber != dayNumber) {
+    return false;
+  }
+  schedule = slot;
+  return true;
+}
+
+bool storeFlashSchedule(const DaySchedule& schedule) {
+  StorageLock lock;
+  if (!flashCacheInitialized || !isWithinFlashWindow(schedule.dayNumber)) {
+    return false;
+  }
+  ensureFlashTierCity();
+
+  int index = flashSlotIndex(schedule.dayNumber);
+  DaySchedule& slot = flashSlots[index];
+  // Every field but the CRC, so a new UTC offset for the same times is written too
+  if (memcmp(&slot, &schedule, offsetof(DaySchedule, crc)) == 0) {
+    return true; // Unchanged, skip the flash write
+  }
+
+  // Slot reuse evicts whatever day left the window
+  slot = schedule;
+  slot.crc = dayScheduleCrc(slot);
+
+  File file = LittleFS.open(flashTierPath(currentCity), "r+");
+  if (!file) {
+    return writeFlashTierFile(currentCity);
+  }
+  file.seek(sizeof(FlashTierHeader) + index * sizeof(DaySchedule));
+  size_t written = file.write(reinterpret_cast<const uint8_t*>(&slot), sizeof(DaySchedule));
+  file.close();
+  return written == sizeof(DaySchedule);
+}
+
+void storeFlashScheduleFromJson(const String& jsonData, const CivilDate& date) {
+  StorageLock lock;
+  DaySchedule schedule;
+  if (parseDaySchedule(jsonData, date, schedule)) {
+    storeDaySchedule(schedule);
+  }
+}
+
+// A current-city day from any source: flash tier, plus the alert path if it is today or tomorrow
+bool storeDaySchedule(const DaySchedule& schedule) {
+  StorageLock lock;
+  // Today and tomorrow also go to the warm snapshot and alert path, from loop()
+  int32_t ahead = schedule.dayNumber - daysFromCivil(getToday());
+  if (ahead >= 0 && ahead < WARM_BOOT_DAYS) {
+    SystemEvent event;
+    event.type = EVENT_SCHEDULE_UPDATED;
+    event.schedule = schedule;
+    postSystemEvent(event);
+  }
+
+  return flashCacheInitialized && storeFlashSchedule(schedule);
+}
+
+// Flash first, then SD (promoting the result into flash)
+bool getDaySchedule(const CivilDate& date, DaySchedule& schedule) {
+  StorageLock lock;
+  if (loadFlashSchedule(daysFromCivil(date), schedule)) {
+    return true;
+  }
+
+  String jsonData;
+  if (!readCachedDay(date, jsonData)) {
+    return false;
+  }
+  if (!parseDaySchedule(jsonData, date, schedule)) {
+    debugPrintln("Cached day " + dateKeyString(date) + " does not parse");
+    discardCachedDay(date);
+    return false;
+  }
+
+  storeFlashSchedule(schedule);
+  return true;
+}
+
+// Same order as getDaySchedule(): a day held in flash counts even when the SD card lacks it
+bool isScheduleCached(const CivilDate& date) {
+  StorageLock lock;
+  DaySchedule schedule;
+  if (loadFlashSchedule(daysFromCivil(date), schedule)) {
+    return true;
+  }
+  return sdCardInitialized && isDayCached(currentCity, date);
+}
+
+// Copies SD-cached days inside the flash window that flash does not hold yet
+void promoteFlashWindow() {
+  StorageLock lock;
+  CivilDate today = getToday();
+  if (!flashCacheInitialized || !sdCardInitialized || !isValidDate(today)) {
+    return;
+  }
+
+  int promoted = 0;
+  for (int i = 0; i <= FLASH_CACHE_HORIZON_DAYS; i++) {
+    CivilDate target = addDays(today, i);
+    DaySchedule schedule;
+    if (loadFlashSchedule(daysFromCivil(target), schedule)) {
+      continue;
+    }
+    if (getDaySchedule(target, schedule)) {
+      promoted++;
+    }
+  }
+
+  if (promoted > 0) {
+    debugPrintln("Flash cache: promoted " + String(promoted) + " days from SD");
+  }
+}
+
+// Clears one day from RAM and flash so the next lookup misses
+void dropFlashSchedule(int32_t dayNumber) {
+  StorageLock lock;
+  if (!flashCacheInitialized) {
+    return;
+  }
+  ensureFlashTierCity();
+
+  int index = flashSlotIndex(dayNumber);
+  if (flashSlots[index].dayNumber != dayNumber) {
+    return;
+  }
+  memset(&flashSlots[index], 0, sizeof(DaySchedule));
+
+  File file = LittleFS.open(flashTierPath(currentCity), "r+");
+  if (file) {
+    file.seek(sizeof(FlashTierHeader) + index * sizeof(DaySchedule));
+    file.write(reinterpret_cast<const uint8_t*>(&flashSlots[index]), sizeof(DaySchedule));
+    file.close();
+  }
+}
+
+int countFlashScheduleDays() {
+  StorageLock lock;
+  if (!flashCacheInitialized) {
+    return 0;
+  }
+  ensureFlashTierCity();
+
+  int count = 0;
+  for (int i = 0; i < FLASH_TIER_SLOTS; i++) {
+    if (flashSlots[i].dayNumber != 0) {
+      count++;
+    }
+  }
+  return count;
+}
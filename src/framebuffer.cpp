@@ -0,0 +1,209 @@
+/*
+ * Framebuffer Implementation
+ * Drawing primitives, dirty tracking and PBM export for the 1 KB frame.
+ * See framebuffer.h for the layout.
+ */
+
+#include "framebuffer.h"
+#include "glyph_atlas.h"
+#include <stdio.h>
+#include <string.h>
+
+static uint8_t frame[FRAMEBUFFER_SIZE];
+static int16_t dirtyFirst[FRAMEBUFFER_PAGES];
+static int16_t dirtyLast[FRAMEBUFFER_PAGES];
+
+static const uint8_t* glyphFor(char c) {
+  if (c < GLYPH_FIRST_CHAR || c > GLYPH_LAST_CHAR) {
+    c = '?';
+  }
+  return textAtlas.columns[c - GLYPH_FIRST_CHAR];
+}
+
+void fbWriteByte(int page, int x, uint8_t value) {
+  if (page < 0 || page >= FRAMEBUFFER_PAGES || x < 0 || x >= DISPLAY_WIDTH) {
+    return;
+  }
+  uint8_t& current = frame[page * DISPLAY_WIDTH + x];
+  if (current == value) {
+    return;
+  }
+  current = value;
+  if (dirtyFirst[page] > dirtyLast[page]) {
+    dirtyFirst[page] = x;
+    dirtyLast[page] = x;
+  } else if (x < dirtyFirst[page]) {
+    dirtyFirst[page] = x;
+  } else if (x > dirtyLast[page]) {
+    dirtyLast[page] = x;
+  }
+}
+
+void fbMarkClean() {
+  for (int page = 0; page < FRAMEBUFFER_PAGES; page++) {
+    dirtyFirst[page] = DISPLAY_WIDTH;
+    dirtyLast[page] = -1;
+  }
+}
+
+void fbMarkAllDirty() {
+  for (int page = 0; page < FRAMEBUFFER_PAGES; page++) {
+    dirtyFirst[page] = 0;
+    dirtyLast[page] = DISPLAY_WIDTH - 1;
+  }
+}
+
+void fbClear() {
+  for (int page = 0; page < FRAMEBUFFER_PAGES; page++) {
+    fbClearSpan(page, 0, DISPLAY_WIDTH);
+  }
+}
+
+// Zeroes columns x0..x1-1 on `pages` pages starting at `page`
+void fbClearSpan(int page, int x0, int x1, int pages) {
+  for (int p = page; p < page + pages; p++) {
+    for (int x = x0; x < x1; x++) {
+      fbWriteByte(p, x, 0);
+    }
+  }
+}
+
+int fbTextWidth(const char* text, int scale) {
+  return (int)strlen(text) * CHAR_WIDTH * scale;
+}
+
+bool fbGetPixel(int x, int y) {
+  if (x < 0 || x >= DISPLAY_WIDTH || y < 0 || y >= DISPLAY_HEIGHT) {
+    return false;
+  }
+  return frame[(y >> 3) * DISPLAY_WIDTH + x] & (1 << (y & 7));
+}
+
+void fbSetPixel(int x, int y, bool on) {
+  if (x < 0 || x >= DISPLAY_WIDTH || y < 0 || y >= DISPLAY_HEIGHT) {
+    return;
+  }
+  uint8_t value = frame[(y >> 3) * DISPLAY_WIDTH + x];
+  uint8_t mask = 1 << (y & 7);
+  fbWriteByte(y >> 3, x, on ? (value | mask) : (value & ~mask));
+}
+
+// Whole bytes where the rectangle covers a page completely, masks at the edges
+void fbFillRect(int x, int y, int width, int height, bool on) {
+  int x0 = x < 0 ? 0 : x;
+  int x1 = x + width > DISPLAY_WIDTH ? DISPLAY_WIDTH : x + width;
+  int y0 = y < 0 ? 0 : y;
+  int y1 = y + height > DISPLAY_HEIGHT ? DISPLAY_HEIGHT : y + height;
+  for (int page = y0 >> 3; page <= (y1 - 1) >> 3 && y0 < y1; page++) {
+    int top = page * 8 > y0 ? 0 : y0 - page * 8;
+    int bottom = page * 8 + 8 < y1 ? 8 : y1 - page * 8;
+    uint8_t mask = (uint8_t)((0xFF << top) & (0xFF >> (8 - bottom)));
+    for (int column = x0; column < x1; column++) {
+      uint8_t value = frame[page * DISPLAY_WIDTH + column];
+      fbWriteByte(page, column, on ? (value | mask) : (value & ~mask));
+    }
+  }
+}
+
+// Opaque text on page boundaries at scale 1 or 2; returns the width drawn.
+// Inverted text lights the cell background instead of the glyph.
+int fbDrawText(int x, int page, const char* text, int scale, bool invert) {
+  uint8_t mask = invert ? 0xFF : 0x00;
+  int start = x;
+  for (const char* c = text; *c; c++) {
+    const uint8_t* glyph = glyphFor(*c);
+    if (scale == 1) {
+      for (int column = 0; column < CHAR_WIDTH; column++) {
+        fbWriteByte(page, x++, glyph[column] ^ mask);
+      }
+      continue;
+    }
+    for (int column = 0; column < CHAR_WIDTH; column++) {
+      uint16_t doubled = doubledRows.rows[glyph[column]];
+      uint8_t top = (uint8_t)doubled ^ mask;
+      uint8_t bottom = (uint8_t)(doubled >> 8) ^ mask;
+      for (int repeat = 0; repeat < 2; repeat++, x++) {
+        fbWriteByte(page, x, top);
+        fbWriteByte(page + 1, x, bottom);
+      }
+    }
+  }
+  return x - start;
+}
+
+// One 32-bit atlas column spans four pages
+static void writeBigColumn(int x, int page, uint32_t column) {
+  fbWriteByte(page, x, (uint8_t)column);
+  fbWriteByte(page + 1, x, (uint8_t)(column >> 8));
+  fbWriteByte(page + 2, x, (uint8_t)(column >> 16));
+  fbWriteByte(page + 3, x, (uint8_t)(column >> 24));
+}
+
+static int bigGlyphWidth(char c) {
+  return c == ':' ? BIG_COLON_WIDTH : BIG_DIGIT_WIDTH + BIG_DIGIT_GAP;
+}
+
+int fbBigTextWidth(const char* text) {
+  int width = 0;
+  for (const char* c = text; *c; c++) {
+    width += bigGlyphWidth(*c);
+  }
+  return width;
+}
+
+// Digits and ':' only, anything else draws as a blank digit cell
+int fbDrawBigText(int x, int page, const char* text) {
+  int start = x;
+  for (const char* c = text; *c; c++) {
+    if (*c == ':') {
+      for (int column = 0; column < BIG_COLON_WIDTH; column++) {
+        writeBigColumn(x++, page, bigDigits.colon[column]);
+      }
+      continue;
+    }
+    const uint32_t* digit = (*c >= '0' && *c <= '9') ? bigDigits.digits[*c - '0'] : nullptr;
+    for (int column = 0; column < BIG_DIGIT_WIDTH; column++) {
+      writeBigColumn(x++, page, digit ? digit[column] : 0);
+    }
+    for (int column = 0; column < BIG_DIGIT_GAP; column++) {
+      writeBigColumn(x++, page, 0);
+    }
+  }
+  return x - start;
+}
+
+const uint8_t* fbData() {
+  return frame;
+}
+
+bool fbPageDirty(int page, int& first, int& last) {
+  first = dirtyFirst[page];
+  last = dirtyLast[page];
+  return first <= last;
+}
+
+void fbWritePbm(FrameWriter writer, void* context, bool plain) {
+  char header[24];
+  int length = snprintf(header, sizeof(header), "%s\n%d %d\n", plain ? "P1" : "P4", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+  writer(reinterpret_cast<const uint8_t*>(header), length, context);
+
+  // Rows are rebuilt from the page layout, MSB first as PBM expects
+  uint8_t row[DISPLAY_WIDTH + 1];
+  for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+    if (plain) {
+      for (int x = 0; x < DISPLAY_WIDTH; x++) {
+        row[x] = fbGetPixel(x, y) ? '1' : '0';
+      }
+      row[DISPLAY_WIDTH] = '\n';
+      writer(row, DISPLAY_WIDTH + 1, context);
+    } else {
+      memset(row, 0, DISPLAY_WIDTH / 8);
+      for (int x = 0; x < DISPLAY_WIDTH; x++) {
+        if (fbGetPixel(x, y)) {
+          row[x >> 3] |= 0x80 >> (x & 7);
+        }
+      }
+      writer(row, DISPLAY_WIDTH / 8, context);
+    }
+  }
+}
@@ -0,0 +1,200 @@
+/*
+ * Gzip Inflate Implementation
+ * Streaming gzip decoder for API responses on top of the tinfl inflater in
+ * the ESP32 ROM. Compressed bytes are fed as they come off the socket; the
+ * output buffer doubles as the deflate window (bodies are capped at
+ * MAX_FILE_SIZE), so no separate 32 KB dictionary is needed.
+ *
+ * Decoding streams, but the result does not: the whole decoded body stays
+ * in the MAX_FILE_SIZE output buffer (next to the ~11 KB decompressor)
+ * until gzipInflateFinish() copies it into the caller's String, because
+ * the response handlers parse and store bodies as Strings. Peak heap for
+ * a gzip response is therefore both buffers plus the body copy.
+ */
+
+#include "global.h"
+#include <rom/miniz.h>
+
+enum GzipStage {
+  GZIP_STAGE_HEADER,
+  GZIP_STAGE_EXTRA_LENGTH,
+  GZIP_STAGE_EXTRA,
+  GZIP_STAGE_NAME,
+  GZIP_STAGE_COMMENT,
+  GZIP_STAGE_HEADER_CRC,
+  GZIP_STAGE_DEFLATE,
+  GZIP_STAGE_TRAILER,
+  GZIP_STAGE_DONE
+};
+
+// RFC 1952 header flags
+#define GZIP_FLAG_HCRC 0x02
+#define GZIP_FLAG_EXTRA 0x04
+#define GZIP_FLAG_NAME 0x08
+#define GZIP_FLAG_COMMENT 0x10
+
+static tinfl_decompressor* inflater = nullptr;
+static uint8_t* output = nullptr;
+static size_t outputLength = 0;
+static GzipStage stage = GZIP_STAGE_HEADER;
+static uint8_t fieldBytes[10];   // Fixed header, then the 8-byte trailer
+static size_t fieldLength = 0;
+static size_t skipLength = 0;
+static uint8_t flags = 0;
+
+bool gzipInflateReserve() {
+  if (!inflater) {
+    inflater = static_cast<tinfl_decompressor*>(malloc(sizeof(tinfl_decompressor)));
+  }
+  if (!output) {
+    output = static_cast<uint8_t*>(malloc(MAX_FILE_SIZE));
+  }
+  if (!inflater || !output) {
+    gzipInflateRelease();
+    return false;
+  }
+  return true;
+}
+
+void gzipInflateRelease() {
+  free(inflater);
+  free(output);
+  inflater = nullptr;
+  output = nullptr;
+}
+
+bool gzipInflateStart() {
+  if (!gzipInflateReserve()) {
+    return false;
+  }
+  tinfl_init(inflater);
+  outputLength = 0;
+  stage = GZIP_STAGE_HEADER;
+  fieldLength = 0;
+  skipLength = 0;
+  flags = 0;
+  return true;
+}
+
+// Collects a fixed-size field across calls; true once it is complete
+static bool collectField(const uint8_t*& data, size_t& length, size_t size) {
+  while (length > 0 && fieldLength < size) {
+    fieldBytes[fieldLength++] = *data++;
+    length--;
+  }
+  if (fieldLength < size) {
+    return false;
+  }
+  fieldLength = 0;
+  return true;
+}
+
+// Moves past the optional header fields that are not present
+static void nextHeaderStage() {
+  if (stage < GZIP_STAGE_EXTRA_LENGTH && (flags & GZIP_FLAG_EXTRA)) {
+    stage = GZIP_STAGE_EXTRA_LENGTH;
+  } else if (stage < GZIP_STAGE_NAME && (flags & GZIP_FLAG_NAME)) {
+    stage = GZIP_STAGE_NAME;
+  } else if (stage < GZIP_STAGE_COMMENT && (flags & GZIP_FLAG_COMMENT)) {
+    stage = GZIP_STAGE_COMMENT;
+  } else if (stage < GZIP_STAGE_HEADER_CRC && (flags & GZIP_FLAG_HCRC)) {
+    stage = GZIP_STAGE_HEADER_CRC;
+    skipLength = 2;
+  } else {
+    stage = GZIP_STAGE_DEFLATE;
+  }
+}
+
+GzipStatus gzipInflateWrite(const uint8_t* data, size_t length) {
+  while (length > 0) {
+    switch (stage) {
+      case GZIP_STAGE_HEADER:
+        if (!collectField(data, length, 10)) {
+          return GZIP_NEEDS_INPUT;
+        }
+        // Magic 1f 8b, method 8 (deflate)
+        if (fieldBytes[0] != 0x1F || fieldBytes[1] != 0x8B || fieldBytes[2] != 8) {
+          return GZIP_FAILED;
+        }
+        flags = fieldBytes[3];
+        nextHeaderStage();
+        break;
+
+      case GZIP_STAGE_EXTRA_LENGTH:
+        if (!collectField(data, length, 2)) {
+          return GZIP_NEEDS_INPUT;
+        }
+        skipLength = fieldBytes[0] | (fieldBytes[1] << 8);
+        stage = GZIP_STAGE_EXTRA;
+        break;
+
+      case GZIP_STAGE_EXTRA:
+      case GZIP_STAGE_HEADER_CRC: {
+        size_t skip = min(skipLength, length);
+        data += skip;
+        length -= skip;
+        skipLength -= skip;
+        if (skipLength == 0) {
+          nextHeaderStage();
+        }
+        break;
+      }
+
+      case GZIP_STAGE_NAME:
+      case GZIP_STAGE_COMMENT:
+        // Zero-terminated strings
+        length--;
+        if (*data++ == 0) {
+          nextHeaderStage();
+        }
+        break;
+
+      case GZIP_STAGE_DEFLATE: {
+        size_t inSize = length;
+        size_t outSize = MAX_FILE_SIZE - outputLength;
+        tinfl_status status = tinfl_decompress(inflater, data, &inSize, output, output + outputLength, &outSize,
+                                               TINFL_FLAG_HAS_MORE_INPUT | TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+        data += inSize;
+        length -= inSize;
+        outputLength += outSize;
+        if (status == TINFL_STATUS_DONE) {
+          stage = GZIP_STAGE_TRAILER;
+        } else if (status == TINFL_STATUS_HAS_MORE_OUTPUT) {
+          return GZIP_TOO_LARGE;
+        } else if (status < 0) {
+          return GZIP_FAILED;
+        }
+        break;
+      }
+
+      case GZIP_STAGE_TRAILER: {
+        if (!collectField(data, length, 8)) {
+          return GZIP_NEEDS_INPUT;
+        }
+        // CRC-32 and size of the uncompressed data, little endian
+        uint32_t crc = fieldBytes[0] | (fieldBytes[1] << 8) | (fieldBytes[2] << 16) | ((uint32_t)fieldBytes[3] << 24);
+        uint32_t size = fieldBytes[4] | (fieldBytes[5] << 8) | (fieldBytes[6] << 16) | ((uint32_t)fieldBytes[7] << 24);
+        if (size != outputLength || crc != cacheCrc32(output, outputLength)) {
+          return GZIP_FAILED;
+        }
+        stage = GZIP_STAGE_DONE;
+        break;
+      }
+
+      case GZIP_STAGE_DONE:
+        // Only one member per response
+        return GZIP_FAILED;
+    }
+  }
+  return stage == GZIP_STAGE_DONE ? GZIP_DONE : GZIP_NEEDS_INPUT;
+}
+
+// Appends the decoded body (a full copy of the output buffer); false unless
+// the stream ended with a valid trailer
+bool gzipInflateFinish(String& body) {
+  if (stage != GZIP_STAGE_DONE) {
+    return false;
+  }
+  body.concat(reinterpret_cast<const char*>(output), outputLength);
+  return true;
+}
@@ -0,0 +1,132 @@
+/*
+ * Network Load Test Implementation
+ * Drives the real fetch paths against tools/mock_aladhan.py and reports
+ * throughput, API tail latency, heap low-water mark and recovery.
+ * Built only in the esp32dev-mock environment (LOAD_TEST_ENABLED).
+ */
+
+#include "global.h"
+
+#ifdef LOAD_TEST_ENABLED
+
+struct LoadTestScenario {
+  const char* name;
+  void (*run)();
+  int firstDay;   // Window the scenario fetches, relative to today
+  int lastDay;
+};
+
+static void runSingleFetch() {
+  fetchPrayerTimes();
+}
+
+static void runForwardFetch() {
+  fetchPrayerTimesForDays(PRAYER_CACHE_DAYS);
+}
+
+// Today plus the week ahead as one call, the prefetcher's path without its pacing
+static void runWindowFetch() {
+  CivilDate today = getToday();
+  CivilDate window[PRAYER_CACHE_DAYS + 1];
+  for (int i = 0; i <= PRAYER_CACHE_DAYS; i++) {
+    window[i] = addDays(today, i);
+  }
+  fetchAndCacheDays(window, PRAYER_CACHE_DAYS + 1);
+  flushCacheManifests();
+}
+
+static const LoadTestScenario loadTestScenarios[] = {
+  {"fetchPrayerTimes", runSingleFetch, 0, 0},
+  {"fetchPrayerTimesForDays", runForwardFetch, 1, PRAYER_CACHE_DAYS},
+  {"fetchAndCacheDays", runWindowFetch, 0, PRAYER_CACHE_DAYS},
+};
+
+// Forget the window in every tier so each round goes to the network
+static void evictLoadTestWindow(const CivilDate& today) {
+  for (int i = 0; i <= PRAYER_CACHE_DAYS; i++) {
+    CivilDate date = addDays(today, i);
+    clearDayCached(currentCity, date);
+    dropFlashSchedule(daysFromCivil(date));
+  }
+  invalidateWarmBootSchedules();
+}
+
+static int countCachedDays(const CivilDate& today, int firstDay, int lastDay) {
+  int cached = 0;
+  for (int i = firstDay; i <= lastDay; i++) {
+    if (isScheduleCached(addDays(today, i))) {
+      cached++;
+    }
+  }
+  return cached;
+}
+
+void runLoadTest(int rounds) {
+  CivilDate today = getToday();
+  if (!isWiFiConnected() || !isValidDate(today)) {
+    SerialBT.println(F("Load test needs WiFi and a valid clock."));
+    return;
+  }
+
+  // No prefetch batch may run for the real city while the test city is set
+  ApiLock fetchLock;
+  String savedCity = currentCity;
+  {
+    StorageLock lock;
+    currentCity = LOAD_TEST_CITY;
+  }
+  SerialBT.println("Load test against " + String(ALADHAN_API_HOST) + ":" + String(ALADHAN_API_PORT) +
+                   ", " + String(rounds) + " rounds");
+
+  for (const LoadTestScenario& scenario : loadTestScenarios) {
+    resetApiClientStats();
+    uint32_t heapLow = ESP.getFreeHeap();
+    uint32_t totalMs = 0;
+    int expected = 0;
+    int cached = 0;
+
+    for (int round = 0; round < rounds; round++) {
+      evictLoadTestWindow(today);
+      unsigned long start = millis();
+      scenario.run();
+      totalMs += millis() - start;
+      heapLow = min(heapLow, ESP.getFreeHeap());
+      expected += scenario.lastDay - scenario.firstDay + 1;
+      cached += countCachedDays(today, scenario.firstDay, scenario.lastDay);
+    }
+
+    const ApiClientStats& stats = apiClientStats();
+    char line[96];
+    SerialBT.println(String("--- ") + scenario.name + " ---");
+    snprintf(line, sizeof(line), "  %lu ms total, %.2f days/s, %d/%d days cached",
+             (unsigned long)totalMs, totalMs > 0 ? cached * 1000.0f / totalMs : 0.0f, cached, expected);
+    SerialBT.println(line);
+    snprintf(line, sizeof(line), "  latency p50 %lu / p95 %lu / p99 %lu / max %lu ms",
+             (unsigned long)apiLatencyPercentile(50), (unsigned long)apiLatencyPercentile(95),
+             (unsigned long)apiLatencyPercentile(99), (unsigned long)stats.maxMs);
+    SerialBT.println(line);
+    snprintf(line, sizeof(line), "  %lu responses, %lu failed, %lu resent, %lu reconnects, %lu connections",
+             (unsigned long)stats.responses, (unsigned long)stats.failures, (unsigned long)stats.resentRequests,
+             (unsigned long)stats.reconnects, (unsigned long)stats.connections);
+    SerialBT.println(line);
+    snprintf(line, sizeof(line), "  %lu B on air per response, %.1fx gzip ratio",
+             (unsigned long)(stats.responses > 0 ? stats.wireBytes / stats.responses : 0),
+             stats.wireBytes > 0 ? (float)stats.bodyBytes / stats.wireBytes : 0.0f);
+    SerialBT.println(line);
+    snprintf(line, sizeof(line), "  heap low %lu bytes (boot low %lu), stack free %lu bytes",
+             (unsigned long)heapLow, (unsigned long)ESP.getMinFreeHeap(),
+             (unsigned long)uxTaskGetStackHighWaterMark(nullptr));
+    SerialBT.println(line);
+  }
+
+  // Leave the test city's data behind and go back to the real schedule
+  flushCacheManifests();
+  {
+    StorageLock lock;
+    currentCity = savedCity;
+  }
+  invalidateWarmBootSchedules();
+  SerialBT.println(F("Load test complete"));
+}
+
+#endif // LOAD_TEST_ENABLED
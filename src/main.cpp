@@ -1,6 +1,6 @@
 /*
  * ESP32 Prayer Times Controller - Main Program
- * Modular Architecture with Numbered Menu System and Midnight Caching
+ * Modular Architecture with Numbered Menu System and Background Caching
  */
 
 #include "global.h"
@@ -11,9 +11,9 @@ String savedPassword = "";
 String currentCity = DEFAULT_CITY;
 String currentTimezone = DEFAULT_TIMEZONE;
 int timezoneOffset = DEFAULT_TIMEZONE_OFFSET;
-bool wifiConnected = false;
 int reconnectRetries = 0;
 unsigned long lastReconnectAttempt = 0;
+unsigned long lastWiFiCheck = 0;
 int wifiNetworkCount = 0;
 
 String wifiNetworks[MAX_NETWORKS];
@@ -30,23 +30,15 @@ bool waitingForInput = false;
 bool isFirstBoot = false;
 String inputPrompt = "";
 
-// Midnight caching variables
-unsigned long lastMidnightCheck = 0;
-int lastCacheDay = -1;
-bool midnightCacheComplete = false;
-
 // Buzzer variables
 bool buzzerInitialized = false;
-BuzzerMode currentBuzzerMode = BUZZER_OFF;
 
 // Global Objects
 BluetoothSerial SerialBT;
 RTC_DS3231 rtc;
-HTTPClient http;
 Preferences preferences;
 
 // Function declarations for main.cpp only functions
-void initializeSystem();
 void checkFirstBoot();
 void handleFirstBootSetup();
 void processBluetoothCommands();
@@ -58,15 +50,13 @@ void showHelp();
 void restartDevice();
 void showTime();
 void showMenu();
-void checkMidnightCaching();
-void performMidnightCache();
 
 void setup() {
   Serial.begin(SERIAL_BAUD_RATE);
   debugPrintln("\n=== ESP32 Prayer Times Controller Starting ===");
 
-  // Initialize all subsystems
-  initializeSystem();
+  // Alert path first, then storage alongside Bluetooth (see boot_sequence.cpp)
+  runBootSequence();
   
   // Check if this is the first boot
   checkFirstBoot();
@@ -74,17 +64,9 @@ void setup() {
   if (isFirstBoot) {
     handleFirstBootSetup();
   } else {
-    // Load saved settings and try to reconnect
+    // Reconnect, sync and fetch in the background; loop() starts right away
     loadWiFiCredentials();
-    
-    if (savedSSID.length() > 0) {
-      connectToWiFi(savedSSID, savedPassword);
-      if (wifiConnected) {
-        syncTimeWithNTP();
-        fetchPrayerTimes();
-      }
-    }
-    
+    startBootNetwork();
     showMainMenu();
   }
   
@@ -92,8 +74,11 @@ void setup() {
 }
 
 void loop() {
-  // Check for midnight prayer times caching
-  checkMidnightCaching();
+  // Apply what the managers and the boot tasks reported since the last pass
+  dispatchSystemEvents();
+  
+  // Network and cache maintenance wait for the boot network task
+  bool networkBusy = bootNetworkActive();
   
   // Update display
   updateDisplay();
@@ -101,11 +86,19 @@ void loop() {
   // Update buzzer
   updateBuzzer();
   
-  // Handle Bluetooth commands
+  // Keep tomorrow's schedule ready for the alert path
+  serviceActiveSchedule();
+  
+  // Handle Bluetooth commands, then close the window once idle
   processBluetoothCommands();
+  serviceBluetoothWindow();
   
-  // Auto-reconnect WiFi if needed
-  if (!wifiConnected && savedSSID.length() > 0) {
+  // Commit settings changes once they settle
+  serviceSettings();
+  
+  // Report link drops, then auto-reconnect WiFi if needed
+  checkWiFiConnection();
+  if (!networkBusy && !isWiFiConnected() && savedSSID.length() > 0) {
     autoReconnectWiFi();
   }
   
@@ -119,37 +112,10 @@ void loop() {
   delay(100); // Prevent watchdog reset
 }
 
-void initializeSystem() {
-  // Initialize RTC
-  initializeRTC();
-  
-  // Initialize SD Card
-  initializeSDCard();
-  
-  // Initialize Bluetooth
-  if (SerialBT.begin(BLUETOOTH_NAME)) {
-    bluetoothConnected = true;
-    debugPrintln("Bluetooth initialized: " + String(BLUETOOTH_NAME));
-  } else {
-    debugPrintln("ERROR: Bluetooth initialization failed");
-  }
-  
-  // Initialize Preferences
-  preferences.begin("prayer_times", false);
-  
-  // Initialize display
-  initializeDisplay();
-  
-  // Initialize buzzer
-  initializeBuzzer();
-  
-  debugPrintln("System initialization complete");
-}
-
 void checkFirstBoot() {
-  isFirstBoot = preferences.getBool("first_boot", true);
+  isFirstBoot = !deviceSettings.firstBootDone;
   if (isFirstBoot) {
-    preferences.putBool("first_boot", false);
+    settingsSetFirstBootDone();
     debugPrintln("First boot detected");
   }
 }
@@ -170,55 +136,79 @@ void handleFirstBootSetup() {
   SerialBT.println(F("========================"));
 }
 
+// Each input line becomes an event, handled in dispatchSystemEvents()
 void processBluetoothCommands() {
+  // The upload tasks own the link until the binary session ends
+  if (bulkUploadActive()) {
+    noteBluetoothActivity();
+    return;
+  }
+  
   if (SerialBT.available()) {
     String input = SerialBT.readStringUntil('\n');
     input.trim();
     
     if (input.length() == 0) return;
     
-    debugPrintln("BT Command received: " + input);
+    noteBluetoothActivity();
+    if (input.length() > MAX_COMMAND_LENGTH) {
+      SerialBT.println("Input too long (max " + String(MAX_COMMAND_LENGTH) + " characters).");
+      return;
+    }
     
-    if (waitingForInput) {
-      if (inputPrompt == "network_selection") {
-        int networkIndex = input.toInt() - 1;
-        if (networkIndex >= 0 && networkIndex < wifiNetworkCount) {
-          String selectedSSID = wifiNetworks[networkIndex];
-          SerialBT.println("Selected: " + selectedSSID);
-          SerialBT.println("Enter password (or press enter if open network):");
-          waitingForInput = true;
-          inputPrompt = "wifi_password:" + selectedSSID;
-          commandTimeout = millis();
-        } else {
-          SerialBT.println("Invalid selection. Please try again.");
-          displayWiFiNetworks();
-          waitingForInput = true;
-          commandTimeout = millis();
-        }
-      } else if (inputPrompt.startsWith("wifi_password:")) {
-        String ssid = inputPrompt.substring(14);
-        String password = input;
-        SerialBT.println("Connecting to " + ssid + "...");
-        
-        if (connectToWiFi(ssid, password)) {
-          saveWiFiCredentials(ssid, password);
-          syncTimeWithNTP();
-          fetchPrayerTimes();
-        }
-        
-        waitingForInput = false;
-        inputPrompt = "";
-      } else if (inputPrompt == "city_name") {
-        currentCity = input;
-        preferences.putString("city", currentCity);
-        SerialBT.println("City changed to: " + currentCity);
+    SystemEvent event;
+    event.type = EVENT_COMMAND_RECEIVED;
+    memset(event.command, 0, sizeof(event.command));
+    input.toCharArray(event.command, sizeof(event.command));
+    postSystemEvent(event);
+  }
+}
+
+void handleBluetoothInput(const String& input) {
+  debugPrintln("BT Command received: " + input);
+  
+  if (waitingForInput) {
+    if (inputPrompt == "network_selection") {
+      int networkIndex = input.toInt() - 1;
+      if (networkIndex >= 0 && networkIndex < wifiNetworkCount) {
+        String selectedSSID = wifiNetworks[networkIndex];
+        SerialBT.println("Selected: " + selectedSSID);
+        SerialBT.println("Enter password (or press enter if open network):");
+        waitingForInput = true;
+        inputPrompt = "wifi_password:" + selectedSSID;
+        commandTimeout = millis();
+      } else {
+        SerialBT.println("Invalid selection. Please try again.");
+        displayWiFiNetworks();
+        waitingForInput = true;
+        commandTimeout = millis();
+      }
+    } else if (inputPrompt.startsWith("wifi_password:")) {
+      String ssid = inputPrompt.substring(14);
+      String password = input;
+      SerialBT.println("Connecting to " + ssid + "...");
+      
+      if (connectToWiFi(ssid, password)) {
+        saveWiFiCredentials(ssid, password);
+        syncTimeWithNTP();
         fetchPrayerTimes();
-        waitingForInput = false;
-        inputPrompt = "";
       }
-    } else {
-      handleBluetoothCommand(input);
+      
+      waitingForInput = false;
+      inputPrompt = "";
+    } else if (inputPrompt == "city_name") {
+      if (!settingsSetCity(input)) {
+        SerialBT.println("City name too long (max " + String(MAX_CITY_NAME_LENGTH) + " characters). Try again:");
+        commandTimeout = millis();
+        return;
+      }
+      // The dispatched settings event switches currentCity and fetches its times
+      SerialBT.println("City changed to: " + String(deviceSettings.city));
+      waitingForInput = false;
+      inputPrompt = "";
     }
+  } else {
+    handleBluetoothCommand(input);
   }
 }
 
@@ -242,12 +232,99 @@ void handleBluetoothCommand(const String& command) {
     return;
   }
   
+  // Plain PBM of the current frame, paste into a .pbm file to view
+  if (cmd == "screenshot") {
+    dumpDisplayScreenshot();
+    return;
+  }
+  
+  if (cmd == "adhan") {
+    if (!startAudioPlayback(ADHAN_AUDIO_PATH)) {
+      SerialBT.println(F("Could not play " ADHAN_AUDIO_PATH " (missing, unsupported or already playing)"));
+    }
+    return;
+  }
+  
+  // "audiobench [blocks]" times the ADPCM decoder
+  if (cmd.startsWith("audiobench")) {
+    int blocks = cmd.substring(10).toInt();
+    runAudioBenchmark(blocks > 0 ? blocks : AUDIO_BENCH_BLOCKS);
+    return;
+  }
+  
+  // Audio, buzzer and the menu 11/12 tests
+  if (cmd == "stop") {
+    stopAudioPlayback();
+    stopBuzzerTest();
+    stopDisplayTest();
+    return;
+  }
+  
+  // "pattern" lists buzzer patterns; see handlePatternCommand() for the forms
+  if (cmd == "pattern" || cmd.startsWith("pattern ")) {
+    handlePatternCommand(cmd.substring(7));
+    return;
+  }
+  
+  if (cmd == "next") {
+    showNextPrayer();
+    return;
+  }
+  
+  // "upload" switches the link to binary frames (tools/bt_upload.py)
+  if (cmd == "upload") {
+    if (bootNetworkActive()) {
+      SerialBT.println(F("Startup WiFi/NTP sync still running, try again in a moment."));
+    } else if (startBulkUpload()) {
+      SerialBT.println(F("UPLOAD READY"));
+    } else {
+      SerialBT.println(F("Upload could not start (out of memory)"));
+    }
+    return;
+  }
+  
+  if (cmd == "upload status") {
+    showBulkUploadStatus();
+    return;
+  }
+  
+  // "renderbench [draws]" times the glyph atlas paths
+  if (cmd.startsWith("renderbench")) {
+    int iterations = cmd.substring(11).toInt();
+    runRenderBenchmark(iterations > 0 ? iterations : RENDER_BENCH_ITERATIONS);
+    return;
+  }
+  
+#ifdef LOAD_TEST_ENABLED
+  // "loadtest [rounds]" against the mock API server
+  if (cmd.startsWith("loadtest")) {
+    int rounds = cmd.substring(8).toInt();
+    if (bootNetworkActive()) {
+      SerialBT.println(F("Startup WiFi/NTP sync still running, try again in a moment."));
+    } else {
+      runLoadTest(rounds > 0 ? rounds : LOAD_TEST_ROUNDS);
+    }
+    return;
+  }
+#endif
+  
   // Invalid command
   SerialBT.println(F("Invalid command. Please enter a number 1-14."));
   SerialBT.println(F("Type 'menu' for options or '14' for help"));
 }
 
+// Options that use WiFi or rewrite the caches
+static bool isNetworkSelection(int selection) {
+  return selection == 2 || selection == 3 || selection == 4 || selection == 5 ||
+         selection == 6 || selection == 7 || selection == 9 || selection == 10;
+}
+
 void handleMenuSelection(int selection) {
+  if (bootNetworkActive() && isNetworkSelection(selection)) {
+    SerialBT.println(F("Startup WiFi/NTP sync still running, try again in a moment."));
+    return;
+  }
+  
   switch (selection) {
     case 1:
       showStatus();
@@ -268,8 +345,7 @@ void handleMenuSelection(int selection) {
       break;
     case 4:
       if (savedSSID.length() > 0) {
-        connectToWiFi(savedSSID, savedPassword);
-        if (wifiConnected) {
+        if (connectToWiFi(savedSSID, savedPassword)) {
           syncTimeWithNTP();
           fetchPrayerTimes();
         }
@@ -279,14 +355,14 @@ void handleMenuSelection(int selection) {
       break;
     case 5:
       WiFi.disconnect();
-      wifiConnected = false;
+      noteWiFiLinkState(false);
       SerialBT.println(F("Disconnected from WiFi"));
       debugPrintln(F("WiFi manually disconnected"));
       break;
     case 6:
       WiFi.disconnect();
       clearWiFiCredentials();
-      wifiConnected = false;
+      noteWiFiLinkState(false);
       SerialBT.println(F("WiFi credentials forgotten"));
       break;
     case 7:
@@ -306,13 +382,11 @@ void handleMenuSelection(int selection) {
       syncTimeWithNTP();
       break;
     case 11:
-      SerialBT.println(F("Testing display system..."));
-      displaySystemStatus();
-      clearDisplay();
-      displayWelcomeMessage();
+      if (!startDisplayTest()) {
+        SerialBT.println(F("Alert on screen, try again when it ends"));
+      }
       break;
     case 12:
-      SerialBT.println(F("Testing buzzer system..."));
       testBuzzer();
       break;
     case 13:
@@ -357,8 +431,9 @@ void showStatus() {
   
   // WiFi Status
   SerialBT.print(F("WiFi Status: "));
-  SerialBT.println(wifiConnected ? F("Connected") : F("Disconnected"));
-  if (wifiConnected) {
+  bool connected = isWiFiConnected();
+  SerialBT.println(connected ? F("Connected") : F("Disconnected"));
+  if (connected) {
     SerialBT.print(F("SSID: "));
     SerialBT.println(WiFi.SSID());
     SerialBT.print(F("IP Address: "));
@@ -378,9 +453,7 @@ void showStatus() {
   }
   
   // Bluetooth Status
-  SerialBT.print(F("Bluetooth: Active ("));
-  SerialBT.print(BLUETOOTH_NAME);
-  SerialBT.println(F(")"));
+  showBluetoothStatus();
   
   // RTC Status
   SerialBT.print(F("RTC DS3231: "));
@@ -390,13 +463,22 @@ void showStatus() {
   SerialBT.print(F("SD Card: "));
   SerialBT.println(sdCardInitialized ? F("Mounted") : F("Not found"));
   
+  // Flash Cache Status
+  SerialBT.print(F("Flash Cache: "));
+  if (flashCacheInitialized) {
+    SerialBT.print(countFlashScheduleDays());
+    SerialBT.println(F(" days"));
+  } else {
+    SerialBT.println(F("Not mounted"));
+  }
+  
   // Current Settings
   SerialBT.print(F("City: "));
   SerialBT.println(currentCity);
   SerialBT.print(F("Timezone: "));
   SerialBT.print(currentTimezone);
-  SerialBT.print(F(" (GMT+"));
-  SerialBT.print(timezoneOffset);
+  SerialBT.print(F(" ("));
+  SerialBT.print(getTimezoneOffsetLabel());
   SerialBT.println(F(")"));
   
   // Current Time
@@ -405,10 +487,50 @@ void showStatus() {
     SerialBT.println(getCurrentTime());
   }
   
+  // Settings persistence
+  SerialBT.print(F("Settings NVS writes: "));
+  SerialBT.print(deviceSettings.writeCount);
+  SerialBT.print(F(" total, "));
+  SerialBT.print(settingsSessionWrites);
+  SerialBT.print(F(" this boot"));
+  SerialBT.println(settingsPending() ? F(" (pending)") : F(""));
+  
+  // Boot info
+  SerialBT.print(F("Boot: "));
+  SerialBT.print(warmBoot ? F("warm #") : F("cold"));
+  if (warmBoot) {
+    SerialBT.print(warmBootCount());
+  }
+  SerialBT.print(F(" ("));
+  SerialBT.print(resetReasonName());
+  SerialBT.print(F("), alert path ready "));
+  if (alertReadyMillis() >= 0) {
+    SerialBT.print(alertReadyMillis());
+    SerialBT.println(F(" ms after boot"));
+  } else {
+    SerialBT.println(F("pending (no schedule yet)"));
+  }
+  showBootTimeline();
+  showActiveScheduleStatus();
+  showNextPrayer();
+  
+  // Background cache fill
+  showPrefetcherStatus();
+  showEventQueueStatus();
+  
+  // Display flush traffic
+  showDisplayStats();
+  showAudioStatus();
+  
+  // API client
+  showApiClientStats();
+  
   // Memory info
   SerialBT.print(F("Free Heap: "));
   SerialBT.print(ESP.getFreeHeap());
-  SerialBT.println(F(" bytes"));
+  SerialBT.print(F(" bytes (largest block "));
+  SerialBT.print(ESP.getMaxAllocHeap());
+  SerialBT.println(F(")"));
   SerialBT.println(F("===============\n"));
 }
 
@@ -436,117 +558,26 @@ void showHelp() {
   SerialBT.println(F("12 - Reboot ESP32"));
   SerialBT.println(F("13 - Show this help"));
   SerialBT.println(F(""));
+  SerialBT.println(F("'next' - Time left until the next prayer"));
+  SerialBT.println(F("'adhan' / 'stop' - Play the adhan from SD / stop audio, buzzer and tests"));
+  SerialBT.println(F("'audiobench [n]' - Time the ADPCM decoder"));
+  SerialBT.println(F("'pattern' - List or choose buzzer patterns per prayer"));
+  SerialBT.println(F("'screenshot' - Dump the display as a PBM image"));
+  SerialBT.println(F("'renderbench [n]' - Time display glyph drawing"));
+  SerialBT.println(F("'upload' / 'upload status' - Receive schedules from tools/bt_upload.py / last result"));
+  SerialBT.println(F(""));
   SerialBT.println(F("TIP: After each command, you'll return to the main menu!"));
-  SerialBT.println(F("🌙 Midnight auto-caching: Prayer times are automatically"));
-  SerialBT.println(F("   cached every night at midnight for 8 days ahead!"));
+  SerialBT.println("Bluetooth switches off after " + String(BT_WINDOW_MINUTES) + " idle minutes;");
+  SerialBT.println(F("   hold the BOOT button for 1 second to turn it back on."));
+  SerialBT.println(F("🌙 Auto-caching: Prayer times for the next 30 days are"));
+  SerialBT.println(F("   fetched in the background whenever WiFi is good."));
   SerialBT.println(F("====================\n"));
 }
 
 void restartDevice() {
   SerialBT.println(F("Restarting device in 3 seconds..."));
   debugPrintln(F("Device restart requested"));
+  saveSettingsNow();
   delay(3000);
   ESP.restart();
 }
-
-void checkMidnightCaching() {
-  // Only check every 30 seconds to avoid excessive checking
-  if (millis() - lastMidnightCheck < 30000) {
-    return;
-  }
-  
-  lastMidnightCheck = millis();
-  
-  if (!rtcInitialized || !wifiConnected) {
-    return; // Need both RTC and WiFi for caching
-  }
-  
-  DateTime now = rtc.now();
-  int currentDay = now.day();
-  int currentHour = now.hour();
-  int currentMinute = now.minute();
-  
-  // Check if it's midnight (00:00 to 00:05) and we haven't cached today yet
-  if (currentHour == 0 && currentMinute < 5) {
-    if (currentDay != lastCacheDay || !midnightCacheComplete) {
-      debugPrintln(F("Midnight detected - starting prayer times cache"));
-      SerialBT.println(F("🌙 Midnight auto-cache starting..."));
-      performMidnightCache();
-      lastCacheDay = currentDay;
-      midnightCacheComplete = true;
-    }
-  } else if (currentHour > 0) {
-    // Reset the flag after midnight window
-    midnightCacheComplete = false;
-  }
-}
-
-void performMidnightCache() {
-  if (!wifiConnected || !rtcInitialized) {
-    debugPrintln(F("Cannot perform midnight cache - missing WiFi or RTC"));
-    return;
-  }
-  
-  debugPrintln(F("Starting midnight prayer times caching for 8 days (today + 7 ahead)"));
-  SerialBT.println(F("📦 Caching prayer times for 8 days..."));
-  
-  DateTime now = rtc.now();
-  int cachedCount = 0;
-  int skippedCount = 0;
-  
-  // Cache for today (day 0) plus next 7 days (days 1-7)
-  for (int i = 0; i <= 7; i++) {
-    DateTime targetDate = DateTime(now.unixtime() + (i * 86400L)); // Add i days
-    
-    // Format date as DD-MM-YYYY
-    char dateStr[12];
-    sprintf(dateStr, "%02d-%02d-%04d", targetDate.day(), targetDate.month(), targetDate.year());
-    
-    // Create file path with proper month/year handling
-    char filePath[100];
-    sprintf(filePath, "/%s/%04d/%02d/%s.json", 
-            currentCity.c_str(), targetDate.year(), targetDate.month(), dateStr);
-    
-    // Check if file already exists
-    if (fileExists(String(filePath))) {
-      debugPrintln("Skipping " + String(dateStr) + " - already cached");
-      skippedCount++;
-      continue;
-    }
-    
-    // Fetch prayer times for this date
-    String url = String(ALADHAN_API_BASE) + "/" + String(dateStr) + 
-                "?city=" + currentCity + 
-                "&country=" + String(DEFAULT_COUNTRY) + 
-                "&method=" + String(PRAYER_METHOD);
-    
-    debugPrintln("Midnight caching: " + String(dateStr));
-    
-    http.begin(url);
-    http.setTimeout(HTTP_TIMEOUT);
-    int httpCode = http.GET();
-    
-    if (httpCode == HTTP_CODE_OK) {
-      String payload = http.getString();
-      
-      // Create directory structure if it doesn't exist
-      String dirPath = "/" + currentCity + "/" + String(targetDate.year()) + "/" + String(targetDate.month());
-      createDir(dirPath);
-      
-      // Save to SD card
-      savePrayerTimesToSD(payload, String(dateStr));
-      cachedCount++;
-      debugPrintln("Cached prayer times for " + String(dateStr));
-    } else {
-      debugPrintln("Failed to cache " + String(dateStr) + " - HTTP " + String(httpCode));
-    }
-    
-    http.end();
-    delay(1000); // Rate limiting between API calls
-  }
-  
-  // Report results
-  String resultMsg = "🌙 Midnight cache complete: " + String(cachedCount) + " new, " + String(skippedCount) + " skipped";
-  SerialBT.println(resultMsg);
-  debugPrintln("Midnight caching completed: " + String(cachedCount) + " days cached, " + String(skippedCount) + " days skipped");
-}
\ No newline at end of file
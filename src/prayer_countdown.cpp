@@ -0,0 +1,100 @@
+/*
+ * Prayer Countdown Implementation
+ * Tracks the next alerting prayer and the seconds left until it. A tick
+ * only subtracts the seconds since the previous tick; the active schedule
+ * is read again only when the countdown crosses a prayer, the schedule is
+ * republished, or the clock jumps (NTP sync, RTC set, missed ticks).
+ */
+
+#include "global.h"
+
+static NextPrayer nextPrayer = {};
+static bool countdownValid = false;
+static uint32_t lastTickTime = 0;         // RTC seconds at the previous tick
+static uint32_t trackedGeneration = 0;
+
+static uint32_t countdownTicks = 0;
+static uint32_t countdownResyncs = 0;
+
+// First alerting prayer after secondOfDay, or -1 if Isha has passed
+static int findPrayerAfter(const DaySchedule& schedule, int32_t secondOfDay) {
+  for (int i = 0; i < PRAYER_COUNT; i++) {
+    if (i != PRAYER_SUNRISE && (int32_t)schedule.minutes[i] * 60 > secondOfDay) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Locates the next prayer from the published today/tomorrow pair
+static bool resyncCountdown(const DateTime& now) {
+  countdownResyncs++;
+  int32_t today = daysFromCivil(civilDateFrom(now));
+  int32_t secondOfDay = now.hour() * 3600L + now.minute() * 60L + now.second();
+  DaySchedule schedule;
+
+  if (readActiveSchedule(today, schedule)) {
+    int prayer = findPrayerAfter(schedule, secondOfDay);
+    if (prayer >= 0) {
+      nextPrayer.prayer = prayer;
+      nextPrayer.dayNumber = today;
+      nextPrayer.minutes = schedule.minutes[prayer];
+      nextPrayer.secondsLeft = schedule.minutes[prayer] * 60L - secondOfDay;
+      return true;
+    }
+  }
+  if (readActiveSchedule(today + 1, schedule)) {
+    nextPrayer.prayer = PRAYER_FAJR;
+    nextPrayer.dayNumber = today + 1;
+    nextPrayer.minutes = schedule.minutes[PRAYER_FAJR];
+    nextPrayer.secondsLeft = 86400L - secondOfDay + schedule.minutes[PRAYER_FAJR] * 60L;
+    return true;
+  }
+  return false;
+}
+
+// Called once per display tick; cheap unless a boundary was crossed
+void updatePrayerCountdown(const DateTime& now) {
+  uint32_t time = now.unixtime();
+  uint32_t generation = activeScheduleGeneration();
+  uint32_t step = time - lastTickTime;
+  lastTickTime = time;
+  countdownTicks++;
+
+  if (countdownValid && generation == trackedGeneration && step <= COUNTDOWN_MAX_STEP) {
+    nextPrayer.secondsLeft -= step;
+    if (nextPrayer.secondsLeft > 0) {
+      return;
+    }
+  }
+
+  // Boundary crossed, schedule swapped or clock jumped
+  trackedGeneration = generation;
+  countdownValid = resyncCountdown(now);
+}
+
+bool getNextPrayer(NextPrayer& next) {
+  if (!countdownValid) {
+    return false;
+  }
+  next = nextPrayer;
+  return true;
+}
+
+void showNextPrayer() {
+  NextPrayer next;
+  if (!getNextPrayer(next)) {
+    SerialBT.println(F("Next prayer: unknown (no schedule for today or tomorrow)"));
+    return;
+  }
+  SerialBT.printf("Next prayer: %s at %02d:%02d%s, in %02ld:%02ld:%02ld\n",
+                  schedulePrayerName(next.prayer), next.minutes / 60, next.minutes % 60,
+                  next.dayNumber != daysFromCivil(getToday()) ? " tomorrow" : "",
+                  (long)(next.secondsLeft / 3600), (long)(next.secondsLeft / 60 % 60),
+                  (long)(next.secondsLeft % 60));
+  SerialBT.print(F("Countdown: "));
+  SerialBT.print(countdownTicks);
+  SerialBT.print(F(" ticks, "));
+  SerialBT.print(countdownResyncs);
+  SerialBT.println(F(" schedule lookups"));
+}
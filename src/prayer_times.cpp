@@ -8,6 +8,9 @@
 String lastPrayerData = "";
 
 void fetchPrayerTimes() {
+  // Waits for a prefetch batch in flight; keeps the city fixed until saved
+  ApiLock fetchLock;
+  
   // First try to load from SD card
   if (loadPrayerTimesFromSD()) {
     SerialBT.println("✅ Prayer times loaded from SD card");
@@ -15,7 +18,25 @@ void fetchPrayerTimes() {
     return;
   }
   
-  if (!wifiConnected) {
+  CivilDate today = getToday();
+  if (!isValidDate(today)) {
+    SerialBT.println("❌ Current date unknown. Set the time first.");
+    debugPrintln("Prayer times fetch skipped - no valid date");
+    return;
+  }
+  
+  // Without an SD card the flash tier still holds the coming weeks
+  if (!sdCardInitialized) {
+    DaySchedule schedule;
+    if (getDaySchedule(today, schedule)) {
+      displayPrayerTimes(schedule);
+      SerialBT.println("✅ Prayer times loaded from flash cache");
+      debugPrintln("Prayer times loaded from flash cache (current date)");
+      return;
+    }
+  }
+  
+  if (!isWiFiConnected()) {
     SerialBT.println("❌ WiFi not connected and no cached data available.");
     debugPrintln("Prayer times fetch failed - no WiFi and no cache");
     return;
@@ -27,32 +48,27 @@ void fetchPrayerTimes() {
   SerialBT.println("Fetching prayer times for " + currentCity + "...");
   debugPrintln("Fetching prayer times for " + currentCity);
   
-  // Get current date for API call
-  String currentDate = getCurrentDateString();
-  
-  String url = String(ALADHAN_API_BASE) + "/" + currentDate + "?city=" + currentCity + 
-               "&country=" + String(DEFAULT_COUNTRY) + "&method=" + String(PRAYER_METHOD);
-  
+  // Request path for today's date (host and connection are kept by the API client)
+  String url = prayerTimesPath(today);
   debugPrintln("API URL: " + url);
   
-  http.begin(url);
-  http.setTimeout(HTTP_TIMEOUT);
-  
-  int httpCode = http.GET();
+  String payload;
+  int httpCode = apiGet(url, payload);
   
   if (httpCode == HTTP_CODE_OK) {
-    String payload = http.getString();
     displayPrayerTimes(payload, true); // true = from API
     lastPrayerData = payload;
     
-    // Save to SD card with current date
-    savePrayerTimesToSD(payload, currentDate);
+    // Save to SD card and flash tier with current date
+    savePrayerTimesToSD(payload, today);
+    storeFlashScheduleFromJson(payload, today);
+    flushCacheManifests();
     
     SerialBT.println("✅ Prayer times updated successfully!");
     debugPrintln("Prayer times fetch completed successfully");
     
     // If connected to internet during boot, cache 7 days ahead
-    if (isFirstBoot && wifiConnected) {
+    if (isFirstBoot && isWiFiConnected()) {
       fetchPrayerTimesForDays(PRAYER_CACHE_DAYS);
     }
   } else {
@@ -65,12 +81,10 @@ void fetchPrayerTimes() {
       SerialBT.println("Using cached prayer times from SD card");
     }
   }
-  
-  http.end();
 }
 
 void fetchPrayerTimesForDays(int days) {
-  if (!wifiConnected) {
+  if (!isWiFiConnected()) {
     debugPrintln("Cannot cache future days - no WiFi connection");
     return;
   }
@@ -78,53 +92,64 @@ void fetchPrayerTimesForDays(int days) {
   debugPrintln("Caching prayer times for next " + String(days) + " days...");
   SerialBT.println("💾 Caching prayer times for " + String(days) + " days...");
   
-  DateTime now = rtc.now();
-  int cachedCount = 0;
+  CivilDate today = getToday();
+  if (!isValidDate(today)) {
+    return;
+  }
+  CivilDate missing[PRAYER_CACHE_DAYS];
+  int missingCount = 0;
   
-  for (int i = 1; i <= days; i++) {
-    DateTime futureDate = DateTime(now.unixtime() + (i * 86400L)); // Add i days
-    String dateStr = String(futureDate.day()) + "-" + 
-                     String(futureDate.month()) + "-" + 
-                     String(futureDate.year());
+  for (int i = 1; i <= days && missingCount < PRAYER_CACHE_DAYS; i++) {
+    CivilDate futureDate = addDays(today, i);
     
-    // Check if already cached
-    String filePath = "/" + currentCity + "/" + String(futureDate.year()) + "/" + 
-                     String(futureDate.month()) + "/" + dateStr + ".json";
-    
-    if (fileExists(filePath)) {
-      debugPrintln("Skipping " + dateStr + " - already cached");
+    // Check if already cached (manifest or flash lookup, no SD access)
+    if (isScheduleCached(futureDate)) {
+      debugPrintln("Skipping " + dateKeyString(futureDate) + " - already cached");
       continue;
     }
-    
-    // Fetch prayer times for this date
-    String url = String(ALADHAN_API_BASE) + "/" + dateStr + 
-                "?city=" + currentCity + 
-                "&country=" + String(DEFAULT_COUNTRY) + 
-                "&method=" + String(PRAYER_METHOD);
-    
-    debugPrintln("Caching: " + url);
-    
-    http.begin(url);
-    http.setTimeout(HTTP_TIMEOUT);
-    int httpCode = http.GET();
-    
-    if (httpCode == HTTP_CODE_OK) {
-      String payload = http.getString();
-      savePrayerTimesToSD(payload, dateStr);
-      cachedCount++;
-      debugPrintln("Cached prayer times for " + dateStr);
-    } else {
-      debugPrintln("Failed to cache " + dateStr + " - HTTP " + String(httpCode));
-    }
-    
-    http.end();
-    delay(1000); // Rate limiting
+    missing[missingCount++] = futureDate;
   }
   
+  // One pipelined batch on the keep-alive connection
+  int cachedCount = fetchAndCacheDays(missing, missingCount);
+  flushCacheManifests();
+  
   SerialBT.println("💾 Cached " + String(cachedCount) + " days of prayer times");
   debugPrintln("Prayer times caching completed: " + String(cachedCount) + " days cached");
 }
 
+static void cacheFetchedDay(int index, int status, const String& payload, void* context) {
+  const CivilDate& date = static_cast<const CivilDate*>(context)[index];
+  if (status == HTTP_CODE_OK) {
+    savePrayerTimesToSD(payload, date);
+    storeFlashScheduleFromJson(payload, date);
+    debugPrintln("Cached prayer times for " + dateKeyString(date));
+  } else {
+    debugPrintln("Failed to cache " + dateKeyString(date) + " - HTTP " + String(status));
+  }
+}
+
+// Fetches several days as one pipelined batch and stores them in the SD and
+// flash caches; returns how many were cached
+int fetchAndCacheDays(const CivilDate* dates, int count) {
+  ApiLock fetchLock;
+  int cached = 0;
+  for (int start = 0; start < count; start += API_BATCH_SIZE) {
+    int batch = min(count - start, API_BATCH_SIZE);
+    String paths[API_BATCH_SIZE];
+    for (int i = 0; i < batch; i++) {
+      paths[i] = prayerTimesPath(dates[start + i]);
+    }
+    debugPrintln("Caching " + String(batch) + " days from " + String(ALADHAN_API_HOST));
+    cached += apiGetPipelined(paths, batch, cacheFetchedDay, const_cast<CivilDate*>(dates + start));
+  }
+  return cached;
+}
+
+bool fetchAndCachePrayerTimes(const CivilDate& date) {
+  return fetchAndCacheDays(&date, 1) == 1;
+}
+
 void displayPrayerTimes(const String& jsonResponse, bool fromAPI) {
   JsonDocument doc;
   DeserializationError error = deserializeJson(doc, jsonResponse);
@@ -142,59 +167,81 @@ void displayPrayerTimes(const String& jsonResponse, bool fromAPI) {
   
   String readable = date["readable"];
   
-  // Update timezone from API response
+  // Update timezone from API response (re-syncs NTP only if it changed)
   if (meta["timezone"].is<const char*>()) {
     String apiTimezone = meta["timezone"];
-    String oldTimezone = currentTimezone;
     updateTimezoneFromAPI(apiTimezone);
-    
-    // Only sync NTP if timezone changed
-    if (oldTimezone != currentTimezone) {
-      debugPrintln("Timezone changed from " + oldTimezone + " to " + currentTimezone + ", syncing NTP...");
-      syncTimeWithNTP(true);
-    } else {
-      debugPrintln("Timezone unchanged (" + currentTimezone + "), skipping NTP sync");
-    }
   }
   
-  String tzAbbr = getTimezoneAbbreviation(timezoneOffset);
+  String tzAbbr = getTimezoneAbbreviation();
   
   SerialBT.println("\n=== Prayer Times for " + currentCity + " ===");
   SerialBT.println("Date: " + readable);
-  SerialBT.println("Timezone: " + tzAbbr + " (GMT+" + String(timezoneOffset) + ")");
+  SerialBT.println("Timezone: " + tzAbbr + " (" + getTimezoneOffsetLabel() + ")");
   SerialBT.println("Fajr    : " + String((const char*)timings["Fajr"]) + " " + tzAbbr);
   SerialBT.println("Dhuhr   : " + String((const char*)timings["Dhuhr"]) + " " + tzAbbr);
   SerialBT.println("Asr     : " + String((const char*)timings["Asr"]) + " " + tzAbbr);
   SerialBT.println("Maghrib : " + String((const char*)timings["Maghrib"]) + " " + tzAbbr);
   SerialBT.println("Isha    : " + String((const char*)timings["Isha"]) + " " + tzAbbr);
+  SerialBT.println(fromAPI ? "Source: Aladhan API" : "Source: SD card cache");
   SerialBT.println("================================\n");
+}
+
+// Prints a compact schedule from the flash tier (no SD card fitted)
+void displayPrayerTimes(const DaySchedule& schedule) {
+  String tzAbbr = getTimezoneAbbreviation();
   
-  // Save prayer times to SD card only if data came from API
-  if (fromAPI && sdCardInitialized) {
-    String currentDate = getCurrentDateString();
-    savePrayerTimesToSD(jsonResponse, currentDate);
+  SerialBT.println("\n=== Prayer Times for " + currentCity + " ===");
+  SerialBT.println("Timezone: " + tzAbbr + " (" + getTimezoneOffsetLabel() + ")");
+  for (int i = 0; i < PRAYER_COUNT; i++) {
+    if (i == PRAYER_SUNRISE) continue;
+    char line[32];
+    sprintf(line, "%-8s: %02d:%02d ", schedulePrayerName(i),
+            schedule.minutes[i] / 60, schedule.minutes[i] % 60);
+    SerialBT.println(String(line) + tzAbbr);
   }
+  SerialBT.println("================================\n");
 }
 
-bool loadPrayerTimesFromSD(const String& date) {
-  if (!sdCardInitialized) {
-    debugPrintln("SD card not initialized for prayer times loading");
+// Converts an API or cached JSON day into a compact schedule record
+bool parseDaySchedule(const String& jsonData, const CivilDate& date, DaySchedule& schedule) {
+  JsonDocument doc;
+  if (deserializeJson(doc, jsonData)) {
     return false;
   }
   
-  String filePath = "/" + currentCity + "/" + date.substring(6, 10) + "/" + 
-                   date.substring(3, 5) + "/" + date + ".json";
+  JsonObject timings = doc["data"]["timings"];
+  if (timings.isNull()) {
+    return false;
+  }
   
-  debugPrintln("Trying to load prayer times from: " + filePath);
+  static const char* const keys[PRAYER_COUNT] = {"Fajr", "Sunrise", "Dhuhr", "Asr", "Maghrib", "Isha"};
+  memset(&schedule, 0, sizeof(schedule));
+  for (int i = 0; i < PRAYER_COUNT; i++) {
+    // Values look like "04:12" or "04:12 (WIB)"
+    const char* value = timings[keys[i]] | "";
+    if (strlen(value) < 5 || value[2] != ':') {
+      return false;
+    }
+    schedule.minutes[i] = atoi(value) * 60 + atoi(value + 3);
+  }
   
-  if (!fileExists(filePath)) {
-    debugPrintln("Prayer times file not found: " + filePath);
+  schedule.dayNumber = daysFromCivil(date);
+  schedule.utcOffsetMinutes = utcOffsetMinutesOn(date);
+  schedule.crc = dayScheduleCrc(schedule);
+  return true;
+}
+
+bool loadPrayerTimesFromSD(const CivilDate& date) {
+  if (!sdCardInitialized) {
+    debugPrintln("SD card not initialized for prayer times loading");
     return false;
   }
   
-  String jsonData = readFile(filePath);
-  if (jsonData.length() == 0) {
-    debugPrintln("Empty or corrupted prayer times file: " + filePath);
+  // Verified against trailer and manifest; a corrupt day is dropped and refetched
+  String jsonData;
+  if (!readCachedDay(date, jsonData)) {
+    debugPrintln("Prayer times not cached for " + dateKeyString(date));
     return false;
   }
   
@@ -209,61 +256,35 @@ bool loadPrayerTimesFromSD() {
     return false;
   }
   
-  // Get current date string
-  String currentDate = getCurrentDateString();
-  return loadPrayerTimesFromSD(currentDate);
+  CivilDate today = getToday();
+  if (!isValidDate(today)) {
+    return false;
+  }
+  return loadPrayerTimesFromSD(today);
 }
 
+// Applied by loop(), which owns the timezone state (see system_events.cpp)
 void updateTimezoneFromAPI(const String& apiTimezone) {
-  String oldTimezone = currentTimezone; // Store old timezone
-  currentTimezone = apiTimezone;
-  
-  // Map API timezone to GMT offset
-  if (apiTimezone == "Asia/Jakarta") {
-    timezoneOffset = 7;
-  } else if (apiTimezone == "Asia/Makassar") {
-    timezoneOffset = 8;
-  } else if (apiTimezone == "Asia/Jayapura") {
-    timezoneOffset = 9;
-  } else {
-    // Default to WIB if unknown timezone
-    timezoneOffset = 7;
-    debugPrintln("Unknown timezone from API, defaulting to GMT+7");
-  }
-  
-  debugPrintln("Timezone updated to: " + currentTimezone + " (GMT+" + String(timezoneOffset) + ")");
-  
-  // Save timezone to preferences
-  preferences.putString("timezone", currentTimezone);
-  preferences.putInt("tz_offset", timezoneOffset);
-  
-  // Re-sync time with new timezone
-  // Sync NTP only if timezone changed
-  if (oldTimezone != currentTimezone) {
-    debugPrintln("Timezone changed, syncing NTP...");
-    syncTimeWithNTP(true);
-  }
+  SystemEvent event;
+  event.type = EVENT_TIMEZONE_REPORTED;
+  memset(event.timezone, 0, sizeof(event.timezone));
+  apiTimezone.toCharArray(event.timezone, sizeof(event.timezone));
+  postSystemEvent(event);
 }
 
-String getTimezoneAbbreviation(int offset) {
-  switch(offset) {
-    case 7: return "WIB";
-    case 8: return "WITA";
-    case 9: return "WIT";
-    default: return "WIB";
-  }
+String getTimezoneAbbreviation() {
+  return isDaylightTimeNow() ? activeTimezone.dstAbbreviation : activeTimezone.abbreviation;
 }
 
-String getPrayerTimesFromCache(const String& dateKey) {
-  // Convert date key from dd-mm-yyyy format to dd-mm format if needed
-  String searchKey = dateKey;
-  if (dateKey.length() > 5) {
-    // Extract dd-mm from dd-mm-yyyy
-    searchKey = dateKey.substring(0, 5);
+String getTimezoneOffsetLabel() {
+  return isDaylightTimeNow() ? activeTimezone.dstOffsetLabel : activeTimezone.offsetLabel;
+}
+
+String getPrayerTimesFromCache(const CivilDate& date) {
+  // Same path formatter as the writer, so the keys always agree
+  char filePath[CACHE_PATH_LENGTH];
+  if (formatCachePath(filePath, sizeof(filePath), currentCity.c_str(), date) == 0) {
+    return "";
   }
-  
-  // Load prayer times from SD card using the correct function
-  String filename = searchKey + ".json";
-  String prayerData = loadPrayerDataFromSD(filename);
-  return prayerData;
+  return loadPrayerDataFromSD(filePath);
 }
@@ -11,6 +11,12 @@ void initializeSDCard() {
     sdCardInitialized = true;
     debugPrintln("SD Card initialized successfully");
     
+    // Load this year's cache manifest so coverage checks stay in RAM
+    CivilDate today = getToday();
+    if (isValidDate(today)) {
+      loadCacheManifest(currentCity, today.year);
+    }
+    
     // Check card type
     uint8_t cardType = SD.cardType();
     if (cardType != CARD_NONE) {
@@ -25,108 +31,23 @@ void initializeSDCard() {
   }
 }
 
-String createSDCardPath(const String& city, const String& date) {
-  // Extract year, month, day from date (format: DD-MM-YYYY)
-  int firstDash = date.indexOf('-');
-  int secondDash = date.lastIndexOf('-');
-  
-  String day = date.substring(0, firstDash);
-  String month = date.substring(firstDash + 1, secondDash);
-  String year = date.substring(secondDash + 1);
-  
-  String path = "/" + city + "/" + year + "/" + month;
-  return path;
-}
-
-void savePrayerTimesToSD(const String& jsonResponse) {
-  if (!sdCardInitialized) {
-    debugPrintln("SD Card not available for saving");
-    return;
-  }
-  
-  // Parse date from JSON to create proper path
-  JsonDocument tempDoc;
-  deserializeJson(tempDoc, jsonResponse);
-  JsonObject data = tempDoc["data"];
-  JsonObject date = data["date"];
-  JsonObject gregorian = date["gregorian"];
-  
-  String dateStr = gregorian["date"]; // Format: DD-MM-YYYY
-  String path = createSDCardPath(currentCity, dateStr);
-  
-  debugPrintln("Creating SD card path: " + path);
-  
-  // Create directory structure
-  if (!SD.exists(path)) {
-    String currentPath = "";
-    int start = 1; // Skip the leading slash
-    int slashIndex;
-    
-    while ((slashIndex = path.indexOf('/', start)) != -1) {
-      currentPath += "/" + path.substring(start, slashIndex);
-      if (!SD.exists(currentPath)) {
-        if (!SD.mkdir(currentPath)) {
-          debugPrintln("Failed to create directory: " + currentPath);
-          return;
-        }
-        debugPrintln("Created directory: " + currentPath);
-      }
-      start = slashIndex + 1;
-    }
-    
-    currentPath = path;
-    if (!SD.exists(currentPath)) {
-      if (!SD.mkdir(currentPath)) {
-        debugPrintln("Failed to create final directory: " + currentPath);
-        return;
-      }
-      debugPrintln("Created directory: " + currentPath);
-    }
-  }
-  
-  // Create filename with date
-  String day = dateStr.substring(0, dateStr.indexOf('-'));
-  String filename = path + "/" + day + ".json";
-  
-  debugPrintln("Saving prayer times to: " + filename);
-  
-  // Write JSON file
-  File file = SD.open(filename, FILE_WRITE);
-  if (file) {
-    file.print(jsonResponse);
-    file.close();
-    debugPrintln("Prayer times saved successfully to SD card");
-    SerialBT.println("Prayer times saved to SD card: " + filename);
-  } else {
-    debugPrintln("Failed to write to SD card file: " + filename);
-    SerialBT.println("Failed to save prayer times to SD card");
-  }
-}
-
 String loadPrayerDataFromSD(const String& filename) {
   if (!sdCardInitialized) {
     return "";
   }
   
-  if (!SD.exists(filename)) {
-    debugPrintln("Prayer data file not found: " + filename);
+  String data;
+  if (!readVerifiedFile(filename, data)) {
+    debugPrintln("Prayer data file not found or corrupt: " + filename);
     return "";
   }
   
-  File file = SD.open(filename, FILE_READ);
-  if (!file) {
-    debugPrintln("Failed to open prayer data file: " + filename);
-    return "";
-  }
-  
-  String data = file.readString();
-  file.close();
-  
   debugPrintln("Loaded prayer data from SD card: " + filename);
   return data;
 }
 
-void savePrayerTimesToSD(const String& jsonData, const String& date) {
+void savePrayerTimesToSD(const String& jsonData, const CivilDate& date) {
+  StorageLock lock;
   if (!sdCardInitialized) {
     debugPrintln("SD card not initialized, cannot save prayer times");
     return;
@@ -173,50 +94,81 @@ void savePrayerTimesToSD(const String& jsonData, const String& date) {
   String filteredJsonString;
   serializeJson(filteredDoc, filteredJsonString);
   
-  // Create directory structure: /city/year/month/
-  String year = date.substring(6, 10);
-  String month = date.substring(3, 5);
-  
-  String baseDir = "/" + currentCity;
-  String yearDir = baseDir + "/" + year;
-  String monthDir = yearDir + "/" + month;
+  if (saveCacheDayToSD(currentCity, date, filteredJsonString)) {
+    debugPrintln("Filtered prayer times saved to SD for " + dateKeyString(date));
+    debugPrintln("Saved fields: timings, date.readable, date.timestamp, meta.timezone");
+  }
+}
+
+// Writes one day file as /city/yyyy/mm/dd-mm-yyyy.json and records it in the manifest
+bool saveCacheDayToSD(const String& city, const CivilDate& date, const String& body) {
+  StorageLock lock;
+  if (!sdCardInitialized) {
+    return false;
+  }
   
-  createDir(baseDir);
-  createDir(yearDir);
-  createDir(monthDir);
+  // Manifest remembers which directories exist, so no SD.exists walk here
+  ensureCacheMonthDir(city, date.year, date.month);
   
-  // Save filtered file as /city/year/month/dd-mm-yyyy.json
-  String filePath = monthDir + "/" + date + ".json";
+  char filePath[CACHE_PATH_LENGTH];
+  if (formatCachePath(filePath, sizeof(filePath), city.c_str(), date) == 0) {
+    return false;
+  }
   
-  if (writeFile(filePath, filteredJsonString)) {
-    debugPrintln("Filtered prayer times saved to SD: " + filePath);
-    debugPrintln("Saved fields: timings, date.readable, date.timestamp, meta.timezone");
-  } else {
-    debugPrintln("Failed to save filtered prayer times to SD: " + filePath);
+  if (!writeFile(filePath, body)) {
+    debugPrintln("Failed to save prayer times to SD: " + String(filePath));
+    return false;
   }
+  uint32_t checksum = cacheCrc32(reinterpret_cast<const uint8_t*>(body.c_str()), body.length());
+  markDayCached(city, date, checksum);
+  return true;
 }
 
 // Utility functions for file operations
+// Replaces path with tempPath. FAT rename does not overwrite, so the old copy
+// is removed first; a temp file left behind by a power cut is recovered on read.
+bool commitFile(const String& tempPath, const String& path) {
+  SD.remove(path.c_str());
+  if (!SD.rename(tempPath.c_str(), path.c_str())) {
+    debugPrintln("Failed to commit file: " + path);
+    return false;
+  }
+  return true;
+}
+
 bool writeFile(const String& path, const String& message) {
   if (!sdCardInitialized) {
     return false;
   }
 
-  File file = SD.open(path.c_str(), FILE_WRITE);
+  // Write body and CRC trailer to a temp file, then rename into place
+  String tempPath = path + CACHE_TEMP_SUFFIX;
+  File file = SD.open(tempPath.c_str(), FILE_WRITE);
   if (!file) {
-    debugPrintln("Failed to open file for writing: " + path);
+    debugPrintln("Failed to open file for writing: " + tempPath);
     return false;
   }
 
-  if (file.print(message)) {
-    debugPrintln("File written: " + path);
-    file.close();
-    return true;
-  } else {
+  char trailer[CACHE_TRAILER_LENGTH + 1];
+  uint32_t crc = cacheCrc32(reinterpret_cast<const uint8_t*>(message.c_str()), message.length());
+  formatCacheTrailer(trailer, message.length(), crc);
+
+  size_t written = file.print(message);
+  written += file.print(trailer);
+  file.close();
+
+  if (written != message.length() + CACHE_TRAILER_LENGTH) {
     debugPrintln("Write failed: " + path);
-    file.close();
+    SD.remove(tempPath.c_str());
+    return false;
+  }
+
+  if (!commitFile(tempPath, path)) {
     return false;
   }
+
+  debugPrintln("File written: " + path);
+  return true;
 }
 
 String readFile(const String& path) {
@@ -235,6 +187,106 @@ String readFile(const String& path) {
   return result;
 }
 
+// Checks the CRC trailer written by writeFile() and strips it from the body
+static bool verifyFileContent(const String& content, String& body) {
+  if (content.length() >= CACHE_TRAILER_LENGTH) {
+    uint32_t length = 0;
+    uint32_t crc = 0;
+    const char* trailer = content.c_str() + content.length() - CACHE_TRAILER_LENGTH;
+    if (parseCacheTrailer(trailer, length, crc)) {
+      if (length != content.length() - CACHE_TRAILER_LENGTH ||
+          cacheCrc32(reinterpret_cast<const uint8_t*>(content.c_str()), length) != crc) {
+        return false;
+      }
+      body = content.substring(0, length);
+      return true;
+    }
+  }
+
+  // Files written before trailers existed: accept only if the JSON is closed
+  int end = content.length() - 1;
+  while (end >= 0 && isspace((unsigned char)content[end])) {
+    end--;
+  }
+  if (end < 0 || content[end] != '}') {
+    return false;
+  }
+  body = content;
+  return true;
+}
+
+bool readVerifiedFile(const String& path, String& body) {
+  StorageLock lock;
+  body = "";
+  if (!sdCardInitialized) {
+    return false;
+  }
+
+  File file = SD.open(path.c_str(), FILE_READ);
+  if (file) {
+    String content = file.readString();
+    file.close();
+    if (verifyFileContent(content, body)) {
+      return true;
+    }
+    debugPrintln("Cache file failed verification: " + path);
+    return false;
+  }
+
+  // Power cut between remove and rename leaves only the temp copy
+  String tempPath = path + CACHE_TEMP_SUFFIX;
+  File tempFile = SD.open(tempPath.c_str(), FILE_READ);
+  if (!tempFile) {
+    return false;
+  }
+  String content = tempFile.readString();
+  tempFile.close();
+  if (!verifyFileContent(content, body)) {
+    SD.remove(tempPath.c_str());
+    return false;
+  }
+
+  debugPrintln("Recovered interrupted write: " + path);
+  commitFile(tempPath, path);
+  return true;
+}
+
+// Drops a day that failed verification; the prefetcher refetches it like
+// any other missing day
+void discardCachedDay(const CivilDate& date) {
+  StorageLock lock;
+  clearDayCached(currentCity, date);
+  flushCacheManifests();
+  wakeCachePrefetcher();
+}
+
+// The current city's cached body for a date, for every reader. Trailer CRC
+// catches truncated writes, manifest CRC catches stale files; a day failing
+// either is discarded.
+bool readCachedDay(const CivilDate& date, String& body) {
+  StorageLock lock;
+  body = "";
+  if (!sdCardInitialized || !isDayCached(currentCity, date)) {
+    return false;
+  }
+
+  char filePath[CACHE_PATH_LENGTH];
+  if (formatCachePath(filePath, sizeof(filePath), currentCity.c_str(), date) == 0) {
+    return false;
+  }
+  bool valid = readVerifiedFile(filePath, body);
+  uint32_t expected = getCachedDayChecksum(currentCity, date);
+  if (valid && expected != 0) {
+    valid = cacheCrc32(reinterpret_cast<const uint8_t*>(body.c_str()), body.length()) == expected;
+  }
+  if (!valid) {
+    debugPrintln("Empty or corrupted prayer times file: " + String(filePath));
+    discardCachedDay(date);
+    body = "";
+  }
+  return valid;
+}
+
 bool fileExists(const String& path) {
   if (!sdCardInitialized) {
     return false;
@@ -0,0 +1,222 @@
+/*
+ * Settings Manager Implementation
+ * Typed settings loaded once at boot and persisted to NVS as a single
+ * versioned blob, debounced and written only when something changed.
+ */
+
+#include "global.h"
+#include "buzzer_patterns.h"
+
+DeviceSettings deviceSettings;
+uint32_t settingsSessionWrites = 0;
+
+static uint8_t settingsDirtyMask = 0;
+static unsigned long settingsLastChange = 0;
+
+static uint32_t settingsCrc(const DeviceSettings& s) {
+  return cacheCrc32(reinterpret_cast<const uint8_t*>(&s), offsetof(DeviceSettings, crc));
+}
+
+static void applyDefaultSettings(DeviceSettings& s) {
+  memset(&s, 0, sizeof(s));
+  s.version = SETTINGS_VERSION;
+  s.size = sizeof(DeviceSettings);
+  strncpy(s.city, DEFAULT_CITY, sizeof(s.city) - 1);
+  strncpy(s.timezone, DEFAULT_TIMEZONE, sizeof(s.timezone) - 1);
+  s.timezoneOffset = DEFAULT_TIMEZONE_OFFSET;
+  for (int i = 0; i < PRAYER_COUNT; i++) {
+    s.alertPatterns[i] = BUZZER_PATTERN_PULSE;
+    s.warningPatterns[i] = BUZZER_PATTERN_LONG;
+  }
+}
+
+// Settings stored before the blob existed lived in individual keys
+static void migrateLegacySettings(DeviceSettings& s) {
+  if (!preferences.isKey("first_boot") && !preferences.isKey("ssid") && !preferences.isKey("city")) {
+    return;
+  }
+
+  preferences.getString("ssid", "").toCharArray(s.ssid, sizeof(s.ssid));
+  preferences.getString("password", "").toCharArray(s.password, sizeof(s.password));
+  preferences.getString("city", DEFAULT_CITY).toCharArray(s.city, sizeof(s.city));
+  preferences.getString("timezone", DEFAULT_TIMEZONE).toCharArray(s.timezone, sizeof(s.timezone));
+  s.timezoneOffset = preferences.getInt("tz_offset", DEFAULT_TIMEZONE_OFFSET);
+  s.firstBootDone = !preferences.getBool("first_boot", true);
+
+  // The blob must be in NVS before the old keys go, or a power cut in
+  // between loses the WiFi credentials and city
+  settingsDirtyMask = SETTINGS_DIRTY_ALL;
+  if (!saveSettingsNow()) {
+    debugPrintln("Legacy settings keys kept until the blob is written");
+    return;
+  }
+
+  const char* legacyKeys[] = {"ssid", "password", "city", "timezone", "tz_offset", "first_boot"};
+  for (const char* key : legacyKeys) {
+    preferences.remove(key);
+  }
+  debugPrintln("Migrated legacy settings keys into settings blob");
+}
+
+// Copies persisted values into the runtime globals used by the managers.
+// Boot only, before any task runs; later location changes reach the
+// globals through the EVENT_SETTINGS_CHANGED dispatch.
+static void publishSettings() {
+  savedSSID = deviceSettings.ssid;
+  savedPassword = deviceSettings.password;
+  currentCity = deviceSettings.city;
+  applyTimezone(deviceSettings.timezone);
+}
+
+static void markSettingsDirty(uint8_t mask) {
+  settingsDirtyMask |= mask;
+  settingsLastChange = millis();
+  saveWarmBootSnapshot();
+
+  SystemEvent event;
+  event.type = EVENT_SETTINGS_CHANGED;
+  event.settings.dirtyMask = mask;
+  postSystemEvent(event);
+}
+
+static bool copyIfChanged(char* field, size_t size, const String& value) {
+  if (strncmp(field, value.c_str(), size) == 0) {
+    return false;
+  }
+  memset(field, 0, size);
+  value.toCharArray(field, size);
+  return true;
+}
+
+void loadSettings() {
+  applyDefaultSettings(deviceSettings);
+
+  DeviceSettings stored;
+  size_t length = preferences.getBytesLength(SETTINGS_KEY);
+  if (length >= offsetof(DeviceSettings, crc) + sizeof(uint32_t) && length <= sizeof(DeviceSettings) &&
+      preferences.getBytes(SETTINGS_KEY, &stored, length) == length) {
+    // Older, shorter blobs keep their fields; newer fields keep defaults
+    uint32_t storedCrc;
+    memcpy(&storedCrc, reinterpret_cast<uint8_t*>(&stored) + length - sizeof(uint32_t), sizeof(storedCrc));
+    if (stored.size == length && stored.version <= SETTINGS_VERSION &&
+        cacheCrc32(reinterpret_cast<const uint8_t*>(&stored), length - sizeof(uint32_t)) == storedCrc) {
+      memcpy(&deviceSettings, &stored, length - sizeof(uint32_t));
+      if (stored.version != SETTINGS_VERSION) {
+        deviceSettings.version = SETTINGS_VERSION;
+        deviceSettings.size = sizeof(DeviceSettings);
+        markSettingsDirty(SETTINGS_DIRTY_ALL);
+      }
+    } else {
+      debugPrintln("Settings blob invalid, using defaults");
+    }
+  } else {
+    migrateLegacySettings(deviceSettings);
+  }
+
+  publishSettings();
+  saveWarmBootSnapshot();
+  debugPrintln("Settings loaded (city: " + currentCity + ", " + String(deviceSettings.writeCount) + " NVS writes)");
+}
+
+// Warm boot: settings come from RTC memory, NVS is not read
+void restoreSettings(const DeviceSettings& snapshot, bool dirty) {
+  deviceSettings = snapshot;
+  if (dirty) {
+    markSettingsDirty(SETTINGS_DIRTY_ALL);
+  }
+  publishSettings();
+}
+
+// Returns false only when a pending change could not be written
+bool saveSettingsNow() {
+  StorageLock lock;
+  if (settingsDirtyMask == 0) {
+    return true;
+  }
+
+  deviceSettings.writeCount++;
+  deviceSettings.crc = settingsCrc(deviceSettings);
+  if (preferences.putBytes(SETTINGS_KEY, &deviceSettings, sizeof(DeviceSettings)) == sizeof(DeviceSettings)) {
+    settingsSessionWrites++;
+    settingsDirtyMask = 0;
+    saveWarmBootSnapshot();
+    debugPrintln("Settings saved to NVS (write #" + String(deviceSettings.writeCount) + ")");
+    return true;
+  }
+  deviceSettings.writeCount--;
+  debugPrintln("ERROR: Failed to save settings to NVS");
+  return false;
+}
+
+void serviceSettings() {
+  StorageLock lock;
+  if (settingsDirtyMask != 0 && millis() - settingsLastChange >= SETTINGS_SAVE_DELAY) {
+    saveSettingsNow();
+  }
+}
+
+void settingsSetWiFi(const String& ssid, const String& password) {
+  StorageLock lock;
+  bool changed = copyIfChanged(deviceSettings.ssid, sizeof(deviceSettings.ssid), ssid);
+  changed |= copyIfChanged(deviceSettings.password, sizeof(deviceSettings.password), password);
+  if (changed) {
+    markSettingsDirty(SETTINGS_DIRTY_WIFI);
+  }
+  savedSSID = deviceSettings.ssid;
+  savedPassword = deviceSettings.password;
+}
+
+void settingsClearWiFi() {
+  settingsSetWiFi("", "");
+}
+
+// Rejects names the blob field cannot hold, rather than caching under a cut name.
+// currentCity follows when loop() dispatches the settings event, from the
+// stored field, so cache paths do not change across a reboot.
+bool settingsSetCity(const String& city) {
+  if (city.length() == 0 || city.length() > MAX_CITY_NAME_LENGTH) {
+    return false;
+  }
+  StorageLock lock;
+  if (copyIfChanged(deviceSettings.city, sizeof(deviceSettings.city), city)) {
+    invalidateWarmBootSchedules();
+    markSettingsDirty(SETTINGS_DIRTY_LOCATION);
+  }
+  return true;
+}
+
+void settingsSetTimezone(const String& timezone, int offset) {
+  StorageLock lock;
+  bool changed = copyIfChanged(deviceSettings.timezone, sizeof(deviceSettings.timezone), timezone);
+  if (deviceSettings.timezoneOffset != offset) {
+    deviceSettings.timezoneOffset = offset;
+    changed = true;
+  }
+  if (changed) {
+    markSettingsDirty(SETTINGS_DIRTY_LOCATION);
+  }
+}
+
+void settingsSetFirstBootDone() {
+  StorageLock lock;
+  if (!deviceSettings.firstBootDone) {
+    deviceSettings.firstBootDone = 1;
+    markSettingsDirty(SETTINGS_DIRTY_SYSTEM);
+  }
+}
+
+void settingsSetBuzzerPattern(int prayer, bool warning, uint8_t pattern) {
+  if (prayer < 0 || prayer >= PRAYER_COUNT || pattern >= BUZZER_PATTERN_COUNT) {
+    return;
+  }
+  StorageLock lock;
+  uint8_t& field = warning ? deviceSettings.warningPatterns[prayer] : deviceSettings.alertPatterns[prayer];
+  if (field != pattern) {
+    field = pattern;
+    markSettingsDirty(SETTINGS_DIRTY_ALERTS);
+  }
+}
+
+bool settingsPending() {
+  return settingsDirtyMask != 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * System Events Implementation
+ * Managers report changes as events instead of writing each other's state.
+ * The loop() task (setup() included) is the only producer of a lock-free
+ * single-producer queue. Every other task (boot network, bulk store, cache
+ * prefetcher) posts into one FreeRTOS queue, which takes any number of
+ * producers. loop() is the only consumer and applies every event on its own
+ * task, so the runtime location (currentCity, the active timezone) changes
+ * only here.
+ */
+
+#include "global.h"
+#include "spsc_queue.h"
+#include <atomic>
+
+static SpscQueue<SystemEvent, SYSTEM_EVENT_QUEUE_SIZE> loopEvents;
+static QueueHandle_t taskEvents = nullptr;
+static TaskHandle_t loopTask = nullptr;
+static std::atomic<uint32_t> taskEventsDropped(0);
+static uint32_t taskEventsPeak = 0;
+static uint32_t dispatchedEvents = 0;
+static bool locationChangePending = false;
+
+// From setup(), before anything posts
+void initializeSystemEvents() {
+  loopTask = xTaskGetCurrentTaskHandle();
+  taskEvents = xQueueCreate(SYSTEM_EVENT_QUEUE_SIZE, sizeof(SystemEvent));
+}
+
+bool postSystemEvent(const SystemEvent& event) {
+  bool queued;
+  if (xTaskGetCurrentTaskHandle() == loopTask) {
+    queued = loopEvents.push(event);
+  } else {
+    queued = taskEvents != nullptr && xQueueSend(taskEvents, &event, 0) == pdTRUE;
+    if (!queued) {
+      taskEventsDropped++;
+    }
+  }
+  if (!queued) {
+    debugPrintln("Event queue full, dropped event type " + String(event.type));
+  }
+  return queued;
+}
+
+static void applyWiFiChanged(const SystemEvent& event) {
+  if (event.wifi.connected) {
+    reconnectRetries = 0;
+    SerialBT.println("WiFi connected (" + String(event.wifi.rssi) + " dBm)");
+    wakeCachePrefetcher();
+  } else {
+    SerialBT.println(F("WiFi disconnected"));
+  }
+}
+
+// Settings record the zone; the runtime copy follows with the settings event
+static void applyTimezoneReported(const SystemEvent& event) {
+  TimezoneInfo zone;
+  if (!resolveTimezone(event.timezone, zone)) {
+    debugPrintln("Unknown timezone from API: " + String(event.timezone) + ", using " + zone.name);
+  }
+  // Settings only schedule an NVS write when the value actually changed
+  settingsSetTimezone(zone.name, wholeHourOffset(zone.offsetMinutes));
+}
+
+// currentCity and the active timezone follow deviceSettings from here only.
+// A fetch in flight keeps its city: while one holds the API lock the change
+// waits for a later dispatch instead of blocking loop().
+static void applyLocationChanged() {
+  ApiLock fetchLock(0);
+  if (!fetchLock.held()) {
+    return;
+  }
+  locationChangePending = false;
+
+  String oldCity = currentCity;
+  String oldTimezone = currentTimezone;
+  {
+    StorageLock lock; // Display, status and the background tasks read these
+    currentCity = deviceSettings.city;
+    applyTimezone(deviceSettings.timezone);
+  }
+
+  if (oldTimezone != currentTimezone) {
+    debugPrintln("Timezone changed to " + currentTimezone + " (" + activeTimezone.offsetLabel + "), syncing NTP...");
+    syncTimeWithNTP(true);
+  }
+  if (oldCity != currentCity) {
+    fetchPrayerTimes();
+  }
+  wakeCachePrefetcher();
+}
+
+static void applySystemEvent(const SystemEvent& event) {
+  switch (event.type) {
+    case EVENT_WIFI_CHANGED:
+      applyWiFiChanged(event);
+      break;
+    case EVENT_SCHEDULE_UPDATED:
+      updateWarmBootSchedule(event.schedule);
+      break;
+    case EVENT_ALERT_FIRED:
+      if (event.alert.warning) {
+        startPrayerWarningBuzzer(event.alert.prayer);
+      } else {
+        startPrayerTimeBuzzer(event.alert.prayer);
+      }
+      break;
+    case EVENT_COMMAND_RECEIVED:
+      handleBluetoothInput(event.command);
+      break;
+    case EVENT_SETTINGS_CHANGED:
+      if (event.settings.dirtyMask & SETTINGS_DIRTY_LOCATION) {
+        locationChangePending = true;
+        applyLocationChanged();
+      }
+      break;
+    case EVENT_TIMEZONE_REPORTED:
+      applyTimezoneReported(event);
+      break;
+  }
+}
+
+// Consumer side, loop() task only
+void dispatchSystemEvents() {
+  SystemEvent event;
+  while (loopEvents.pop(event)) {
+    applySystemEvent(event);
+    dispatchedEvents++;
+  }
+  if (taskEvents != nullptr) {
+    taskEventsPeak = max(taskEventsPeak, (uint32_t)uxQueueMessagesWaiting(taskEvents));
+    while (xQueueReceive(taskEvents, &event, 0) == pdTRUE) {
+      applySystemEvent(event);
+      dispatchedEvents++;
+    }
+  }
+  if (locationChangePending) {
+    applyLocationChanged();
+  }
+}
+
+void showEventQueueStatus() {
+  SerialBT.print(F("Events: "));
+  SerialBT.print(dispatchedEvents);
+  SerialBT.print(F(" dispatched, loop peak "));
+  SerialBT.print(loopEvents.peak());
+  SerialBT.print(F("/"));
+  SerialBT.print((uint32_t)loopEvents.capacity());
+  SerialBT.print(F(" dropped "));
+  SerialBT.print(loopEvents.dropped());
+  SerialBT.print(F(", tasks peak "));
+  SerialBT.print(taskEventsPeak);
+  SerialBT.print(F("/"));
+  SerialBT.print((uint32_t)SYSTEM_EVENT_QUEUE_SIZE);
+  SerialBT.print(F(" dropped "));
+  SerialBT.println(taskEventsDropped.load());
+}
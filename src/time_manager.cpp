@@ -3,6 +3,120 @@
  */
 
 #include "global.h"
+#include "tz_table.h"
+
+TimezoneInfo activeTimezone = {DEFAULT_TIMEZONE, "WIB-7", DEFAULT_TIMEZONE_OFFSET * 60, "WIB", "GMT+7",
+                               DEFAULT_TIMEZONE_OFFSET * 60, "WIB", "GMT+7"};
+
+static uint32_t timezoneNameHash(const char* name) {
+  uint32_t hash = 0x811C9DC5UL;
+  while (*name) {
+    hash ^= (uint8_t)*name++;
+    hash *= 0x01000193UL;
+  }
+  return hash;
+}
+
+static const TzEntry* findTimezone(const char* name) {
+  uint32_t hash = timezoneNameHash(name);
+  uint32_t slot = hash & (TZ_HASH_SIZE - 1);
+  while (tzHashIndex[slot] != TZ_HASH_EMPTY) {
+    const TzEntry& entry = tzEntries[tzHashIndex[slot]];
+    if (entry.hash == hash && strcmp(entry.name, name) == 0) {
+      return &entry;
+    }
+    slot = (slot + 1) & (TZ_HASH_SIZE - 1);
+  }
+  return nullptr;
+}
+
+static void formatOffsetLabel(char* label, size_t size, int offsetMinutes) {
+  int absMinutes = abs(offsetMinutes);
+  char sign = offsetMinutes < 0 ? '-' : '+';
+  if (absMinutes % 60) {
+    snprintf(label, size, "GMT%c%d:%02d", sign, absMinutes / 60, absMinutes % 60);
+  } else {
+    snprintf(label, size, "GMT%c%d", sign, absMinutes / 60);
+  }
+}
+
+// Table entry and labels for an IANA name; DEFAULT_TIMEZONE (and false) when unknown
+bool resolveTimezone(const String& name, TimezoneInfo& zone) {
+  const TzEntry* entry = findTimezone(name.c_str());
+  bool known = entry != nullptr;
+  if (!known) {
+    entry = findTimezone(DEFAULT_TIMEZONE);
+  }
+  
+  zone.name = entry->name;
+  zone.posix = entry->posix;
+  zone.offsetMinutes = entry->offsetMinutes;
+  strncpy(zone.abbreviation, entry->abbreviation, sizeof(zone.abbreviation) - 1);
+  zone.abbreviation[sizeof(zone.abbreviation) - 1] = '\0';
+  formatOffsetLabel(zone.offsetLabel, sizeof(zone.offsetLabel), entry->offsetMinutes);
+  
+  zone.dstOffsetMinutes = entry->dstOffsetMinutes;
+  strncpy(zone.dstAbbreviation, entry->dstAbbreviation, sizeof(zone.dstAbbreviation) - 1);
+  zone.dstAbbreviation[sizeof(zone.dstAbbreviation) - 1] = '\0';
+  formatOffsetLabel(zone.dstOffsetLabel, sizeof(zone.dstOffsetLabel), entry->dstOffsetMinutes);
+  return known;
+}
+
+// The legacy whole-hour offset is rounded (+5:30 and +5:45 store 6);
+// activeTimezone.offsetMinutes keeps the exact value for everything else
+int wholeHourOffset(int offsetMinutes) {
+  return (offsetMinutes + (offsetMinutes < 0 ? -30 : 30)) / 60;
+}
+
+// Caches offset and labels for every caller. Runs at boot before any task
+// starts, then only from the event dispatcher (see system_events.cpp).
+// The POSIX rule goes into TZ right away so isDaylightTime() works from
+// the RTC alone, before the first NTP sync.
+bool applyTimezone(const String& name) {
+  bool known = resolveTimezone(name, activeTimezone);
+  currentTimezone = activeTimezone.name;
+  timezoneOffset = wholeHourOffset(activeTimezone.offsetMinutes);
+  setenv("TZ", activeTimezone.posix, 1);
+  tzset();
+  return known;
+}
+
+// Whether a local wall-clock time falls in daylight time. mktime() applies
+// the zone's POSIX rule; in the repeated hour after the switch back it
+// picks one of the two readings.
+static bool isDaylightAt(int year, int month, int day, int hour, int minute) {
+  if (activeTimezone.dstOffsetMinutes == activeTimezone.offsetMinutes) {
+    return false;
+  }
+  struct tm local = {};
+  local.tm_year = year - 1900;
+  local.tm_mon = month - 1;
+  local.tm_mday = day;
+  local.tm_hour = hour;
+  local.tm_min = minute;
+  local.tm_isdst = -1;
+  mktime(&local);
+  return local.tm_isdst > 0;
+}
+
+bool isDaylightTime(const DateTime& local) {
+  return isDaylightAt(local.year(), local.month(), local.day(), local.hour(), local.minute());
+}
+
+bool isDaylightTimeNow() {
+  if (rtcInitialized) {
+    return isDaylightTime(rtc.now());
+  }
+  struct tm timeinfo;
+  return getLocalTime(&timeinfo, 0) && timeinfo.tm_isdst > 0;
+}
+
+// UTC offset in force at local noon of a day, as tools/schedule_gen.cpp
+// stamps it; prayer times never fall on the switch hour
+int utcOffsetMinutesOn(const CivilDate& date) {
+  return isDaylightAt(date.year, date.month, date.day, 12, 0) ? activeTimezone.dstOffsetMinutes
+                                                               : activeTimezone.offsetMinutes;
+}
 
 void initializeRTC() {
   if (rtc.begin()) {
@@ -23,16 +137,16 @@ void syncTimeWithNTP() {
 }
 
 void syncTimeWithNTP(bool forceSync) {
-  if (!wifiConnected) {
+  if (!isWiFiConnected()) {
     SerialBT.println("WiFi not connected. Cannot sync time.");
     return;
   }
   
   SerialBT.println("Syncing time with NTP server...");
-  debugPrintln("Starting NTP sync with timezone: " + currentTimezone + " (GMT+" + String(timezoneOffset) + ")");
+  debugPrintln("Starting NTP sync with timezone: " + currentTimezone + " (" + activeTimezone.offsetLabel + ")");
   
-  // Configure NTP with multiple servers for redundancy
-  configTime(timezoneOffset * 3600, 0, NTP_SERVER1, NTP_SERVER2, NTP_SERVER3);
+  // Configure NTP with multiple servers for redundancy; the POSIX rule covers DST zones too
+  configTzTime(activeTimezone.posix, NTP_SERVER1, NTP_SERVER2, NTP_SERVER3);
   
   struct tm timeinfo;
   int attempts = 0;
@@ -78,64 +192,44 @@ void updateRTCFromNTP() {
 }
 
 String getCurrentTime() {
-  String tzAbbr = "WIB";
-  if (timezoneOffset == 8) tzAbbr = "WITA";
-  else if (timezoneOffset == 9) tzAbbr = "WIT";
-  
   if (rtcInitialized) {
     DateTime now = rtc.now();
-    char timeBuffer[25];
-    sprintf(timeBuffer, "%02d/%02d/%04d %02d:%02d:%02d %s",
-            now.day(), now.month(), now.year(),
-            now.hour(), now.minute(), now.second(), tzAbbr.c_str());
+    const char* tzAbbr = isDaylightTime(now) ? activeTimezone.dstAbbreviation : activeTimezone.abbreviation;
+    char timeBuffer[32];  // 20 fixed characters plus an abbreviation of up to 7
+    snprintf(timeBuffer, sizeof(timeBuffer), "%02d/%02d/%04d %02d:%02d:%02d %s",
+             now.day(), now.month(), now.year(),
+             now.hour(), now.minute(), now.second(), tzAbbr);
     return String(timeBuffer);
   } else {
     struct tm timeinfo;
     if (getLocalTime(&timeinfo)) {
-      char timeBuffer[25];
-      sprintf(timeBuffer, "%02d/%02d/%04d %02d:%02d:%02d %s",
-              timeinfo.tm_mday, timeinfo.tm_mon + 1, timeinfo.tm_year + 1900,
-              timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec, tzAbbr.c_str());
+      const char* tzAbbr = timeinfo.tm_isdst > 0 ? activeTimezone.dstAbbreviation : activeTimezone.abbreviation;
+      char timeBuffer[32];
+      snprintf(timeBuffer, sizeof(timeBuffer), "%02d/%02d/%04d %02d:%02d:%02d %s",
+               timeinfo.tm_mday, timeinfo.tm_mon + 1, timeinfo.tm_year + 1900,
+               timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec, tzAbbr);
       return String(timeBuffer);
     }
     return "Time not available";
   }
 }
 
-String getCurrentDateForAPI() {
+// Today's local date from the RTC, or from the system clock after NTP.
+// Returns an invalid date (year 0) when neither source has the time.
+CivilDate getToday() {
   if (rtcInitialized) {
-    DateTime now = rtc.now();
-    char dateStr[12];
-    sprintf(dateStr, "%02d-%02d-%04d", now.day(), now.month(), now.year());
-    return String(dateStr);
-  } else {
-    struct tm timeinfo;
-    if (getLocalTime(&timeinfo)) {
-      char dateStr[12];
-      sprintf(dateStr, "%02d-%02d-%04d", timeinfo.tm_mday, timeinfo.tm_mon + 1, timeinfo.tm_year + 1900);
-      return String(dateStr);
-    } else {
-      // Fallback to today's date
-      return "27-09-2025";
-    }
+    return civilDateFrom(rtc.now());
+  }
+  
+  struct tm timeinfo;
+  if (getLocalTime(&timeinfo, 0)) {
+    return CivilDate{(int16_t)(timeinfo.tm_year + 1900), (uint8_t)(timeinfo.tm_mon + 1), (uint8_t)timeinfo.tm_mday};
   }
+  return CivilDate{0, 0, 0};
 }
 
-String getCurrentDateString() {
-  if (rtcInitialized) {
-    DateTime now = rtc.now();
-    char dateStr[12];
-    sprintf(dateStr, "%02d-%02d-%04d", now.day(), now.month(), now.year());
-    return String(dateStr);
-  } else {
-    struct tm timeinfo;
-    if (getLocalTime(&timeinfo)) {
-      char dateStr[12];
-      sprintf(dateStr, "%02d-%02d-%04d", timeinfo.tm_mday, timeinfo.tm_mon + 1, timeinfo.tm_year + 1900);
-      return String(dateStr);
-    } else {
-      // Fallback to today's date
-      return "27-09-2025";
-    }
-  }
-}
\ No newline at end of file
+String dateKeyString(const CivilDate& date) {
+  char key[DATE_KEY_LENGTH + 1];
+  formatDateKey(date, key);
+  return String(key);
+}
@@ -0,0 +1,163 @@
+/*
+ * Warm Boot Snapshot Implementation
+ * Today's and tomorrow's schedules, settings and alert dedupe state kept in
+ * RTC slow memory, so a software, watchdog or brownout reset resumes alerting
+ * without waiting for NVS, SD, Bluetooth or WiFi. Every change to the
+ * snapshot's days is published to the alert path (active_schedule.cpp).
+ */
+
+#include "global.h"
+#include <esp_system.h>
+#include <esp_timer.h>
+
+struct WarmBootSnapshot {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;
+  uint32_t bootCount;               // Warm boots since the last power-on
+  DeviceSettings settings;
+  uint8_t settingsDirty;            // Settings not yet committed to NVS
+  uint8_t reserved[3];
+  AlertDedupe alerts;
+  DaySchedule days[WARM_BOOT_DAYS]; // dayNumber 0 = empty
+  uint32_t crc;
+};
+
+// Survives every reset except power loss; validity is decided by the crc
+static RTC_NOINIT_ATTR WarmBootSnapshot warmSnapshot;
+
+bool warmBoot = false;
+static esp_reset_reason_t bootResetReason = ESP_RST_UNKNOWN;
+static int64_t alertReadyMicros = -1;
+
+static uint32_t warmSnapshotCrc() {
+  return cacheCrc32(reinterpret_cast<const uint8_t*>(&warmSnapshot), offsetof(WarmBootSnapshot, crc));
+}
+
+static bool isWarmResetReason(esp_reset_reason_t reason) {
+  switch (reason) {
+    case ESP_RST_SW:
+    case ESP_RST_PANIC:
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+    case ESP_RST_BROWNOUT:
+    case ESP_RST_DEEPSLEEP:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static void resetWarmSnapshot() {
+  memset(&warmSnapshot, 0, sizeof(warmSnapshot));
+  warmSnapshot.magic = WARM_BOOT_MAGIC;
+  warmSnapshot.version = WARM_BOOT_VERSION;
+  warmSnapshot.size = sizeof(WarmBootSnapshot);
+}
+
+static void sealWarmSnapshot() {
+  warmSnapshot.crc = warmSnapshotCrc();
+}
+
+bool restoreWarmBoot() {
+  bootResetReason = esp_reset_reason();
+  warmBoot = isWarmResetReason(bootResetReason) &&
+             warmSnapshot.magic == WARM_BOOT_MAGIC &&
+             warmSnapshot.version == WARM_BOOT_VERSION &&
+             warmSnapshot.size == sizeof(WarmBootSnapshot) &&
+             warmSnapshot.crc == warmSnapshotCrc();
+
+  if (!warmBoot) {
+    resetWarmSnapshot();
+    sealWarmSnapshot();
+    return false;
+  }
+  publishActiveSchedule(warmSnapshot.days);
+
+  warmSnapshot.bootCount++;
+  alertDedupe = warmSnapshot.alerts;
+  restoreSettings(warmSnapshot.settings, warmSnapshot.settingsDirty);
+  sealWarmSnapshot();
+  debugPrintln("Warm boot #" + String(warmSnapshot.bootCount) + " (" + resetReasonName() + "), snapshot restored");
+  return true;
+}
+
+// Called after any change to settings or alert state; a few hundred bytes of CRC
+void saveWarmBootSnapshot() {
+  StorageLock lock;
+  warmSnapshot.settings = deviceSettings;
+  warmSnapshot.settingsDirty = settingsPending();
+  warmSnapshot.alerts = alertDedupe;
+  sealWarmSnapshot();
+}
+
+// Keeps the snapshot on today and tomorrow; later days are the flash tier's job
+void refreshWarmBootSchedules(const CivilDate& today) {
+  StorageLock lock;
+  DaySchedule days[WARM_BOOT_DAYS];
+  for (int i = 0; i < WARM_BOOT_DAYS; i++) {
+    if (!getDaySchedule(addDays(today, i), days[i])) {
+      memset(&days[i], 0, sizeof(DaySchedule));
+    }
+  }
+  if (memcmp(days, warmSnapshot.days, sizeof(days)) == 0) {
+    return;
+  }
+  memcpy(warmSnapshot.days, days, sizeof(days));
+  sealWarmSnapshot();
+  publishActiveSchedule(warmSnapshot.days);
+}
+
+// Fresh data for a day already in the snapshot replaces it in place
+void updateWarmBootSchedule(const DaySchedule& schedule) {
+  StorageLock lock;
+  for (int i = 0; i < WARM_BOOT_DAYS; i++) {
+    if (warmSnapshot.days[i].dayNumber == schedule.dayNumber) {
+      warmSnapshot.days[i] = schedule;
+      sealWarmSnapshot();
+      publishActiveSchedule(warmSnapshot.days);
+      return;
+    }
+  }
+}
+
+void invalidateWarmBootSchedules() {
+  StorageLock lock;
+  memset(warmSnapshot.days, 0, sizeof(warmSnapshot.days));
+  sealWarmSnapshot();
+  publishActiveSchedule(warmSnapshot.days);
+}
+
+// First moment the alert path holds today's schedule
+void noteAlertPathReady() {
+  if (alertReadyMicros >= 0) {
+    return;
+  }
+  alertReadyMicros = esp_timer_get_time();
+  debugPrintln("Alert path ready " + String((uint32_t)(alertReadyMicros / 1000)) + " ms after boot (" +
+               (warmBoot ? "warm" : "cold") + ")");
+}
+
+int32_t alertReadyMillis() {
+  return alertReadyMicros < 0 ? -1 : (int32_t)(alertReadyMicros / 1000);
+}
+
+uint32_t warmBootCount() {
+  return warmSnapshot.bootCount;
+}
+
+const char* resetReasonName() {
+  switch (bootResetReason) {
+    case ESP_RST_POWERON:   return "power-on";
+    case ESP_RST_EXT:       return "external";
+    case ESP_RST_SW:        return "software";
+    case ESP_RST_PANIC:     return "panic";
+    case ESP_RST_INT_WDT:   return "interrupt watchdog";
+    case ESP_RST_TASK_WDT:  return "task watchdog";
+    case ESP_RST_WDT:       return "watchdog";
+    case ESP_RST_DEEPSLEEP: return "deep sleep";
+    case ESP_RST_BROWNOUT:  return "brownout";
+    default:                return "unknown";
+  }
+}
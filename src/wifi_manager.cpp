@@ -3,10 +3,15 @@
  */
 
 #include "global.h"
+#include <atomic>
+
+// Last link state reported as an event (-1 = none yet); written from either core
+static std::atomic<int8_t> reportedLinkState(-1);
 
 void loadWiFiCredentials() {
-  savedSSID = preferences.getString("ssid", "");
-  savedPassword = preferences.getString("password", "");
+  // Credentials are part of the settings blob loaded at boot
+  savedSSID = deviceSettings.ssid;
+  savedPassword = deviceSettings.password;
   
   if (savedSSID.length() > 0) {
     debugPrintln("Loaded WiFi credentials from flash: " + savedSSID);
@@ -14,17 +19,13 @@ void loadWiFiCredentials() {
 }
 
 void saveWiFiCredentials(const String& ssid, const String& password) {
-  preferences.putString("ssid", ssid);
-  preferences.putString("password", password);
-  savedSSID = ssid;
-  savedPassword = password;
+  settingsSetWiFi(ssid, password);
   debugPrintln("WiFi credentials saved to flash");
 }
 
 void clearWiFiCredentials() {
-  preferences.clear();
-  savedSSID = "";
-  savedPassword = "";
+  // Only the WiFi fields; city and timezone are kept
+  settingsClearWiFi();
   debugPrintln("WiFi credentials cleared from flash");
 }
 
@@ -41,14 +42,13 @@ bool connectToWiFi(const String& ssid, const String& password) {
   }
   
   if (WiFi.status() == WL_CONNECTED) {
-    wifiConnected = true;
-    reconnectRetries = 0;
+    noteWiFiLinkState(true);
     SerialBT.println("\nWiFi connected successfully!");
     SerialBT.println("IP Address: " + WiFi.localIP().toString());
     debugPrintln("WiFi connected. IP: " + WiFi.localIP().toString());
     return true;
   } else {
-    wifiConnected = false;
+    noteWiFiLinkState(false);
     SerialBT.println("\nFailed to connect to WiFi");
     debugPrintln("WiFi connection failed");
     return false;
@@ -98,19 +98,35 @@ void displayWiFiNetworks() {
   SerialBT.println("================================");
 }
 
+// The driver holds the link state; both cores may ask
+bool isWiFiConnected() {
+  return WiFi.status() == WL_CONNECTED;
+}
+
+// Posts an event when the link state differs from the last one reported
+void noteWiFiLinkState(bool connected) {
+  int8_t state = connected ? 1 : 0;
+  int8_t previous = reportedLinkState.exchange(state);
+  if (previous == state || (previous < 0 && !connected)) {
+    return; // No change, or a first attempt that never connected
+  }
+
+  SystemEvent event;
+  event.type = EVENT_WIFI_CHANGED;
+  event.wifi.connected = connected;
+  event.wifi.rssi = connected ? WiFi.RSSI() : 0;
+  postSystemEvent(event);
+  debugPrintln(connected ? "WiFi link up" : "WiFi link down");
+}
+
+// Link monitor for drops and driver-side reconnects, from loop()
 void checkWiFiConnection() {
-  bool currentStatus = (WiFi.status() == WL_CONNECTED);
-  
-  if (currentStatus != wifiConnected) {
-    wifiConnected = currentStatus;
-    if (wifiConnected) {
-      debugPrintln("WiFi reconnected");
-      SerialBT.println("WiFi reconnected!");
-      reconnectRetries = 0;
-    } else {
-      debugPrintln("WiFi disconnected");
-      SerialBT.println("WiFi connection lost");
-    }
+  if (millis() - lastWiFiCheck < WIFI_CHECK_INTERVAL) {
+    return;
+  }
+  lastWiFiCheck = millis();
+  if (reportedLinkState.load() >= 0) {
+    noteWiFiLinkState(isWiFiConnected());
   }
 }
 
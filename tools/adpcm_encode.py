@@ -0,0 +1,209 @@
+"""
+IMA-ADPCM encoder for adhan clips played by src/audio_player.cpp.
+
+Reads a PCM WAV (8/16-bit, any channel count), mixes it down to mono,
+optionally resamples it, and writes a 4-bit IMA-ADPCM WAV (format 0x11)
+in blocks the firmware decodes one at a time. A 16 kHz clip shrinks to
+about a quarter of its 16-bit size (3 minutes: 5.8 MB -> 1.4 MB).
+
+--decode writes the PCM the firmware will play, using the same tables as
+the decoder in src/audio_pipeline.cpp, so a clip can be checked by ear
+before it is copied to the SD card as /audio/adhan.wav.
+
+Usage:
+  python tools/adpcm_encode.py adhan_44k.wav adhan.wav --rate 16000
+  python tools/adpcm_encode.py adhan.wav check.wav --decode
+"""
+
+import argparse
+import array
+import struct
+import sys
+import wave
+
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767,
+]
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8]
+
+WAV_FORMAT_IMA_ADPCM = 0x0011
+FIRMWARE_MAX_BLOCK = 1024  # AUDIO_READ_CHUNK in include/config.h
+
+
+def decode_step(predictor, index, nibble):
+    """One decoder step, exactly as the firmware computes it."""
+    step = STEP_TABLE[index]
+    delta = step >> 3
+    if nibble & 4:
+        delta += step
+    if nibble & 2:
+        delta += step >> 1
+    if nibble & 1:
+        delta += step >> 2
+    predictor += -delta if nibble & 8 else delta
+    predictor = max(-32768, min(32767, predictor))
+    index = max(0, min(88, index + INDEX_TABLE[nibble]))
+    return predictor, index
+
+
+def encode_nibble(sample, predictor, index):
+    step = STEP_TABLE[index]
+    diff = sample - predictor
+    nibble = 0
+    if diff < 0:
+        nibble = 8
+        diff = -diff
+    if diff >= step:
+        nibble |= 4
+        diff -= step
+    step >>= 1
+    if diff >= step:
+        nibble |= 2
+        diff -= step
+    step >>= 1
+    if diff >= step:
+        nibble |= 1
+    return nibble
+
+
+def read_pcm_mono(path):
+    with wave.open(path, "rb") as source:
+        channels = source.getnchannels()
+        width = source.getsampwidth()
+        rate = source.getframerate()
+        frames = source.readframes(source.getnframes())
+    if width == 2:
+        samples = array.array("h", frames)
+        if sys.byteorder == "big":
+            samples.byteswap()
+    elif width == 1:
+        samples = array.array("h", ((b - 128) << 8 for b in frames))
+    else:
+        sys.exit(f"{path}: {width * 8}-bit samples are not supported, use 8 or 16-bit PCM")
+    if channels > 1:
+        samples = array.array("h", (
+            sum(samples[i:i + channels]) // channels for i in range(0, len(samples), channels)))
+    return samples, rate
+
+
+def resample(samples, rate, target):
+    if target == rate or len(samples) < 2:
+        return samples
+    count = int(len(samples) * target / rate)
+    out = array.array("h", bytes(2 * count))
+    scale = rate / target
+    for i in range(count):
+        position = i * scale
+        j = int(position)
+        fraction = position - j
+        following = samples[j + 1] if j + 1 < len(samples) else samples[j]
+        out[i] = int(samples[j] + (following - samples[j]) * fraction)
+    return out
+
+
+def encode(samples, block_align):
+    samples_per_block = (block_align - 4) * 2 + 1
+    blocks = bytearray()
+    index = 0
+    for start in range(0, len(samples), samples_per_block):
+        chunk = samples[start:start + samples_per_block]
+        if len(chunk) % 2 == 0:
+            chunk.append(chunk[-1])  # Nibbles come in pairs after the header sample
+        predictor = chunk[0]
+        blocks += struct.pack("<hBB", predictor, index, 0)
+        for i in range(1, len(chunk), 2):
+            byte = 0
+            for shift, sample in ((0, chunk[i]), (4, chunk[i + 1])):
+                nibble = encode_nibble(sample, predictor, index)
+                predictor, index = decode_step(predictor, index, nibble)
+                byte |= nibble << shift
+            blocks.append(byte)
+    return bytes(blocks), samples_per_block
+
+
+def write_adpcm_wav(path, data, rate, block_align, samples_per_block, sample_count):
+    byte_rate = rate * block_align // samples_per_block
+    fmt = struct.pack("<HHIIHHHH", WAV_FORMAT_IMA_ADPCM, 1, rate, byte_rate, block_align, 4, 2,
+                      samples_per_block)
+    fact = struct.pack("<I", sample_count)
+    body = (b"WAVE" + b"fmt " + struct.pack("<I", len(fmt)) + fmt +
+            b"fact" + struct.pack("<I", len(fact)) + fact +
+            b"data" + struct.pack("<I", len(data)) + data + (b"\0" if len(data) % 2 else b""))
+    with open(path, "wb") as out:
+        out.write(b"RIFF" + struct.pack("<I", len(body)) + body)
+
+
+def decode_file(path, output):
+    with open(path, "rb") as source:
+        raw = source.read()
+    if raw[:4] != b"RIFF" or raw[8:12] != b"WAVE":
+        sys.exit(f"{path}: not a WAV file")
+    position, fmt, data = 12, None, None
+    while position + 8 <= len(raw):
+        chunk_id, size = raw[position:position + 4], struct.unpack_from("<I", raw, position + 4)[0]
+        if chunk_id == b"fmt ":
+            fmt = struct.unpack_from("<HHIIHH", raw, position + 8)
+        elif chunk_id == b"data":
+            data = raw[position + 8:position + 8 + size]
+        position += 8 + size + (size & 1)
+    if fmt is None or data is None or fmt[0] != WAV_FORMAT_IMA_ADPCM or fmt[1] != 1:
+        sys.exit(f"{path}: not a mono IMA-ADPCM WAV")
+    rate, block_align = fmt[2], fmt[4]
+
+    pcm = array.array("h")
+    for start in range(0, len(data), block_align):
+        block = data[start:start + block_align]
+        if len(block) < 4:
+            break
+        predictor, index = struct.unpack_from("<hB", block)
+        index = min(index, 88)
+        pcm.append(predictor)
+        for byte in block[4:]:
+            for nibble in (byte & 0x0F, byte >> 4):
+                predictor, index = decode_step(predictor, index, nibble)
+                pcm.append(predictor)
+    if sys.byteorder == "big":
+        pcm.byteswap()
+    with wave.open(output, "wb") as out:
+        out.setnchannels(1)
+        out.setsampwidth(2)
+        out.setframerate(rate)
+        out.writeframes(pcm.tobytes())
+    print(f"{output}: {len(pcm)} samples, {len(pcm) / rate:.1f} s at {rate} Hz")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input")
+    parser.add_argument("output")
+    parser.add_argument("--rate", type=int, default=0, help="resample to this rate (default: keep)")
+    parser.add_argument("--block", type=int, default=512,
+                        help=f"block size in bytes, 8..{FIRMWARE_MAX_BLOCK} (default 512)")
+    parser.add_argument("--decode", action="store_true", help="decode an ADPCM WAV back to 16-bit PCM")
+    args = parser.parse_args()
+
+    if args.decode:
+        decode_file(args.input, args.output)
+        return
+    if not 8 <= args.block <= FIRMWARE_MAX_BLOCK:
+        sys.exit(f"--block must be between 8 and {FIRMWARE_MAX_BLOCK} bytes")
+
+    samples, rate = read_pcm_mono(args.input)
+    if args.rate:
+        samples = resample(samples, rate, args.rate)
+        rate = args.rate
+    data, samples_per_block = encode(samples, args.block)
+    write_adpcm_wav(args.output, data, rate, args.block, samples_per_block, len(samples))
+    pcm_bytes = 2 * len(samples)
+    print(f"{args.output}: {len(samples)} samples at {rate} Hz, {len(data)} bytes "
+          f"({pcm_bytes / max(len(data), 1):.2f}:1 vs 16-bit PCM)")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,246 @@
+/*
+ * Host run of the adhan audio pipeline (include/audio_pipeline.h).
+ *
+ * Streams a WAV file through the same reader and ping-pong buffers the
+ * device uses, with a feeder thread in place of the SD task and a player
+ * thread that models the I2S DMA ring (AUDIO_DMA_BUFFERS x
+ * AUDIO_DMA_BUFFER_LEN samples drained in real time). What reaches the
+ * "DAC" is written to a 16-bit mono WAV, including the silence the
+ * hardware would play on an underrun, so gaps can be heard and counted.
+ *
+ * Storage latency spikes are injected into the feeder's reads:
+ *
+ *   --stall-ms N      sleep N ms on every stalled read
+ *   --stall-every K   stall every K-th read of AUDIO_READ_CHUNK bytes
+ *   --speed X         play X times faster than real time (default 1)
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++17 -O2 -Iinclude tools/audio_stream_host.cpp src/audio_pipeline.cpp -o audio_stream_host -pthread
+ *   ./audio_stream_host adhan.wav out.wav --stall-ms 150 --stall-every 40
+ */
+
+#include "audio_pipeline.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+struct FeederSource {
+  FILE* file;
+  uint32_t reads;
+  uint32_t stallEvery;
+  uint32_t stallMs;
+  uint32_t stalls;
+};
+
+struct HostCounters {
+  uint32_t buffersFilled = 0;
+  uint32_t buffersPlayed = 0;
+  uint32_t lateBuffers = 0;        // Player found no full buffer
+  uint32_t underruns = 0;          // DMA ring ran dry: audible silence
+  uint64_t silenceSamples = 0;     // Played by the DMA model while starved
+  double slowestFillMs = 0;
+};
+
+static AudioPingPong pingPong;
+static AudioStream stream;
+static HostCounters counters;
+
+static size_t readSource(uint8_t* buffer, size_t length, void* context) {
+  FeederSource* source = static_cast<FeederSource*>(context);
+  source->reads++;
+  if (source->stallEvery > 0 && source->reads % source->stallEvery == 0) {
+    source->stalls++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(source->stallMs));
+  }
+  return fread(buffer, 1, length, source->file);
+}
+
+static size_t writeSink(const uint8_t* data, size_t length, void* context) {
+  return fwrite(data, 1, length, static_cast<FILE*>(context));
+}
+
+// Same shape as fillBuffer() in src/audio_player.cpp
+static bool fillBuffer(int16_t* buffer) {
+  Clock::time_point started = Clock::now();
+  size_t samples = 0;
+  while (samples < AudioPingPong::capacity()) {
+    size_t count = audioStreamRead(stream, buffer + samples, AudioPingPong::capacity() - samples);
+    if (count == 0) {
+      break;
+    }
+    samples += count;
+  }
+  bool last = audioStreamEnded(stream);
+  pingPong.commitFill(samples, last);
+  counters.buffersFilled++;
+
+  double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+  if (elapsed > counters.slowestFillMs) {
+    counters.slowestFillMs = elapsed;
+  }
+  return !last;
+}
+
+static void feederThread() {
+  bool more = true;
+  while (more) {
+    int16_t* buffer = pingPong.acquireFill();
+    if (buffer == nullptr) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      continue;
+    }
+    more = fillBuffer(buffer);
+  }
+}
+
+// The DMA ring drains at the sample rate; writes block while it is full and
+// an empty ring plays silence, like tx_desc_auto_clear on the device
+class DmaModel {
+public:
+  DmaModel(FILE* sink, double samplesPerSecond) : sink_(sink), rate_(samplesPerSecond) {}
+
+  void write(const int16_t* samples, size_t count) {
+    if (!started_) {
+      // The clock starts with the first queued sample
+      start_ = Clock::now();
+      started_ = true;
+    }
+    const size_t ring = AUDIO_DMA_BUFFERS * AUDIO_DMA_BUFFER_LEN;
+    while (count > 0) {
+      size_t chunk = count < AUDIO_DMA_BUFFER_LEN ? count : AUDIO_DMA_BUFFER_LEN;
+      while (true) {
+        catchUp();
+        if (written_ + chunk - played() <= ring) {
+          break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+      }
+      fwrite(samples, sizeof(int16_t), chunk, sink_);
+      written_ += chunk;
+      samples += chunk;
+      count -= chunk;
+    }
+  }
+
+  uint64_t written() const { return written_; }
+
+private:
+  uint64_t played() const {
+    return (uint64_t)(std::chrono::duration<double>(Clock::now() - start_).count() * rate_);
+  }
+
+  // Silence for any time the ring sat empty
+  void catchUp() {
+    uint64_t now = played();
+    static const int16_t zeros[AUDIO_DMA_BUFFER_LEN] = {};
+    if (written_ < now) {
+      counters.underruns++;
+    }
+    while (written_ < now) {
+      size_t gap = now - written_ < AUDIO_DMA_BUFFER_LEN ? now - written_ : AUDIO_DMA_BUFFER_LEN;
+      fwrite(zeros, sizeof(int16_t), gap, sink_);
+      written_ += gap;
+      counters.silenceSamples += gap;
+    }
+  }
+
+  FILE* sink_;
+  double rate_;
+  Clock::time_point start_;
+  bool started_ = false;
+  uint64_t written_ = 0;
+};
+
+static void playerThread(DmaModel* dma) {
+  bool stalled = false;
+  while (true) {
+    size_t samples;
+    bool last;
+    int16_t* buffer = pingPong.acquirePlay(samples, last);
+    if (buffer == nullptr) {
+      if (!stalled) {
+        counters.lateBuffers++;
+        stalled = true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+    stalled = false;
+    dma->write(buffer, samples);
+    pingPong.releasePlay();
+    counters.buffersPlayed++;
+    if (last) {
+      break;
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s in.wav out.wav [--stall-ms N] [--stall-every K] [--speed X]\n", argv[0]);
+    return 2;
+  }
+  FeederSource source = {fopen(argv[1], "rb"), 0, 0, 0, 0};
+  double speed = 1.0;
+  for (int i = 3; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--stall-ms") == 0) {
+      source.stallMs = atoi(argv[i + 1]);
+    } else if (strcmp(argv[i], "--stall-every") == 0) {
+      source.stallEvery = atoi(argv[i + 1]);
+    } else if (strcmp(argv[i], "--speed") == 0) {
+      speed = atof(argv[i + 1]);
+    }
+  }
+  if (source.file == nullptr || !audioStreamOpen(stream, readSource, &source)) {
+    fprintf(stderr, "%s: not a supported WAV file (%s)\n", argv[1], audioFormatName(stream.format.encoding));
+    return 1;
+  }
+  FILE* sink = fopen(argv[2], "wb");
+  if (sink == nullptr) {
+    perror(argv[2]);
+    return 1;
+  }
+
+  const AudioFormat& format = stream.format;
+  double bytesPerSecond = format.encoding == WAV_FORMAT_IMA_ADPCM
+                              ? (double)format.sampleRate * format.blockAlign / format.samplesPerBlock
+                              : (double)format.sampleRate * format.channels * (format.bitsPerSample / 8);
+  printf("%s: %s, %u Hz, %u-bit, %u ch, %.1f s\n", argv[1], audioFormatName(format.encoding), format.sampleRate,
+         format.bitsPerSample, format.channels, format.dataBytes / bytesPerSecond);
+
+  wavWriteHeader(writeSink, sink, format.sampleRate, 0);
+  pingPong.reset();
+  // Prime both buffers before playback starts, as startAudioPlayback() does
+  if (fillBuffer(pingPong.acquireFill())) {
+    fillBuffer(pingPong.acquireFill());
+  }
+
+  DmaModel dma(sink, format.sampleRate * speed);
+  Clock::time_point started = Clock::now();
+  std::thread feeder(feederThread);
+  std::thread player(playerThread, &dma);
+  feeder.join();
+  player.join();
+  double wallSeconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+  // Patch the data size now that the length is known
+  uint32_t dataBytes = (uint32_t)(dma.written() * sizeof(int16_t));
+  fseek(sink, 0, SEEK_SET);
+  wavWriteHeader(writeSink, sink, format.sampleRate, dataBytes);
+  fclose(sink);
+  fclose(source.file);
+
+  double bufferMs = 1000.0 * AudioPingPong::capacity() / format.sampleRate / speed;
+  printf("buffers: %u filled, %u played (%.0f ms each, DMA ring %.0f ms)\n", counters.buffersFilled,
+         counters.buffersPlayed, bufferMs,
+         1000.0 * AUDIO_DMA_BUFFERS * AUDIO_DMA_BUFFER_LEN / format.sampleRate / speed);
+  printf("storage: %u reads, %u stalls, slowest buffer fill %.1f ms\n", source.reads, source.stalls,
+         counters.slowestFillMs);
+  printf("player: %u late buffers, %u underruns, %.1f ms of silence inserted, wall time %.1f s\n",
+         counters.lateBuffers, counters.underruns, 1000.0 * counters.silenceSamples / format.sampleRate, wallSeconds);
+  return counters.underruns == 0 ? 0 : 3;
+}
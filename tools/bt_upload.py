@@ -0,0 +1,289 @@
+"""
+Bulk schedule upload over Bluetooth for sites without WiFi.
+
+Sends the compact records written by tools/schedule_gen.cpp --records
+(<city>-<yyyy>.days) to the controller's SPP port using the framed
+protocol in include/bulk_protocol.h: every frame carries a CRC32, chunks
+of up to 32 days go out go-back-N inside the window the device grants,
+and a NAK or half a second of silence sends the missing chunks again. The session
+id is a hash of the data, so running the same command after a dropped
+link resumes where the device stopped storing.
+
+Records of the device's current city also fill its flash tier; other
+cities go to the SD card only.
+
+Usage (pair first; on Linux bind the port with `rfcomm bind 0 <address>`):
+  python tools/bt_upload.py /dev/rfcomm0 out/records/*.days
+  python tools/bt_upload.py COM7 Nganjuk-2026.days Nganjuk-2027.days   (needs pyserial)
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+import zlib
+
+FRAME_MAGIC = 0x5542
+PROTOCOL_VERSION = 1
+CHUNK_RECORDS = 32
+NAME_LENGTH = 32
+RECORD_SIZE = 24
+MAX_PAYLOAD = 4 + 2 * NAME_LENGTH + CHUNK_RECORDS * RECORD_SIZE  # BULK_MAX_PAYLOAD
+RECORD_FILE_MAGIC = 0x52444A53
+BEGIN, READY, DATA, ACK, NAK, END, DONE, ABORT = range(1, 9)
+
+HEADER = struct.Struct("<HBBHH")
+STATS_FIELDS = ("records", "stored", "unchanged", "skipped", "rejected",
+                "crc_errors", "out_of_order", "duplicates", "bytes", "elapsed_ms")
+
+ACK_TIMEOUT = 0.5     # Resend from the last acknowledged chunk after this much silence
+READY_TIMEOUT = 5.0
+RETRY_LIMIT = 20      # Timeouts in a row before giving up
+
+
+def encode_frame(frame_type, sequence, payload=b""):
+    header = HEADER.pack(FRAME_MAGIC, frame_type, 0, sequence, len(payload))
+    return header + payload + struct.pack("<I", zlib.crc32(header + payload))
+
+
+class FrameReader:
+    """Reassembles frames like BulkFrameParser; text and damaged frames are skipped."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.text = bytearray()
+
+    def feed(self, data):
+        self.buffer += data
+        frames = []
+        while True:
+            start = self.buffer.find(struct.pack("<H", FRAME_MAGIC))
+            if start < 0:
+                keep = 1 if self.buffer[-1:] == b"B" else 0
+                self.text += self.buffer[:len(self.buffer) - keep]
+                del self.buffer[:len(self.buffer) - keep]
+                return frames
+            self.text += self.buffer[:start]
+            del self.buffer[:start]
+            if len(self.buffer) < HEADER.size:
+                return frames
+            _, frame_type, _, sequence, length = HEADER.unpack_from(self.buffer)
+            if length > MAX_PAYLOAD:
+                # Magic bytes inside text or a damaged header, not a frame
+                self.text += self.buffer[:1]
+                del self.buffer[:1]
+                continue
+            if len(self.buffer) < HEADER.size + length + 4:
+                return frames
+            body = bytes(self.buffer[:HEADER.size + length])
+            (crc,) = struct.unpack_from("<I", self.buffer, HEADER.size + length)
+            if crc == zlib.crc32(body):
+                frames.append((frame_type, sequence, body[HEADER.size:]))
+                del self.buffer[:HEADER.size + length + 4]
+            else:
+                self.text += self.buffer[:1]  # Not a frame after all, look for the next magic
+                del self.buffer[:1]
+
+
+class Link:
+    """The SPP port: pyserial when installed, otherwise a raw POSIX tty."""
+
+    def __init__(self, port):
+        try:
+            import serial
+            self.serial = serial.Serial(port, 115200, timeout=0)
+            self.fd = None
+        except ImportError:
+            import termios
+            import tty
+            self.serial = None
+            self.fd = os.open(port, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+            if os.isatty(self.fd):
+                tty.setraw(self.fd)
+                attributes = termios.tcgetattr(self.fd)
+                attributes[3] &= ~termios.ECHO
+                termios.tcsetattr(self.fd, termios.TCSANOW, attributes)
+        self.sent = 0
+
+    def write(self, data):
+        self.sent += len(data)
+        if self.serial:
+            self.serial.write(data)
+            return
+        view = memoryview(data)
+        while view:
+            try:
+                view = view[os.write(self.fd, view):]
+            except BlockingIOError:
+                time.sleep(0.001)
+
+    def read(self, timeout):
+        """Whatever arrives within `timeout` seconds (returns early once data is in)."""
+        deadline = time.monotonic() + timeout
+        while True:
+            if self.serial:
+                data = self.serial.read(4096)
+            else:
+                try:
+                    data = os.read(self.fd, 4096)
+                except BlockingIOError:
+                    data = b""
+            if data or time.monotonic() >= deadline:
+                return data
+            time.sleep(0.001)
+
+    def close(self):
+        if self.serial:
+            self.serial.close()
+        else:
+            os.close(self.fd)
+
+
+def load_chunks(paths):
+    """DATA payloads: chunk header, city and zone names, up to CHUNK_RECORDS records."""
+    chunks = []
+    records = 0
+    for path in paths:
+        with open(path, "rb") as source:
+            raw = source.read()
+        magic, version, count = struct.unpack_from("<IHH", raw)
+        if magic != RECORD_FILE_MAGIC or version != 1 or len(raw) != 72 + count * RECORD_SIZE:
+            sys.exit(f"{path}: not a schedule_gen --records file")
+        city = raw[8:8 + NAME_LENGTH].split(b"\0")[0]
+        zone = raw[8 + NAME_LENGTH:8 + 2 * NAME_LENGTH].split(b"\0")[0]
+        for start in range(0, count, CHUNK_RECORDS):
+            batch = raw[72 + start * RECORD_SIZE:72 + min(count, start + CHUNK_RECORDS) * RECORD_SIZE]
+            chunks.append(struct.pack("<BBBB", len(city), len(zone), len(batch) // RECORD_SIZE, 0) +
+                          city + zone + batch)
+        records += count
+    if len(chunks) > 0xFFFF:
+        sys.exit("too many records for one session, send the files in smaller groups")
+    return chunks, records
+
+
+class Uploader:
+    def __init__(self, link, chunks):
+        self.link = link
+        self.chunks = chunks
+        self.reader = FrameReader()
+        self.retransmits = 0
+        self.timeouts = 0
+
+    def frames(self, timeout):
+        return self.reader.feed(self.link.read(timeout))
+
+    def wait_for_text(self, marker, timeout):
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            self.frames(0.1)
+            if marker in self.reader.text:
+                self.reader.text.clear()
+                return True
+        return False
+
+    def begin(self, session_id):
+        payload = struct.pack("<IHH", session_id, PROTOCOL_VERSION, len(self.chunks))
+        for _ in range(RETRY_LIMIT):
+            self.link.write(encode_frame(BEGIN, 0, payload))
+            deadline = time.monotonic() + ACK_TIMEOUT * 2
+            while time.monotonic() < deadline:
+                for frame_type, _, body in self.frames(0.2):
+                    if frame_type == READY:
+                        _, resume, window_end, chunk_records, _ = struct.unpack("<IHHHH", body)
+                        if chunk_records < CHUNK_RECORDS:
+                            sys.exit(f"device takes {chunk_records} records per chunk, {CHUNK_RECORDS} needed")
+                        return resume, window_end
+                    if frame_type == ABORT:
+                        sys.exit("device refused the session (protocol version)")
+        sys.exit("no READY from the device")
+
+    def send(self, base, window_end):
+        """Go-back-N until every chunk is acknowledged."""
+        count = len(self.chunks)
+        following = base
+        silent = 0
+        while base < count:
+            while following < min(window_end, count):
+                self.link.write(encode_frame(DATA, following, self.chunks[following]))
+                following += 1
+            replies = [frame for frame in self.frames(ACK_TIMEOUT) if frame[0] in (ACK, NAK, ABORT)]
+            if not replies:
+                # Chunks are acknowledged as they arrive, so silence with some in flight means they were lost.
+                # With none in flight the device is still storing and opens the window itself.
+                silent += 1
+                if silent > RETRY_LIMIT:
+                    sys.exit(f"device stopped answering at chunk {base} of {count}")
+                if following > base:
+                    self.timeouts += 1
+                    self.retransmits += following - base
+                    following = base
+                continue
+            silent = 0
+            for frame_type, sequence, body in replies:
+                if frame_type == ABORT:
+                    sys.exit("device ended the session")
+                window_end, _ = struct.unpack("<HH", body)
+                base = max(base, sequence)
+                if frame_type == NAK and sequence < following:
+                    self.retransmits += following - sequence
+                    following = sequence
+        return window_end
+
+    def finish(self):
+        count = len(self.chunks)
+        for _ in range(RETRY_LIMIT):
+            self.link.write(encode_frame(END, count))
+            deadline = time.monotonic() + ACK_TIMEOUT * 5
+            while time.monotonic() < deadline:
+                for frame_type, sequence, body in self.frames(0.2):
+                    if frame_type == ACK:
+                        deadline = time.monotonic() + ACK_TIMEOUT * 5  # Still storing the last window
+                    if frame_type == DONE:
+                        return dict(zip(STATS_FIELDS, struct.unpack("<10I", body)))
+                    if frame_type == NAK and sequence < count:
+                        return sequence
+            self.timeouts += 1
+        sys.exit("no DONE from the device")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", help="SPP serial port, e.g. /dev/rfcomm0 or COM7")
+    parser.add_argument("files", nargs="+", help="<city>-<yyyy>.days files from schedule_gen --records")
+    args = parser.parse_args()
+
+    chunks, records = load_chunks(args.files)
+    session_id = zlib.crc32(b"".join(chunks)) ^ len(chunks)
+    link = Link(args.port)
+    uploader = Uploader(link, chunks)
+
+    link.write(b"upload\n")
+    if not uploader.wait_for_text(b"UPLOAD READY", READY_TIMEOUT):
+        sys.exit("device did not enter upload mode (busy, or an older firmware)")
+    started = time.monotonic()
+    resume, window_end = uploader.begin(session_id)
+    if resume:
+        print(f"resuming at chunk {resume} of {len(chunks)}")
+
+    base = resume
+    while True:
+        window_end = uploader.send(base, window_end)
+        result = uploader.finish()
+        if isinstance(result, dict):
+            break
+        base = result  # The device is missing chunks after all
+    elapsed = time.monotonic() - started
+
+    sent = len(chunks) - resume
+    print(f"sent {sent} chunks ({records} records in {len(args.files)} files), {link.sent} bytes in "
+          f"{elapsed:.1f} s: {link.sent / 1024 / elapsed:.1f} KB/s, {result['records'] / elapsed:.0f} records/s")
+    print(f"retransmitted {uploader.retransmits} chunks after {uploader.timeouts} timeouts")
+    print(f"device: {result['stored']} stored, {result['unchanged']} unchanged, {result['skipped']} skipped, "
+          f"{result['rejected']} rejected; {result['crc_errors']} bad frames, {result['out_of_order']} out of "
+          f"order, {result['duplicates']} duplicates")
+    link.close()
+
+
+if __name__ == "__main__":
+    main()
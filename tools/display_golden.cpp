@@ -0,0 +1,205 @@
+/*
+ * Golden image test for the display layouts (include/display_layouts.h).
+ *
+ * Renders the clock, alert and status screens with fixed values into the
+ * firmware's framebuffer and compares each frame, as plain PBM, byte for
+ * byte with tools/fixtures/display/<name>.pbm. A mismatch reports the first
+ * differing row and leaves the new frame in <name>.actual.pbm next to the
+ * golden file for a look with any image viewer.
+ *
+ * It also checks the dirty tracking the flush relies on: redrawing an
+ * unchanged clock dirties nothing, and drawing the next second over the
+ * previous one gives exactly the frame a fresh draw does.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++17 -O2 -Iinclude tools/display_golden.cpp src/display_layouts.cpp src/framebuffer.cpp -o display_golden
+ *   ./display_golden              (compare)
+ *   ./display_golden --update     (rewrite the golden files after an intended layout change)
+ */
+
+#include "display_layouts.h"
+#include "framebuffer.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+static const char* const GOLDEN_DIR = "tools/fixtures/display";
+
+struct Scene {
+  const char* name;
+  void (*draw)();
+};
+
+static const ClockScreen clockScreen = {"18/10/2026 GMT+7", "12:34", "56", "Nganjuk", "Asr in 02:41:09",
+                                        "WiFi:on BT:-- SD:ok"};
+
+static void drawClockScene() {
+  drawClockScreen(clockScreen);
+}
+
+// Longest values each line can hold, and the no-schedule fallback
+static void drawClockLongScene() {
+  ClockScreen screen = {"31/12/2026 GMT+5:45", "23:59", "59", "Kota Administrasi Jak", "No schedule",
+                        "WiFi:-- BT:on SD:--"};
+  drawClockScreen(screen);
+}
+
+static void drawAlertStartScene() {
+  drawAlertScreen("Maghrib", "Prayer time");
+  drawAlertProgress(0, 10000);
+}
+
+static void drawAlertMidScene() {
+  drawAlertScreen("Maghrib", "Prayer time");
+  drawAlertProgress(6300, 10000);
+}
+
+static void drawWarningScene() {
+  drawAlertScreen("Isha", "in 10 minutes");
+  drawAlertProgress(1200, 5000);
+}
+
+static void drawStatusOkScene() {
+  drawStatusScreen(StatusScreen{true, true, true, true});
+}
+
+static void drawStatusErrorScene() {
+  drawStatusScreen(StatusScreen{false, false, false, false});
+}
+
+static const Scene scenes[] = {
+  {"clock", drawClockScene},
+  {"clock_long", drawClockLongScene},
+  {"alert_start", drawAlertStartScene},
+  {"alert_mid", drawAlertMidScene},
+  {"warning", drawWarningScene},
+  {"status_ok", drawStatusOkScene},
+  {"status_error", drawStatusErrorScene},
+};
+
+static void appendToString(const uint8_t* data, size_t length, void* context) {
+  static_cast<std::string*>(context)->append(reinterpret_cast<const char*>(data), length);
+}
+
+// Plain P1 so a layout change shows up as a readable text diff in review
+static std::string renderScene(const Scene& scene) {
+  fbClear();
+  scene.draw();
+  std::string pbm;
+  fbWritePbm(appendToString, &pbm, true);
+  return pbm;
+}
+
+static bool readFile(const std::string& path, std::string& data) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file) return false;
+  char buffer[4096];
+  size_t length;
+  data.clear();
+  while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.append(buffer, length);
+  }
+  fclose(file);
+  return true;
+}
+
+static bool writeFile(const std::string& path, const std::string& data) {
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file) return false;
+  bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+  return fclose(file) == 0 && ok;
+}
+
+// Line number of the first difference (header lines count), 0 if none
+static int firstDifferentLine(const std::string& a, const std::string& b) {
+  int line = 1;
+  for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+    if (a[i] != b[i]) return line;
+    if (a[i] == '\n') line++;
+  }
+  return a.size() == b.size() ? 0 : line;
+}
+
+static bool checkDirtyTracking() {
+  bool ok = true;
+  fbClear();
+  drawClockScreen(clockScreen);
+  fbMarkClean();
+  drawClockScreen(clockScreen);
+  for (int page = 0; page < FRAMEBUFFER_PAGES; page++) {
+    int first, last;
+    if (fbPageDirty(page, first, last)) {
+      printf("FAIL  redraw of an unchanged clock dirtied page %d, columns %d-%d\n", page, first, last);
+      ok = false;
+    }
+  }
+
+  // The next second drawn over the last one must leave nothing stale behind
+  ClockScreen next = clockScreen;
+  next.seconds = "57";
+  next.nextLine = "Asr in 02:41:08";
+  fbMarkClean();
+  drawClockScreen(next);
+  int dirtyBytes = 0;
+  for (int page = 0; page < FRAMEBUFFER_PAGES; page++) {
+    int first, last;
+    if (fbPageDirty(page, first, last)) dirtyBytes += last - first + 1;
+  }
+  uint8_t overdrawn[FRAMEBUFFER_SIZE];
+  memcpy(overdrawn, fbData(), sizeof(overdrawn));
+  fbClear();
+  drawClockScreen(next);
+  if (memcmp(overdrawn, fbData(), sizeof(overdrawn)) != 0) {
+    printf("FAIL  next second drawn over the last differs from a fresh draw\n");
+    ok = false;
+  }
+  printf("%s  clock tick flushes %d of %d bytes\n", ok ? "ok  " : "FAIL", dirtyBytes, FRAMEBUFFER_SIZE);
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  bool update = argc > 1 && strcmp(argv[1], "--update") == 0;
+  if (argc > 2 || (argc == 2 && !update)) {
+    fprintf(stderr, "usage: %s [--update]   (run from the repository root)\n", argv[0]);
+    return 2;
+  }
+
+  int failures = 0;
+  for (const Scene& scene : scenes) {
+    std::string path = std::string(GOLDEN_DIR) + "/" + scene.name + ".pbm";
+    std::string actual = renderScene(scene);
+    if (update) {
+      if (!writeFile(path, actual)) {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        return 1;
+      }
+      printf("wrote %s\n", path.c_str());
+      continue;
+    }
+
+    std::string golden;
+    if (!readFile(path, golden)) {
+      printf("FAIL  %-13s no golden file %s (run with --update)\n", scene.name, path.c_str());
+      failures++;
+      continue;
+    }
+    int line = firstDifferentLine(golden, actual);
+    if (line == 0) {
+      printf("ok    %s\n", scene.name);
+      continue;
+    }
+    std::string actualPath = std::string(GOLDEN_DIR) + "/" + scene.name + ".actual.pbm";
+    writeFile(actualPath, actual);
+    printf("FAIL  %-13s differs from line %d of %s, frame written to %s\n", scene.name, line, path.c_str(),
+           actualPath.c_str());
+    failures++;
+  }
+
+  if (!update && !checkDirtyTracking()) {
+    failures++;
+  }
+  if (failures) {
+    printf("%d failed\n", failures);
+  }
+  return failures ? 1 : 0;
+}
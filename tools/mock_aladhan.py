@@ -0,0 +1,241 @@
+"""
+Local stand-in for api.aladhan.com used by the esp32dev-mock build.
+
+Serves the API-shaped response in tools/fixtures/timingsByCity.json for any
+date (date fields are rewritten to match the request), plus month
+calendars built from it. HTTP/1.1 keep-alive and pipelined requests are
+handled in order, like the real API.
+
+Fault injection, set on the command line or at runtime through
+GET /__mock/faults?name=value&...:
+
+  latency   fixed delay before each response, ms
+  jitter    extra random delay, 0..jitter ms
+  drip      send the body at this many bytes per second (0 = off)
+  truncate  probability of closing mid-body after a full Content-Length
+  error     probability of a 429 / 500 / 503 reply
+  reset     probability of an abortive close (TCP RST) before replying
+  chunked   1 = Transfer-Encoding: chunked instead of Content-Length
+  gzip      1 = gzip bodies for clients sending Accept-Encoding: gzip (default)
+
+GET /__mock/stats returns request and fault counters as JSON.
+
+Usage:
+  python tools/mock_aladhan.py --port 8080 --latency 150 --error 0.05
+"""
+
+import argparse
+import copy
+import datetime
+import gzip
+import json
+import os
+import random
+import socket
+import struct
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+FIXTURE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "fixtures", "timingsByCity.json")
+
+FAULT_DEFAULTS = {
+    "latency": 0.0,
+    "jitter": 0.0,
+    "drip": 0.0,
+    "truncate": 0.0,
+    "error": 0.0,
+    "reset": 0.0,
+    "chunked": 0.0,
+    "gzip": 1.0,
+}
+
+faults = dict(FAULT_DEFAULTS)
+counters = {"requests": 0, "connections": 0, "errors": 0, "resets": 0, "truncated": 0,
+            "gzip": 0, "body_bytes": 0, "wire_bytes": 0}
+counters_lock = threading.Lock()
+rng = random.Random()
+recorded_day = None
+
+
+def count(name, amount=1):
+    with counters_lock:
+        counters[name] += amount
+
+
+def day_response(date, city):
+    """Recorded day with its date fields moved to the requested date."""
+    day = copy.deepcopy(recorded_day["data"])
+    gregorian = day["date"]["gregorian"]
+    gregorian["date"] = date.strftime("%d-%m-%Y")
+    gregorian["day"] = date.strftime("%d")
+    gregorian["weekday"]["en"] = date.strftime("%A")
+    gregorian["month"] = {"number": date.month, "en": date.strftime("%B")}
+    gregorian["year"] = str(date.year)
+    day["date"]["readable"] = date.strftime("%d %b %Y")
+    epoch = datetime.datetime(date.year, date.month, date.day, tzinfo=datetime.timezone.utc)
+    day["date"]["timestamp"] = str(int(epoch.timestamp()))
+    day["meta"]["city"] = city
+    return day
+
+
+def parse_date_key(key):
+    return datetime.datetime.strptime(key, "%d-%m-%Y").date()
+
+
+class MockAladhanHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    server_version = "MockAladhan/1.0"
+
+    def setup(self):
+        super().setup()
+        count("connections")
+
+    def log_message(self, fmt, *args):
+        if self.server.verbose:
+            super().log_message(fmt, *args)
+
+    def do_GET(self):
+        count("requests")
+        url = urlparse(self.path)
+        query = {key: values[-1] for key, values in parse_qs(url.query).items()}
+
+        if url.path == "/__mock/faults":
+            for name, value in query.items():
+                if name in faults:
+                    faults[name] = float(value)
+            self.send_json(200, faults, inject=False)
+            return
+        if url.path == "/__mock/stats":
+            with counters_lock:
+                snapshot = dict(counters)
+            self.send_json(200, snapshot, inject=False)
+            return
+
+        delay = faults["latency"] + rng.uniform(0, faults["jitter"])
+        if delay > 0:
+            time.sleep(delay / 1000.0)
+
+        if rng.random() < faults["reset"]:
+            count("resets")
+            self.abort_connection()
+            return
+        if rng.random() < faults["error"]:
+            count("errors")
+            status = rng.choice([429, 500, 503])
+            self.send_json(status, {"code": status, "status": "Injected failure"},
+                           extra_headers={"Retry-After": "1"} if status == 429 else None)
+            return
+
+        parts = [part for part in url.path.split("/") if part]
+        city = query.get("city", "Nganjuk")
+        try:
+            if len(parts) == 3 and parts[:2] == ["v1", "timingsByCity"]:
+                body = {"code": 200, "status": "OK", "data": day_response(parse_date_key(parts[2]), city)}
+            elif len(parts) >= 2 and parts[:2] == ["v1", "calendarByCity"]:
+                year = int(parts[2]) if len(parts) > 2 else int(query["year"])
+                month = int(parts[3]) if len(parts) > 3 else int(query["month"])
+                first = datetime.date(year, month, 1)
+                days = []
+                while first.month == month:
+                    days.append(day_response(first, city))
+                    first += datetime.timedelta(days=1)
+                body = {"code": 200, "status": "OK", "data": days}
+            else:
+                self.send_json(404, {"code": 404, "status": "Not Found"})
+                return
+        except (KeyError, ValueError):
+            self.send_json(400, {"code": 400, "status": "Bad Request"})
+            return
+
+        self.send_json(200, body)
+
+    def send_json(self, status, body, extra_headers=None, inject=True):
+        # Control endpoints pass inject=False so they stay reachable under faults
+        payload = json.dumps(body, ensure_ascii=False, separators=(",", ":")).encode("utf-8")
+        chunked = inject and faults["chunked"] >= 1
+        truncate = inject and status == 200 and rng.random() < faults["truncate"]
+        compress = inject and faults["gzip"] >= 1 and "gzip" in self.headers.get("Accept-Encoding", "")
+        if inject:
+            count("body_bytes", len(payload))
+        if compress:
+            count("gzip")
+            payload = gzip.compress(payload, mtime=0)
+
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        if compress:
+            self.send_header("Content-Encoding", "gzip")
+            self.send_header("Vary", "Accept-Encoding")
+        if chunked:
+            self.send_header("Transfer-Encoding", "chunked")
+        else:
+            self.send_header("Content-Length", str(len(payload)))
+        for name, value in (extra_headers or {}).items():
+            self.send_header(name, value)
+        self.end_headers()
+
+        if truncate:
+            count("truncated")
+            payload = payload[:len(payload) // 2]
+        if inject:
+            count("wire_bytes", len(payload))
+        if chunked:
+            self.write_body(b"%X\r\n" % len(payload) + payload + b"\r\n")
+            if not truncate:
+                self.write_body(b"0\r\n\r\n")
+        else:
+            self.write_body(payload)
+
+        if truncate:
+            self.abort_connection()
+
+    def write_body(self, data):
+        rate = faults["drip"]
+        if rate <= 0:
+            self.wfile.write(data)
+            return
+        step = max(1, int(rate / 10))
+        for start in range(0, len(data), step):
+            self.wfile.write(data[start:start + step])
+            self.wfile.flush()
+            time.sleep(step / rate)
+
+    def abort_connection(self):
+        # SO_LINGER with a zero timeout makes close() send RST instead of FIN
+        self.wfile.flush()
+        self.connection.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack("ii", 1, 0))
+        self.close_connection = True
+        self.connection.close()
+
+
+def main():
+    global recorded_day
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--seed", type=int, default=None, help="Fixed seed for repeatable fault patterns")
+    parser.add_argument("--verbose", action="store_true", help="Log every request")
+    for name in FAULT_DEFAULTS:
+        parser.add_argument("--" + name, type=float, default=FAULT_DEFAULTS[name])
+    args = parser.parse_args()
+
+    with open(FIXTURE, encoding="utf-8") as handle:
+        recorded_day = json.load(handle)
+    for name in FAULT_DEFAULTS:
+        faults[name] = getattr(args, name)
+    rng.seed(args.seed)
+
+    server = ThreadingHTTPServer((args.host, args.port), MockAladhanHandler)
+    server.daemon_threads = True
+    server.verbose = args.verbose
+    print("Mock Aladhan API on %s:%d, faults %s" % (args.host, args.port, faults))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,770 @@
+/*
+ * Host schedule generator for provisioning SD cards and flash images.
+ *
+ * Builds the same cache the firmware fills from the Aladhan API, for many
+ * cities and years at once, so units can ship with their schedules instead
+ * of fetching them on first boot. Uses the firmware's own formats
+ * (include/cache_format.h, include/civil_date.h, include/tz_table.h):
+ *
+ *   SD tree    /<city>/<yyyy>/<mm>/<dd-mm-yyyy>.json with the CRC trailer,
+ *              plus /<city>/<yyyy>/manifest.bin, as savePrayerTimesToSD()
+ *              and the manifest code write them
+ *   Flash tier /<city>.bin slot tables for the LittleFS partition, packed
+ *              into an image with mklittlefs when --littlefs-image is given
+ *   Records    <city>-<yyyy>.days, compact records (include/bulk_protocol.h)
+ *              that tools/bt_upload.py pushes to a device over Bluetooth
+ *
+ * Times are computed with the PrayTimes algorithm the API uses (Kemenag
+ * angles by default, PRAYER_METHOD 20): Fajr 20 deg, Isha 18 deg, Asr at
+ * shadow factor 1, Maghrib at sunset, angle-based high latitude rule. The
+ * kernel works on a whole year per city in structure-of-arrays form so the
+ * compiler vectorises the trig (libmvec with -ffast-math); work items
+ * (city, year) are spread over all cores. --import takes published
+ * timetables instead of computing them.
+ *
+ * Input: a CSV of cities, "name,latitude,longitude,IANA zone" per line
+ * (zones from include/tz_table.h; DST rules are applied per day).
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++17 -O3 -march=native -ffast-math -Iinclude tools/schedule_gen.cpp -o schedule_gen -pthread
+ *   (add -fopt-info-vec to see the two solar loops reported as vectorized)
+ *   ./schedule_gen --cities cities.csv --years 2026-2027 --sd out/sd
+ *   ./schedule_gen --cities cities.csv --years 2026 --flash out/data --flash-from 01-01-2026 \
+ *       --littlefs-image out/littlefs.bin
+ *   ./schedule_gen --cities cities.csv --years 2026 --records out/records   (for tools/bt_upload.py)
+ *   ./schedule_gen --verify response.json --tolerance 2        (against a saved API reply)
+ *   ./schedule_gen --synthetic 5000 --years 2026-2035          (throughput only)
+ *
+ * Other options: --threads N, --import times.csv (city,dd-mm-yyyy,Fajr,
+ * Sunrise,Dhuhr,Asr,Maghrib,Isha as HH:MM).
+ */
+
+#include "bulk_protocol.h"
+#include "cache_format.h"
+#include "civil_date.h"
+#include "config.h"
+#include "tz_table.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static_assert(sizeof(DaySchedule) == 24 && sizeof(FlashTierHeader) == 40, "Flash tier layout must match the ESP32");
+static_assert(offsetof(CacheManifest, checksums) == 60 && sizeof(CacheManifest) == 1528,
+              "Manifest layout must match the ESP32");
+
+#define FAJR_ANGLE 20.0          // Kemenag (method 20)
+#define ISHA_ANGLE 18.0
+#define ASR_SHADOW_FACTOR 1.0    // Standard (Shafi'i) school
+#define RISE_SET_ANGLE 0.833     // Refraction plus solar radius
+#define LITTLEFS_PARTITION_SIZE 0xF0000  // spiffs partition in huge_app.csv
+
+struct City {
+  std::string name;
+  double latitude;
+  double longitude;
+  const TzEntry* zone;
+};
+
+// --- Time zones: standard offset plus the POSIX DST rule from tz_table.h ---
+
+struct TzTransition {
+  int month, week, weekday;
+  int minutes;                   // Local time of the change, may exceed 24 h
+};
+
+struct TzRule {
+  int standardMinutes;           // East of UTC
+  int daylightMinutes;
+  bool hasDaylight;
+  TzTransition start, end;
+};
+
+static const char* skipTzName(const char* p) {
+  if (*p == '<') {
+    while (*p && *p != '>') p++;
+    return *p ? p + 1 : p;
+  }
+  while (*p && ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z'))) p++;
+  return p;
+}
+
+// "[+-]h[:mm]" to minutes
+static const char* parseTzTime(const char* p, int& minutes) {
+  int sign = 1;
+  if (*p == '+' || *p == '-') sign = *p++ == '-' ? -1 : 1;
+  int hours = (int)strtol(p, const_cast<char**>(&p), 10);
+  int mins = 0;
+  if (*p == ':') mins = (int)strtol(p + 1, const_cast<char**>(&p), 10);
+  minutes = sign * (hours * 60 + mins);
+  return p;
+}
+
+static const char* parseTzTransition(const char* p, TzTransition& transition) {
+  if (*p != 'M') return nullptr;
+  transition.month = (int)strtol(p + 1, const_cast<char**>(&p), 10);
+  transition.week = (int)strtol(p + 1, const_cast<char**>(&p), 10);
+  transition.weekday = (int)strtol(p + 1, const_cast<char**>(&p), 10);
+  transition.minutes = 120;
+  if (*p == '/') p = parseTzTime(p + 1, transition.minutes);
+  return p;
+}
+
+static TzRule parseTzRule(const TzEntry& zone) {
+  TzRule rule = {zone.offsetMinutes, zone.offsetMinutes, false, {}, {}};
+  const char* p = parseTzTime(skipTzName(zone.posix), rule.standardMinutes);
+  rule.standardMinutes = -rule.standardMinutes;  // POSIX offsets are west of UTC
+  if (*p == '\0') return rule;
+
+  p = skipTzName(p);
+  rule.daylightMinutes = rule.standardMinutes + 60;
+  if (*p && *p != ',') {
+    p = parseTzTime(p, rule.daylightMinutes);
+    rule.daylightMinutes = -rule.daylightMinutes;
+  }
+  if (*p == ',' && (p = parseTzTransition(p + 1, rule.start)) && *p == ',' &&
+      parseTzTransition(p + 1, rule.end)) {
+    rule.hasDaylight = true;
+  } else {
+    fprintf(stderr, "warning: unsupported DST rule for %s, using standard time\n", zone.name);
+  }
+  return rule;
+}
+
+// Day number of the w-th (5 = last) weekday d of a month
+static int32_t transitionDay(int year, const TzTransition& transition) {
+  int32_t first = daysFromCivil(year, transition.month, 1);
+  int firstWeekday = (int)((first + 4) % 7);  // 1970-01-01 was a Thursday
+  int day = 1 + (transition.weekday - firstWeekday + 7) % 7 + (transition.week - 1) * 7;
+  while (day > daysInMonth(year, transition.month)) day -= 7;
+  return daysFromCivil(year, transition.month, day);
+}
+
+// Offset in force at local noon of the day; prayer times never fall on the switch hour
+static int utcOffsetForDay(const TzRule& rule, int year, int32_t dayNumber) {
+  if (!rule.hasDaylight) return rule.standardMinutes;
+  int64_t noon = (int64_t)dayNumber * 1440 + 720;  // Local standard time
+  int64_t start = (int64_t)transitionDay(year, rule.start) * 1440 + rule.start.minutes;
+  int64_t end = (int64_t)transitionDay(year, rule.end) * 1440 + rule.end.minutes -
+                (rule.daylightMinutes - rule.standardMinutes);
+  bool daylight = start < end ? (noon >= start && noon < end) : (noon >= start || noon < end);
+  return daylight ? rule.daylightMinutes : rule.standardMinutes;
+}
+
+static const TzEntry* findZone(const char* name) {
+  for (const TzEntry& entry : tzEntries) {
+    if (strcmp(entry.name, name) == 0) return &entry;
+  }
+  return nullptr;
+}
+
+// --- Solar kernel ---
+
+enum TimeIndex { T_FAJR, T_SUNRISE, T_DHUHR, T_ASR, T_SUNSET, T_ISHA, T_COUNT };
+
+// A year of one city in structure-of-arrays form
+struct YearBatch {
+  int days;
+  double julian[CACHE_DAYS_PER_YEAR];      // Julian day at 0h local, longitude corrected
+  double zoneHours[CACHE_DAYS_PER_YEAR];   // UTC offset of each day
+  double times[T_COUNT][CACHE_DAYS_PER_YEAR];
+};
+
+static constexpr double DEG = M_PI / 180.0;
+// Marks an event the sun never reaches; NaN checks do not survive -ffast-math
+static constexpr double NO_TIME = 1e9;
+
+static inline bool isNoTime(double hours) { return hours > NO_TIME / 2; }
+
+static inline double fixAngle(double a) { return a - 360.0 * std::floor(a / 360.0); }
+static inline double fixHour(double h) { return h - 24.0 * std::floor(h / 24.0); }
+
+// GCC folds sin(x) and cos(x) of one argument into sincos (__builtin_cexpi),
+// a complex result the vectoriser rejects; the phase shift keeps them apart
+static inline double cosine(double x) { return std::sin(x + M_PI / 2); }
+
+// Declination (degrees) and equation of time (hours), USNO low-precision formulas
+static inline void sunPosition(double jd, double& declination, double& equation) {
+  double d = jd - 2451545.0;
+  double g = fixAngle(357.529 + 0.98560028 * d) * DEG;
+  double q = fixAngle(280.459 + 0.98564736 * d);
+  double l = (q + 1.915 * std::sin(g) + 0.020 * std::sin(2 * g)) * DEG;
+  double e = (23.439 - 0.00000036 * d) * DEG;
+  double ra = fixHour(std::atan2(cosine(e) * std::sin(l), cosine(l)) / DEG / 15.0);
+  declination = std::asin(std::sin(e) * std::sin(l)) / DEG;
+  equation = q / 15.0 - ra;
+}
+
+// Solar noon and, for angle events, the hour angle; one branch-free pass over the year.
+// angle > 0 is below the horizon; asr selects the shadow-length form.
+static void sunAngleTimes(YearBatch& batch, double latitude, TimeIndex index, double guessHours, double angle,
+                          bool beforeNoon, bool asr) {
+  const double sinLat = std::sin(latitude * DEG);
+  const double cosLat = std::cos(latitude * DEG);
+  double* out = batch.times[index];
+  const double* julian = batch.julian;
+#pragma GCC ivdep
+  for (int d = 0; d < batch.days; d++) {
+    double declination, equation;
+    sunPosition(julian[d] + guessHours / 24.0, declination, equation);
+    double noon = fixHour(12.0 - equation);
+    double altitude = asr ? std::atan(1.0 / (ASR_SHADOW_FACTOR + std::tan(std::fabs(latitude - declination) * DEG)))
+                          : -angle * DEG;
+    double cosHour = (std::sin(altitude) - sinLat * std::sin(declination * DEG)) / (cosLat * cosine(declination * DEG));
+    bool reached = cosHour >= -1.0 && cosHour <= 1.0;
+    double hourAngle = std::acos(std::fmin(std::fmax(cosHour, -1.0), 1.0)) / DEG / 15.0;
+    out[d] = reached ? noon + (beforeNoon ? -hourAngle : hourAngle) : NO_TIME;
+  }
+}
+
+static void solarNoons(YearBatch& batch, double guessHours) {
+  double* out = batch.times[T_DHUHR];
+#pragma GCC ivdep
+  for (int d = 0; d < batch.days; d++) {
+    double declination, equation;
+    sunPosition(batch.julian[d] + guessHours / 24.0, declination, equation);
+    out[d] = fixHour(12.0 - equation);
+  }
+}
+
+static double julianDay(int year, int month, int day) {
+  if (month <= 2) {
+    year -= 1;
+    month += 12;
+  }
+  double a = std::floor(year / 100.0);
+  double b = 2 - a + std::floor(a / 4.0);
+  return std::floor(365.25 * (year + 4716)) + std::floor(30.6001 * (month + 1)) + day + b - 1524.5;
+}
+
+struct DayTimes {
+  uint16_t minutes[T_COUNT];   // After local midnight; 0xFFFF where the sun does not rise or set
+  int16_t utcOffsetMinutes;
+};
+
+static uint16_t roundToMinute(double hours) {
+  if (isNoTime(hours)) return 0xFFFF;
+  return (uint16_t)(std::floor(fixHour(hours + 0.5 / 60.0) * 60.0)) % 1440;
+}
+
+// Same passes as PrayTimes computeTimes() with one iteration from the default guesses
+static void computeYear(const City& city, const TzRule& rule, int year, YearBatch& batch, DayTimes* out) {
+  batch.days = isLeapYear(year) ? 366 : 365;
+  int32_t firstDay = daysFromCivil(year, 1, 1);
+  double firstJulian = julianDay(year, 1, 1) - city.longitude / (15.0 * 24.0);
+  for (int d = 0; d < batch.days; d++) {
+    batch.julian[d] = firstJulian + d;
+    out[d].utcOffsetMinutes = (int16_t)utcOffsetForDay(rule, year, firstDay + d);
+    batch.zoneHours[d] = out[d].utcOffsetMinutes / 60.0;
+  }
+
+  sunAngleTimes(batch, city.latitude, T_FAJR, 5, FAJR_ANGLE, true, false);
+  sunAngleTimes(batch, city.latitude, T_SUNRISE, 6, RISE_SET_ANGLE, true, false);
+  solarNoons(batch, 12);
+  sunAngleTimes(batch, city.latitude, T_ASR, 13, 0, false, true);
+  sunAngleTimes(batch, city.latitude, T_SUNSET, 18, RISE_SET_ANGLE, false, false);
+  sunAngleTimes(batch, city.latitude, T_ISHA, 18, ISHA_ANGLE, false, false);
+
+  const double longitudeHours = city.longitude / 15.0;
+  for (int d = 0; d < batch.days; d++) {
+    double t[T_COUNT];
+    for (int i = 0; i < T_COUNT; i++) {
+      t[i] = batch.times[i][d] + batch.zoneHours[d] - longitudeHours;
+    }
+    // Angle-based rule: Fajr and Isha no further from sunrise/sunset than angle/60 of the night
+    double night = fixHour(t[T_SUNRISE] - t[T_SUNSET]);
+    if (!isNoTime(t[T_SUNRISE]) && !isNoTime(t[T_SUNSET])) {
+      double fajrLimit = FAJR_ANGLE / 60.0 * night;
+      if (isNoTime(t[T_FAJR]) || fixHour(t[T_SUNRISE] - t[T_FAJR]) > fajrLimit) t[T_FAJR] = t[T_SUNRISE] - fajrLimit;
+      double ishaLimit = ISHA_ANGLE / 60.0 * night;
+      if (isNoTime(t[T_ISHA]) || fixHour(t[T_ISHA] - t[T_SUNSET]) > ishaLimit) t[T_ISHA] = t[T_SUNSET] + ishaLimit;
+    }
+
+    for (int i = 0; i < T_COUNT; i++) {
+      out[d].minutes[i] = roundToMinute(t[i]);
+    }
+  }
+}
+
+// --- Output ---
+
+struct Totals {
+  std::atomic<uint64_t> cityYears{0};
+  std::atomic<uint64_t> days{0};
+  std::atomic<uint64_t> files{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> skippedDays{0};
+};
+
+static Totals totals;
+
+static void formatClock(char* out, int minutes) {
+  minutes = ((minutes % 1440) + 1440) % 1440;
+  snprintf(out, 6, "%02d:%02d", minutes / 60, minutes % 60);
+}
+
+static bool writeBytes(const fs::path& path, const void* data, size_t length) {
+  FILE* file = fopen(path.string().c_str(), "wb");
+  if (file == nullptr) {
+    perror(path.string().c_str());
+    return false;
+  }
+  bool ok = fwrite(data, 1, length, file) == length;
+  ok &= fclose(file) == 0;
+  totals.files++;
+  totals.bytes += length;
+  return ok;
+}
+
+static DaySchedule toDaySchedule(const DayTimes& day, int32_t dayNumber) {
+  static const int order[PRAYER_COUNT] = {T_FAJR, T_SUNRISE, T_DHUHR, T_ASR, T_SUNSET, T_ISHA};
+  DaySchedule schedule;
+  memset(&schedule, 0, sizeof(schedule));
+  schedule.dayNumber = dayNumber;
+  for (int i = 0; i < PRAYER_COUNT; i++) {
+    schedule.minutes[i] = day.minutes[order[i]];
+  }
+  schedule.utcOffsetMinutes = day.utcOffsetMinutes;
+  schedule.crc = dayScheduleCrc(schedule);
+  return schedule;
+}
+
+static bool writeSdYear(const fs::path& root, const City& city, int year, const DayTimes* days) {
+  CacheManifest manifest;
+  memset(&manifest, 0, sizeof(manifest));
+  manifest.magic = CACHE_MANIFEST_MAGIC;
+  manifest.version = CACHE_MANIFEST_VERSION;
+  manifest.year = year;
+
+  fs::path yearDir = root / city.name / std::to_string(year);
+  int count = isLeapYear(year) ? 366 : 365;
+  for (int index = 0; index < count; index++) {
+    const DayTimes& day = days[index];
+    if (day.minutes[T_SUNRISE] == 0xFFFF || day.minutes[T_SUNSET] == 0xFFFF) {
+      totals.skippedDays++;  // Polar day or night: left for the API
+      continue;
+    }
+    CivilDate date = addDays(CivilDate{(int16_t)year, 1, 1}, index);
+    char path[CACHE_PATH_LENGTH];
+    if (formatCachePath(path, sizeof(path), city.name.c_str(), date) == 0) {
+      fprintf(stderr, "%s: city name too long for cache paths\n", city.name.c_str());
+      return false;
+    }
+    fs::path file = root / (path + 1);
+    if (!(manifest.monthDirs & (1 << (date.month - 1)))) {
+      fs::create_directories(file.parent_path());
+      manifest.monthDirs |= 1 << (date.month - 1);
+    }
+
+    char body[DAY_JSON_LENGTH + CACHE_TRAILER_LENGTH + 1];
+    size_t length = formatDayScheduleJson(body, DAY_JSON_LENGTH, toDaySchedule(day, daysFromCivil(date)),
+                                          city.zone->name);
+    uint32_t crc = cacheCrc32(reinterpret_cast<const uint8_t*>(body), length);
+    formatCacheTrailer(body + length, length, crc);
+    if (!writeBytes(file, body, length + CACHE_TRAILER_LENGTH)) return false;
+
+    manifest.dayBits[index >> 3] |= 1 << (index & 7);
+    manifest.cachedDays++;
+    manifest.checksums[index] = crc;
+  }
+  manifest.crc = cacheManifestCrc(manifest);
+  fs::create_directories(yearDir);
+  return writeBytes(yearDir / CACHE_MANIFEST_FILE, &manifest, sizeof(manifest));
+}
+
+// Compact records of one city and year for tools/bt_upload.py
+static bool writeRecordYear(const fs::path& root, const City& city, int year, const DayTimes* days) {
+  BulkRecordFileHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = BULK_RECORD_FILE_MAGIC;
+  header.version = BULK_RECORD_FILE_VERSION;
+  snprintf(header.city, sizeof(header.city), "%s", city.name.c_str());
+  snprintf(header.zone, sizeof(header.zone), "%s", city.zone->name);
+
+  std::vector<DaySchedule> records;
+  int32_t firstDay = daysFromCivil(year, 1, 1);
+  int count = isLeapYear(year) ? 366 : 365;
+  for (int index = 0; index < count; index++) {
+    if (days[index].minutes[T_SUNRISE] != 0xFFFF && days[index].minutes[T_SUNSET] != 0xFFFF) {
+      records.push_back(toDaySchedule(days[index], firstDay + index));
+    }
+  }
+  header.count = (uint16_t)records.size();
+
+  std::string content(reinterpret_cast<const char*>(&header), sizeof(header));
+  content.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(DaySchedule));
+  fs::create_directories(root);
+  return writeBytes(root / (city.name + "-" + std::to_string(year) + ".days"), content.data(), content.size());
+}
+
+// --- Work items ---
+
+struct Options {
+  std::vector<City> cities;
+  int firstYear = 0;
+  int lastYear = 0;
+  int threads = 0;
+  fs::path sdRoot;
+  fs::path flashRoot;
+  fs::path littlefsImage;
+  fs::path recordsRoot;
+  int32_t flashFrom = 0;
+  std::string importPath;
+};
+
+// Imported timetables, keyed by city then day number
+static std::map<std::string, std::map<int32_t, DayTimes>> imported;
+
+// Fills the flash tier window while years are produced; written once all are done
+struct FlashTier {
+  std::mutex lock;
+  std::vector<std::vector<DaySchedule>> slots;   // Per city
+};
+
+static FlashTier flashTier;
+
+static bool inFlashWindow(const Options& options, int32_t dayNumber) {
+  return dayNumber >= options.flashFrom && dayNumber < options.flashFrom + FLASH_TIER_SLOTS;
+}
+
+static bool produceCityYear(const Options& options, size_t cityIndex, int year, YearBatch& batch) {
+  const City& city = options.cities[cityIndex];
+  DayTimes days[CACHE_DAYS_PER_YEAR];
+  int count = isLeapYear(year) ? 366 : 365;
+  int32_t firstDay = daysFromCivil(year, 1, 1);
+
+  if (options.importPath.empty()) {
+    TzRule rule = parseTzRule(*city.zone);
+    computeYear(city, rule, year, batch, days);
+  } else {
+    // Workers share the map, so only look up; a city without rows has no data
+    static const std::map<int32_t, DayTimes> noRows;
+    const auto& cities = imported;
+    auto entry = cities.find(city.name);
+    const std::map<int32_t, DayTimes>& source = entry != cities.end() ? entry->second : noRows;
+    for (int d = 0; d < count; d++) {
+      auto found = source.find(firstDay + d);
+      if (found != source.end()) {
+        days[d] = found->second;
+      } else {
+        memset(&days[d], 0xFF, sizeof(DayTimes));
+      }
+    }
+  }
+  totals.days += count;
+
+  if (!options.sdRoot.empty() && !writeSdYear(options.sdRoot, city, year, days)) {
+    return false;
+  }
+  if (!options.recordsRoot.empty() && !writeRecordYear(options.recordsRoot, city, year, days)) {
+    return false;
+  }
+  if (!options.flashRoot.empty()) {
+    std::lock_guard<std::mutex> guard(flashTier.lock);
+    for (int d = 0; d < count; d++) {
+      if (inFlashWindow(options, firstDay + d) && days[d].minutes[T_SUNRISE] != 0xFFFF) {
+        int slot = (int)(((firstDay + d) % FLASH_TIER_SLOTS + FLASH_TIER_SLOTS) % FLASH_TIER_SLOTS);
+        flashTier.slots[cityIndex][slot] = toDaySchedule(days[d], firstDay + d);
+      }
+    }
+  }
+  totals.cityYears++;
+  return true;
+}
+
+static bool writeFlashTier(const Options& options) {
+  fs::create_directories(options.flashRoot);
+  for (size_t i = 0; i < options.cities.size(); i++) {
+    FlashTierHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = FLASH_TIER_MAGIC;
+    header.version = FLASH_TIER_VERSION;
+    header.slotCount = FLASH_TIER_SLOTS;
+    snprintf(header.city, sizeof(header.city), "%s", options.cities[i].name.c_str());
+
+    std::string content(reinterpret_cast<const char*>(&header), sizeof(header));
+    content.append(reinterpret_cast<const char*>(flashTier.slots[i].data()), FLASH_TIER_SLOTS * sizeof(DaySchedule));
+    if (!writeBytes(options.flashRoot / (options.cities[i].name + ".bin"), content.data(), content.size())) {
+      return false;
+    }
+  }
+  if (options.littlefsImage.empty()) {
+    return true;
+  }
+  // Same packer PlatformIO uses for "buildfs"; block and page sizes of the ESP32 port
+  std::string command = "mklittlefs -c \"" + options.flashRoot.string() + "\" -b 4096 -p 256 -s " +
+                        std::to_string(LITTLEFS_PARTITION_SIZE) + " \"" + options.littlefsImage.string() + "\"";
+  if (system(command.c_str()) != 0) {
+    fprintf(stderr, "mklittlefs failed (is it on PATH? PlatformIO ships it in tool-mklittlefs)\n");
+    return false;
+  }
+  return true;
+}
+
+// --- Input ---
+
+static bool parseClock(const char* text, uint16_t& minutes) {
+  if (strlen(text) < 5 || text[2] != ':') return false;
+  minutes = (uint16_t)(atoi(text) * 60 + atoi(text + 3));
+  return true;
+}
+
+static bool loadCities(const char* path, std::vector<City>& cities) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    perror(path);
+    return false;
+  }
+  char line[256];
+  int lineNumber = 0;
+  while (fgets(line, sizeof(line), file)) {
+    lineNumber++;
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '\0' || line[0] == '#') continue;
+    char name[MAX_CITY_NAME_LENGTH + 1];
+    char zone[64];
+    City city;
+    if (sscanf(line, "%32[^,],%lf,%lf,%63s", name, &city.latitude, &city.longitude, zone) != 4 ||
+        (city.zone = findZone(zone)) == nullptr) {
+      fprintf(stderr, "%s:%d: expected name,latitude,longitude,zone from tz_table.h\n", path, lineNumber);
+      fclose(file);
+      return false;
+    }
+    city.name = name;
+    cities.push_back(city);
+  }
+  fclose(file);
+  return true;
+}
+
+static bool loadImport(const Options& options) {
+  FILE* file = fopen(options.importPath.c_str(), "r");
+  if (file == nullptr) {
+    perror(options.importPath.c_str());
+    return false;
+  }
+  char line[256];
+  int lineNumber = 0;
+  while (fgets(line, sizeof(line), file)) {
+    lineNumber++;
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '\0' || line[0] == '#') continue;
+    char name[MAX_CITY_NAME_LENGTH + 1], key[16], t[T_COUNT][8];
+    CivilDate date;
+    DayTimes day;
+    // Maghrib is taken as sunset, as in the computed path
+    bool ok = sscanf(line, "%32[^,],%15[^,],%7[^,],%7[^,],%7[^,],%7[^,],%7[^,],%7s", name, key, t[T_FAJR],
+                     t[T_SUNRISE], t[T_DHUHR], t[T_ASR], t[T_SUNSET], t[T_ISHA]) == 8 && parseDateKey(key, date);
+    for (int i = 0; ok && i < T_COUNT; i++) ok = parseClock(t[i], day.minutes[i]);
+    const City* city = nullptr;
+    for (const City& candidate : options.cities) {
+      if (candidate.name == name) city = &candidate;
+    }
+    if (!ok || city == nullptr) {
+      fprintf(stderr, "%s:%d: expected a known city,dd-mm-yyyy and six HH:MM times\n",
+              options.importPath.c_str(), lineNumber);
+      fclose(file);
+      return false;
+    }
+    TzRule rule = parseTzRule(*city->zone);
+    day.utcOffsetMinutes = (int16_t)utcOffsetForDay(rule, date.year, daysFromCivil(date));
+    imported[city->name][daysFromCivil(date)] = day;
+  }
+  fclose(file);
+  return true;
+}
+
+// Cities spread over the inhabited latitudes, for throughput runs without output
+static void syntheticCities(int count, std::vector<City>& cities) {
+  const TzEntry* utc = findZone("UTC");
+  for (int i = 0; i < count; i++) {
+    City city;
+    city.name = "City" + std::to_string(i);
+    city.latitude = -55.0 + 115.0 * ((i * 0.618034) - std::floor(i * 0.618034));
+    city.longitude = -180.0 + 360.0 * ((i * 0.414214) - std::floor(i * 0.414214));
+    city.zone = utc;
+    cities.push_back(city);
+  }
+}
+
+// Compares one recorded API response with the kernel; fails beyond `tolerance` minutes
+static int verifyFixture(const char* path, int tolerance) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    perror(path);
+    return 1;
+  }
+  std::string json;
+  char buffer[4096];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) json.append(buffer, count);
+  fclose(file);
+
+  auto field = [&](const char* key) -> const char* {
+    size_t at = json.find(std::string("\"") + key + "\":");
+    if (at == std::string::npos) return nullptr;
+    at += strlen(key) + 3;
+    return json.c_str() + at + (json[at] == '"' ? 1 : 0);
+  };
+  const char* meta = field("meta");
+  const char* gregorian = field("gregorian");
+  CivilDate date;
+  City city;
+  char zone[64] = "";
+  if (meta == nullptr || gregorian == nullptr || !parseDateKey(gregorian + 9, date) ||
+      sscanf(meta, "{\"latitude\":%lf,\"longitude\":%lf,\"timezone\":\"%63[^\"]", &city.latitude, &city.longitude,
+             zone) != 3 || (city.zone = findZone(zone)) == nullptr) {
+    fprintf(stderr, "%s: not an Aladhan timingsByCity response\n", path);
+    return 1;
+  }
+
+  static YearBatch batch;
+  DayTimes days[CACHE_DAYS_PER_YEAR];
+  computeYear(city, parseTzRule(*city.zone), date.year, batch, days);
+  const DayTimes& day = days[dayOfYearIndex(date)];
+
+  static const char* const keys[T_COUNT] = {"Fajr", "Sunrise", "Dhuhr", "Asr", "Maghrib", "Isha"};
+  static const int index[T_COUNT] = {T_FAJR, T_SUNRISE, T_DHUHR, T_ASR, T_SUNSET, T_ISHA};
+  int worst = 0;
+  printf("%04d-%02d-%02d at %.4f, %.4f (%s)\n", date.year, date.month, date.day, city.latitude, city.longitude,
+         zone);
+  for (int i = 0; i < T_COUNT; i++) {
+    uint16_t expected;
+    const char* value = field(keys[i]);
+    if (value == nullptr || !parseClock(value, expected)) {
+      fprintf(stderr, "%s: missing %s\n", path, keys[i]);
+      return 1;
+    }
+    char computed[6];
+    formatClock(computed, day.minutes[index[i]]);
+    int difference = (int)day.minutes[index[i]] - expected;
+    worst = std::max(worst, std::abs(difference));
+    printf("  %-8s api %.5s  computed %s  %+d min\n", keys[i], value, computed, difference);
+  }
+  printf("worst difference %d min (tolerance %d)\n", worst, tolerance);
+  return worst <= tolerance ? 0 : 3;
+}
+
+static void usage(const char* program) {
+  fprintf(stderr,
+          "usage: %s (--cities FILE | --synthetic N) --years YYYY[-YYYY] [--sd DIR] [--flash DIR]\n"
+          "          [--flash-from dd-mm-yyyy] [--littlefs-image FILE] [--records DIR] [--import FILE]\n"
+          "          [--threads N]\n"
+          "       %s --verify response.json [--tolerance MINUTES]\n",
+          program, program);
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  int synthetic = 0;
+  const char* citiesPath = nullptr;
+  const char* verifyPath = nullptr;
+  int tolerance = 2;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (value == nullptr) {
+      usage(argv[0]);
+      return 2;
+    }
+    i++;
+    if (strcmp(arg, "--verify") == 0) {
+      verifyPath = value;
+    } else if (strcmp(arg, "--tolerance") == 0) {
+      tolerance = atoi(value);
+    } else if (strcmp(arg, "--cities") == 0) {
+      citiesPath = value;
+    } else if (strcmp(arg, "--synthetic") == 0) {
+      synthetic = atoi(value);
+    } else if (strcmp(arg, "--years") == 0) {
+      if (sscanf(value, "%d-%d", &options.firstYear, &options.lastYear) < 2) options.lastYear = options.firstYear;
+    } else if (strcmp(arg, "--sd") == 0) {
+      options.sdRoot = value;
+    } else if (strcmp(arg, "--flash") == 0) {
+      options.flashRoot = value;
+    } else if (strcmp(arg, "--records") == 0) {
+      options.recordsRoot = value;
+    } else if (strcmp(arg, "--littlefs-image") == 0) {
+      options.littlefsImage = value;
+    } else if (strcmp(arg, "--flash-from") == 0) {
+      CivilDate date;
+      if (!parseDateKey(value, date)) {
+        fprintf(stderr, "--flash-from: expected dd-mm-yyyy\n");
+        return 2;
+      }
+      options.flashFrom = daysFromCivil(date);
+    } else if (strcmp(arg, "--import") == 0) {
+      options.importPath = value;
+    } else if (strcmp(arg, "--threads") == 0) {
+      options.threads = atoi(value);
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (verifyPath != nullptr) return verifyFixture(verifyPath, tolerance);
+  if (citiesPath != nullptr && !loadCities(citiesPath, options.cities)) return 1;
+  syntheticCities(synthetic, options.cities);
+  if (options.cities.empty() || !isValidDate(CivilDate{(int16_t)options.firstYear, 1, 1}) ||
+      !isValidDate(CivilDate{(int16_t)options.lastYear, 1, 1}) || options.lastYear < options.firstYear) {
+    usage(argv[0]);
+    return 2;
+  }
+  if (!options.importPath.empty() && !loadImport(options)) return 1;
+  if (!options.flashRoot.empty()) {
+    if (options.flashFrom == 0) options.flashFrom = daysFromCivil(options.firstYear, 1, 1);
+    flashTier.slots.assign(options.cities.size(), std::vector<DaySchedule>(FLASH_TIER_SLOTS));
+    for (std::vector<DaySchedule>& slots : flashTier.slots) memset(slots.data(), 0, slots.size() * sizeof(DaySchedule));
+  }
+  if (!options.littlefsImage.empty() && options.flashRoot.empty()) {
+    fprintf(stderr, "--littlefs-image needs --flash DIR for the files it packs\n");
+    return 2;
+  }
+
+  // One work item per (city, year), claimed with a shared counter
+  int years = options.lastYear - options.firstYear + 1;
+  size_t items = options.cities.size() * years;
+  int threads = options.threads > 0 ? options.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+  std::atomic<size_t> next(0);
+  std::atomic<bool> failed(false);
+  Clock::time_point started = Clock::now();
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&]() {
+      static thread_local YearBatch batch;
+      size_t item;
+      while (!failed.load() && (item = next.fetch_add(1)) < items) {
+        if (!produceCityYear(options, item / years, options.firstYear + (int)(item % years), batch)) {
+          failed.store(true);
+        }
+      }
+    });
+  }
+  for (std::thread& worker : workers) worker.join();
+  if (failed.load() || (!options.flashRoot.empty() && !writeFlashTier(options))) return 1;
+  double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+  printf("%llu city-years (%zu cities x %d years, %llu days) on %d threads in %.3f s: %.0f city-years/s\n",
+         (unsigned long long)totals.cityYears.load(), options.cities.size(), years,
+         (unsigned long long)totals.days.load(), threads, seconds, totals.cityYears.load() / seconds);
+  if (totals.files.load() > 0) {
+    printf("wrote %llu files, %.1f MB\n", (unsigned long long)totals.files.load(), totals.bytes.load() / 1048576.0);
+  }
+  if (totals.skippedDays.load() > 0) {
+    printf("%llu polar days left out (no sunrise or sunset)\n", (unsigned long long)totals.skippedDays.load());
+  }
+  return 0;
+}
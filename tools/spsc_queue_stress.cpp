@@ -0,0 +1,178 @@
+/*
+ * Host stress test for the lock-free event queue (include/spsc_queue.h).
+ *
+ * Runs SpscQueue the way the firmware does, with real threads in place of
+ * the two cores, and checks every item for order and for torn copies:
+ *
+ *   edges     one thread: empty pop, full push (counted in dropped()),
+ *             then many fill/drain cycles so the indices wrap around
+ *   pair      one producer, one consumer on a tiny queue, so both the
+ *             full and the empty edge are hit constantly
+ *   per-core  two producers, each with its own queue, drained in turn by
+ *             one consumer: the shape to use when a second producer appears
+ *
+ * Items are 64 bytes derived from their sequence number, so a slot read
+ * before the producer finished writing it shows up as a mismatch even
+ * without ThreadSanitizer.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++17 -O1 -g -fsanitize=thread -Iinclude tools/spsc_queue_stress.cpp -o spsc_queue_stress -pthread
+ *   ./spsc_queue_stress [items per producer, default 1000000]
+ */
+
+#include "spsc_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+struct Item {
+  uint32_t sequence;
+  uint32_t words[15];
+};
+
+static Item makeItem(uint32_t sequence) {
+  Item item;
+  item.sequence = sequence;
+  for (uint32_t i = 0; i < 15; i++) {
+    item.words[i] = (sequence + 1) * 2654435761UL ^ (i * 0x9E3779B9UL);
+  }
+  return item;
+}
+
+static bool validItem(const Item& item, uint32_t expected) {
+  if (item.sequence != expected) return false;
+  Item reference = makeItem(expected);
+  for (uint32_t i = 0; i < 15; i++) {
+    if (item.words[i] != reference.words[i]) return false;
+  }
+  return true;
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+  if (!condition && failures++ < 10) {
+    fprintf(stderr, "FAIL: %s\n", what);
+  }
+}
+
+template <size_t Capacity>
+static void testEdges() {
+  SpscQueue<Item, Capacity> queue;
+  Item item;
+  check(!queue.pop(item), "pop from an empty queue");
+  check(queue.size() == 0, "empty size");
+
+  uint32_t pushed = 0;
+  uint32_t popped = 0;
+  for (int cycle = 0; cycle < 1000; cycle++) {
+    // Fill to capacity(), then one more push must be refused
+    while (queue.size() < queue.capacity()) {
+      check(queue.push(makeItem(pushed++)), "push below capacity");
+    }
+    check(queue.size() == queue.capacity(), "full size");
+    check(!queue.push(makeItem(pushed)), "push into a full queue");
+
+    // Drain part of it on odd cycles, so the wrap point moves around the ring
+    size_t drain = (cycle & 1) ? queue.capacity() / 2 + 1 : queue.capacity();
+    for (size_t i = 0; i < drain; i++) {
+      check(queue.pop(item) && validItem(item, popped++), "pop in order after wraparound");
+    }
+  }
+  while (queue.pop(item)) {
+    check(validItem(item, popped++), "final drain in order");
+  }
+  check(popped == pushed, "every pushed item popped");
+  check(queue.dropped() == 1000, "refused pushes counted in dropped()");
+  check(queue.peak() == queue.capacity(), "peak depth");
+  printf("edges     capacity %zu: %u items, %u refused pushes\n", queue.capacity(), pushed, queue.dropped());
+}
+
+template <size_t Capacity>
+static void produce(SpscQueue<Item, Capacity>& queue, uint32_t count, uint32_t& fullHits) {
+  for (uint32_t sequence = 0; sequence < count; sequence++) {
+    Item item = makeItem(sequence);
+    while (!queue.push(item)) {
+      fullHits++;
+      std::this_thread::yield();
+    }
+  }
+}
+
+static void testPair(uint32_t count) {
+  SpscQueue<Item, 4> queue;
+  uint32_t fullHits = 0;
+  uint32_t emptyHits = 0;
+  uint32_t bad = 0;
+  std::thread producer(produce<4>, std::ref(queue), count, std::ref(fullHits));
+
+  uint32_t expected = 0;
+  Item item;
+  while (expected < count) {
+    if (!queue.pop(item)) {
+      emptyHits++;
+      std::this_thread::yield();
+      continue;
+    }
+    if (!validItem(item, expected)) bad++;
+    expected++;
+    // size() from the consumer side stays within the ring
+    check(queue.size() <= queue.capacity(), "size within capacity");
+  }
+  producer.join();
+
+  check(bad == 0, "pair: items in order and intact");
+  check(!queue.pop(item), "pair: queue empty at the end");
+  check(queue.dropped() == fullHits, "pair: dropped() counts every full push");
+  check(fullHits > 0 && emptyHits > 0, "pair: both edges exercised");
+  printf("pair      capacity %zu: %u items, %u full, %u empty, %u bad\n", queue.capacity(), count, fullHits,
+         emptyHits, bad);
+}
+
+static void testPerCore(uint32_t count) {
+  SpscQueue<Item, 16> queues[2];
+  uint32_t fullHits[2] = {0, 0};
+  std::thread producers[2] = {
+    std::thread(produce<16>, std::ref(queues[0]), count, std::ref(fullHits[0])),
+    std::thread(produce<16>, std::ref(queues[1]), count, std::ref(fullHits[1]))
+  };
+
+  uint32_t expected[2] = {0, 0};
+  uint32_t bad = 0;
+  Item item;
+  while (expected[0] < count || expected[1] < count) {
+    // Like dispatchSystemEvents(): drain each queue in turn
+    for (int core = 0; core < 2; core++) {
+      while (queues[core].pop(item)) {
+        if (!validItem(item, expected[core])) bad++;
+        expected[core]++;
+      }
+    }
+    std::this_thread::yield();
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+
+  check(bad == 0, "per-core: items in order and intact");
+  check(expected[0] == count && expected[1] == count, "per-core: every item delivered");
+  printf("per-core  capacity %zu x 2: %u items, %u + %u full, %u bad\n", queues[0].capacity(), 2 * count,
+         fullHits[0], fullHits[1], bad);
+}
+
+int main(int argc, char** argv) {
+  uint32_t count = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 10) : 1000000;
+  if (count == 0) {
+    fprintf(stderr, "usage: %s [items per producer]\n", argv[0]);
+    return 2;
+  }
+
+  testEdges<2>();
+  testEdges<8>();
+  testEdges<64>();
+  testPair(count);
+  testPerCore(count);
+
+  printf(failures ? "%d checks FAILED\n" : "all checks passed\n", failures);
+  return failures ? 1 : 0;
+}